@@ -0,0 +1,74 @@
+#include "ActiveButtons.hpp"
+#include <string.h>
+
+void ActiveButtons::beginTick() {
+    // Let go last tick, so they've had their one tick in the list
+    if (_falling != 0) {
+        uint8_t kept = 0;
+        for (uint8_t i = 0; i < _count; i++) {
+            if (!(_falling & (1 << _pressOrder[i]))) {
+                _pressOrder[kept++] = _pressOrder[i];
+            }
+        }
+        _count = kept;
+    }
+
+    _rising = 0;
+    _falling = 0;
+
+    for (Button *button : _buttons) {
+        if (button != nullptr) {
+            button->stabilizeState();
+        }
+    }
+}
+
+void ActiveButtons::update(uint8_t index, bool isPressed) {
+    if (_buttons[index] == nullptr) return;
+
+    _buttons[index]->update(isPressed);
+    noticeEdges(index);
+}
+
+void ActiveButtons::setPressed(uint8_t index, bool isPressed, unsigned long millis) {
+    if (_buttons[index] == nullptr) return;
+
+    _buttons[index]->setPressed(isPressed, millis);
+    noticeEdges(index);
+}
+
+void ActiveButtons::endTick(unsigned long nowMillis) {
+    for (Button *button : _buttons) {
+        if (button != nullptr) {
+            button->updateDoubleTap(nowMillis);
+        }
+    }
+}
+
+void ActiveButtons::noticeEdges(uint8_t index) {
+    Button &button = *_buttons[index];
+    uint16_t bit = 1 << index;
+
+    if (button.risingEdge() && !(_held & bit)) {
+        _held |= bit;
+        _rising |= bit;
+
+        // Pressed again in the same tick it was let go, so it moves to the back
+        for (uint8_t i = 0; i < _count; i++) {
+            if (_pressOrder[i] == index) {
+                memmove(&_pressOrder[i], &_pressOrder[i + 1], _count - i - 1);
+                _count--;
+                break;
+            }
+        }
+        _falling &= ~bit;
+
+        _pressOrder[_count++] = index;
+    }
+
+    // Stays in the stack until the next tick, so the release can be seen
+    if (button.fallingEdge() && (_held & bit)) {
+        _held &= ~bit;
+        _falling |= bit;
+    }
+}
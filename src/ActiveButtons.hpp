@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Button.h"
+
+// The buttons that are held down, or were let go this tick, in the order they
+// were pressed. Buttons are kept by index, a bit each in the held, rising and
+// falling masks, and the press order is a small stack that's only touched
+// when a button changes. Nothing's allocated or sorted from tick to tick.
+//
+// Each tick goes beginTick, then update or setPressed for whatever changed,
+// then endTick.
+class ActiveButtons {
+    public:
+        static const uint8_t MAX_BUTTONS = 16;
+
+        // Indexes without a button are left as nullptr
+        void setButton(uint8_t index, Button *button) { _buttons[index] = button; }
+
+        // Drops the buttons let go last tick and clears the edges
+        void beginTick();
+        // A raw sample, debounced by the button
+        void update(uint8_t index, bool isPressed);
+        // An edge that's already been debounced
+        void setPressed(uint8_t index, bool isPressed, unsigned long millis);
+        void endTick(unsigned long nowMillis);
+
+        // Oldest press first. The first is the base command and the second modifies it
+        uint8_t getCount() const { return _count; }
+        Button *get(uint8_t position) const { return _buttons[_pressOrder[position]]; }
+        Command getCommand(uint8_t position) const { return get(position)->getCommand(); }
+
+        // A bit per button index
+        uint16_t getHeld() const { return _held; }
+        uint16_t getRising() const { return _rising; }
+        uint16_t getFalling() const { return _falling; }
+
+    private:
+        // Keeps the stack and masks up to date with whatever the button just did
+        void noticeEdges(uint8_t index);
+
+        Button *_buttons[MAX_BUTTONS] = {};
+        uint8_t _pressOrder[MAX_BUTTONS];
+        uint8_t _count = 0;
+
+        uint16_t _held = 0;
+        uint16_t _rising = 0;
+        uint16_t _falling = 0;
+};
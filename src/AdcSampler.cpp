@@ -0,0 +1,86 @@
+#include "AdcSampler.hpp"
+
+#if defined(ARDUINO_ARCH_RP2040)
+#include <hardware/adc.h>
+#include <hardware/dma.h>
+#include <hardware/timer.h>
+
+const uint ADC_FIRST_PIN = 26;
+#endif
+
+void AdcSampler::addSample(uint8_t channel, uint16_t sample) {
+    Cic &filter = _filters[channel];
+    filter.integrator1 += sample;
+    filter.integrator2 += filter.integrator1;
+
+    if (++filter.sampleCount < DECIMATION) return;
+    filter.sampleCount = 0;
+
+    uint32_t comb1 = filter.integrator2 - filter.lastIntegrator2;
+    uint32_t comb2 = comb1 - filter.lastComb1;
+    filter.lastIntegrator2 = filter.integrator2;
+    filter.lastComb1 = comb1;
+
+    _readings[channel] = min(comb2 >> OUTPUT_SHIFT, 0xffffu);
+}
+
+#if defined(ARDUINO_ARCH_RP2040)
+void AdcSampler::begin() {
+    adc_init();
+    for (uint8_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+        adc_gpio_init(ADC_FIRST_PIN + channel);
+    }
+
+    adc_set_round_robin((1 << CHANNEL_COUNT) - 1);
+    adc_fifo_setup(true, true, 1, false, false); // DREQ on every sample, no error bit
+    adc_set_clkdiv(48000000 / SAMPLE_HZ - 1); // The ADC runs from 48MHz
+
+    _dmaChannel = dma_claim_unused_channel(true);
+    restart();
+}
+
+// Empties everything out and starts from channel 0 at the top of the ring,
+// so the channels can be told apart by order again
+void AdcSampler::restart() {
+    adc_run(false);
+    dma_channel_abort(_dmaChannel);
+    adc_fifo_drain();
+    adc_select_input(0);
+
+    dma_channel_config config = dma_channel_get_default_config(_dmaChannel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, true);
+    channel_config_set_ring(&config, true, __builtin_ctz(sizeof(_ring)));
+    channel_config_set_dreq(&config, DREQ_ADC);
+    dma_channel_configure(_dmaChannel, &config, _ring, &adc_hw->fifo, dma_encode_endless_transfer_count(), true);
+
+    _readIndex = 0;
+    _nextChannel = 0;
+    _lastUpdateMicros = time_us_64();
+    adc_run(true);
+}
+
+void AdcSampler::update() {
+    uint64_t nowMicros = time_us_64();
+
+    // The DMA may have gone all the way round, and lost track of which channel's which
+    if (nowMicros - _lastUpdateMicros >= RING_MICROS) {
+        restart();
+        return;
+    }
+    _lastUpdateMicros = nowMicros;
+
+    uint16_t writeIndex = ((uintptr_t)dma_channel_hw_addr(_dmaChannel)->write_addr - (uintptr_t)_ring) / sizeof(uint16_t) % RING_SAMPLES;
+
+    while (_readIndex != writeIndex) {
+        addSample(_nextChannel, _ring[_readIndex] & 0xfff);
+        _readIndex = (_readIndex + 1) % RING_SAMPLES;
+        _nextChannel = (_nextChannel + 1) % CHANNEL_COUNT;
+    }
+}
+#else
+// There's no ADC off the board, samples come in through addSample
+void AdcSampler::begin() {}
+void AdcSampler::update() {}
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Compat.h"
+
+// Keeps the ADC converting A0, A1 and A2 in turn, as fast as it's clocked,
+// with DMA copying the results into a ring. Reading doesn't wait on a
+// conversion, it takes whatever's arrived since last time and runs it
+// through a decimating filter per channel. So the readings come at a fixed
+// rate with less noise, however often they're asked for.
+//
+// The filter is a second order CIC, two integrators then two combs at the
+// decimated rate, which averages DECIMATION samples twice over and keeps
+// the extra bits that gives.
+class AdcSampler {
+    public:
+        static const uint8_t CHANNEL_COUNT = 3;
+        static const uint32_t SAMPLE_HZ = 48000; // Across all the channels
+        static const uint16_t DECIMATION = 64; // Samples of a channel per reading, so 250 readings a second
+
+        // Starts the ADC and DMA, the ADC pins are taken over
+        void begin();
+
+        // Filters whatever's arrived since the last call
+        void update();
+
+        // 0 to 65535 over the ADC's range. Takes a few readings to settle after begin
+        uint16_t read(uint8_t channel) { return _readings[channel]; }
+
+        // One 12 bit sample of channel, straight from the ADC
+        void addSample(uint8_t channel, uint16_t sample);
+
+    private:
+        // 12 bits in, and the gain's DECIMATION squared, so this brings it to 16 bits
+        static const uint8_t OUTPUT_SHIFT = 12 + 12 - 16;
+
+        struct Cic {
+            // Left to wrap, the combs undo it
+            uint32_t integrator1 = 0;
+            uint32_t integrator2 = 0;
+            uint32_t lastIntegrator2 = 0;
+            uint32_t lastComb1 = 0;
+            uint16_t sampleCount = 0;
+        };
+
+        Cic _filters[CHANNEL_COUNT];
+        uint16_t _readings[CHANNEL_COUNT] = {};
+
+#if defined(ARDUINO_ARCH_RP2040)
+        // Enough for 85ms of samples, if it's not read for longer it starts over
+        static const uint16_t RING_SAMPLES = 4096;
+        static const uint32_t RING_MICROS = RING_SAMPLES * 1000000ull / SAMPLE_HZ;
+
+        void restart();
+
+        alignas(RING_SAMPLES * sizeof(uint16_t)) uint16_t _ring[RING_SAMPLES];
+        int _dmaChannel = -1;
+        uint16_t _readIndex = 0;
+        uint8_t _nextChannel = 0; // Of the sample at _readIndex
+        uint64_t _lastUpdateMicros = 0;
+#endif
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Compat.h"
+
+// An angle as a 16 bit fraction of a turn, so it wraps around by itself and
+// adding or subtracting never needs an fmod. 0 is up and it goes clockwise,
+// like the float degrees used elsewhere. sin and cos come from a table.
+class Angle {
+    public:
+        static const uint16_t QUARTER_TURN = 0x4000;
+        static const uint16_t HALF_TURN = 0x8000;
+
+        constexpr Angle() : _bam(0) {}
+
+        static constexpr Angle fromBam(uint16_t bam) { return Angle(bam); }
+        static Angle fromDegrees(float degrees) {
+            return Angle((uint16_t)(int32_t)lroundf(degrees * (65536.f / 360.f)));
+        }
+        // The angle whose sin and cos are in the ratio y to x. By CORDIC, so
+        // it's only shifts and adds, and good to a BAM or so
+        static Angle atan2(int32_t y, int32_t x);
+
+        uint16_t getBam() const { return _bam; }
+        float toDegrees() const { return _bam * (360.f / 65536.f); }
+
+        Angle operator+(Angle rhs) const { return Angle(_bam + rhs._bam); }
+        Angle operator-(Angle rhs) const { return Angle(_bam - rhs._bam); }
+        Angle &operator+=(Angle rhs) { _bam += rhs._bam; return *this; }
+        Angle &operator-=(Angle rhs) { _bam -= rhs._bam; return *this; }
+        bool operator==(Angle rhs) const { return _bam == rhs._bam; }
+        bool operator!=(Angle rhs) const { return _bam != rhs._bam; }
+
+        // The shortest way round to other, negative when it's anticlockwise
+        int16_t deltaTo(Angle other) const { return (int16_t)(other._bam - _bam); }
+        float degreesTo(Angle other) const { return deltaTo(other) * (360.f / 65536.f); }
+
+        // The nearest of divisions evenly spaced angles round the turn, counting from 0
+        uint16_t nearestDivision(uint16_t divisions) const {
+            return (((uint32_t)_bam * divisions + HALF_TURN) >> 16) % divisions;
+        }
+
+        // Q15, so 32767 is 1
+        int16_t sinQ15() const;
+        int16_t cosQ15() const { return Angle(_bam + QUARTER_TURN).sinQ15(); }
+
+        float sin() const { return sinQ15() * (1.f / 32767); }
+        float cos() const { return cosQ15() * (1.f / 32767); }
+
+    private:
+        constexpr explicit Angle(uint16_t bam) : _bam(bam) {}
+
+        uint16_t _bam;
+};
+
+// Part of the way from a to b, going the short way round
+inline Angle lerp(Angle a, Angle b, float t) {
+    return a + Angle::fromBam(lroundf(a.deltaTo(b) * t));
+}
@@ -1,7 +1,6 @@
 #pragma once
 
-#include <Arduino.h>
-#include <string>
+#include "Hal.hpp"
 
 #define DOUBLE_TAP_WINDOW_MS 200
 
@@ -22,23 +21,23 @@ enum Command {
     NOTHING
 };
 
-inline String toString(Command command) {
+inline const char *toString(Command command) {
     switch(command) {
-        case PITCH:    return String("Pitch ");
-        case SKIP:     return String("Skip  ");
-        case SELECT:   return String("Select");
-        case SLIDE:    return String("Slide ");
-        case PULSES:   return String("Pulses");
-        case GATEMODE: return String("Mode  ");
-        case CLONE:    return String("Clone ");
-        case MOVE:     return String("Move  ");
-        case DELETE:   return String("Delete");
-        case UNDO:     return String("Undo  ");
-        case REDO:     return String("Redo  ");
-        case ARP:      return String("Arp   ");
-        case QUANTIZER:return String("Quant ");
-        case NOTHING:  return String("None  ");
-        default:       return String("N/A   ");
+        case PITCH:    return "Pitch ";
+        case SKIP:     return "Skip  ";
+        case SELECT:   return "Select";
+        case SLIDE:    return "Slide ";
+        case PULSES:   return "Pulses";
+        case GATEMODE: return "Mode  ";
+        case CLONE:    return "Clone ";
+        case MOVE:     return "Move  ";
+        case DELETE:   return "Delete";
+        case UNDO:     return "Undo  ";
+        case REDO:     return "Redo  ";
+        case ARP:      return "Arp   ";
+        case QUANTIZER:return "Quant ";
+        case NOTHING:  return "None  ";
+        default:       return "N/A   ";
     }
 }
 
@@ -48,28 +47,33 @@ class Button {
             _command = command;
         }
 
+        // Takes a raw sample of the switch, and debounces it over the last 8
         void update(bool isPressed) {
-            _wasDoubleTapped = false;
-            _didDoubleTapWindowPass = false;
             _lastState = _state;
             _state = (_state << 1) + isPressed;
 
             if (!_isHeld && _lastState == 0b01111111 && _state == 0b11111111) { // Detect rising edge
-                _isHeld = true;
-                _isRisingEdge = true;
-                if (millis() - _lastActivation <= DOUBLE_TAP_WINDOW_MS) {
-                    _wasDoubleTapped = true;
-                    _isPrimedForDoubleTap = false;
-                }
-                
-                _lastActivation = millis();
-                _isPrimedForDoubleTap = !_wasDoubleTapped; 
+                press(getHal().getMillis());
             } else if (_isHeld && _lastState == 0b10000000 && _state == 0b00000000) { // Detect falling edge
-                _isHeld = false;
-                _isFallingEdge = true;
+                release();
+            }
+
+            updateDoubleTap(getHal().getMillis());
+        }
+
+        // Takes an edge that's already been debounced, from when it happened
+        void setPressed(bool isPressed, unsigned long millis) {
+            if (isPressed && !_isHeld) {
+                press(millis);
+            } else if (!isPressed && _isHeld) {
+                release();
             }
+        }
 
-            if (millis() - _lastActivation > DOUBLE_TAP_WINDOW_MS && _isPrimedForDoubleTap) {
+        // Notices the double tap window closing, which needs doing every
+        // tick whether the button changed or not
+        void updateDoubleTap(unsigned long nowMillis) {
+            if (nowMillis - _lastActivation > DOUBLE_TAP_WINDOW_MS && _isPrimedForDoubleTap) {
                 _didDoubleTapWindowPass = true;
                 _isPrimedForDoubleTap = false;
             }
@@ -83,6 +87,8 @@ class Button {
             _lastState = _state;
             _isRisingEdge = false;
             _isFallingEdge = false;
+            _wasDoubleTapped = false;
+            _didDoubleTapWindowPass = false;
         }
 
         bool held() {
@@ -115,6 +121,23 @@ class Button {
 
         Command _command;
     private:
+        void press(unsigned long millis) {
+            _isHeld = true;
+            _isRisingEdge = true;
+            if (millis - _lastActivation <= DOUBLE_TAP_WINDOW_MS) {
+                _wasDoubleTapped = true;
+                _isPrimedForDoubleTap = false;
+            }
+
+            _lastActivation = millis;
+            _isPrimedForDoubleTap = !_wasDoubleTapped;
+        }
+
+        void release() {
+            _isHeld = false;
+            _isFallingEdge = true;
+        }
+
         uint8_t _state = 0;
         uint8_t _lastState = 0;
         unsigned long _lastActivation = 0;
@@ -1,6 +1,6 @@
 #include "ArpButtonHandler.hpp"
 
-void ArpButtonHandler::handle(
+bool ArpButtonHandler::handle(
     UserInputState &userInputState, 
     UndoRedoManager &undoRedoManager, 
     SelectionState &selectionState
@@ -11,5 +11,8 @@ void ArpButtonHandler::handle(
         }
 
         undoRedoManager.saveUndoRedoSnapshot();
+        return true;
     }
+
+    return false;
 }
\ No newline at end of file
@@ -4,7 +4,7 @@
 
 class ArpButtonHandler : public IButtonHandler {
 public:
-    void handle(
+    bool handle(
         UserInputState &userInputState, 
         UndoRedoManager &undoRedoManager, 
         SelectionState &selectionState
@@ -1,19 +1,28 @@
 #include "GateModeButtonHandler.hpp"
 
-void GateModeButtonHandler::handle(
+bool GateModeButtonHandler::handle(
     UserInputState &userInputState, 
     UndoRedoManager &undoRedoManager, 
     SelectionState &selectionState
 ) {
     if (userInputState.getBaseButton().risingEdge()) {
         _isEditingGateMode = true;
+
+        // Start turning from the current gate mode
+        for (auto stage : selectionState.getAffectedStages()) {
+            stage->pulsePipsAngle = Angle::fromBam(stage->gateMode * Angle::QUARTER_TURN);
+        }
     }
 
     _foo += userInputState.getAngleDelta();
 
+    // The pips turn smoothly, the gate mode only changes when they pass a quarter
+    bool hasChangedGateMode = false;
     for (auto stage : selectionState.getAffectedStages()) {
-        stage->pulsePipsAngle = wrapDeg(stage->pulsePipsAngle + userInputState.getAngleDelta());
-        stage->gateMode = (GateMode)((int)round(wrapDeg(stage->pulsePipsAngle) / 90.f) % 4);
+        GateMode gateMode = stage->gateMode;
+        stage->pulsePipsAngle += Angle::fromDegrees(userInputState.getAngleDelta());
+        stage->gateMode = (GateMode)stage->pulsePipsAngle.nearestDivision(4);
+        hasChangedGateMode |= stage->gateMode != gateMode;
     }
 
     bool hasModified = (int)round(wrapDeg(_foo) / 90.f) % 4;
@@ -24,4 +33,6 @@ void GateModeButtonHandler::handle(
         }
         _isEditingGateMode = false;
     }
+
+    return hasChangedGateMode;
 }
\ No newline at end of file
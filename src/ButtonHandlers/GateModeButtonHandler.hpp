@@ -4,7 +4,7 @@
 
 class GateModeButtonHandler : public IButtonHandler {
 public:
-    void handle(
+    bool handle(
         UserInputState &userInputState,
         UndoRedoManager &undoRedoManager, 
         SelectionState &selectionState
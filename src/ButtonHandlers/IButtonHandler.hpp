@@ -1,6 +1,6 @@
 #pragma once
 
-#include "../Utils.h"
+#include "../utils.h"
 #include "../Sequence.h"
 #include "../UserInputState.hpp"
 #include "../UndoRedoManager.hpp"
@@ -10,7 +10,9 @@ class IButtonHandler {
 public:
     virtual ~IButtonHandler() = default;
 
-    virtual void handle(
+    // Returns whether it changed anything the sequence plays, the stages are
+    // changed through references so the sequence can't tell by itself
+    virtual bool handle(
         UserInputState &userInputState, 
         UndoRedoManager &undoRedoManager, 
         SelectionState &selectionState
@@ -1,6 +1,6 @@
 #include "PitchButtonHandler.hpp"
 
-void PitchButtonHandler::handle(
+bool PitchButtonHandler::handle(
     UserInputState &userInputState, 
     UndoRedoManager &undoRedoManager, 
     SelectionState &selectionState
@@ -9,9 +9,25 @@ void PitchButtonHandler::handle(
         _isEditingPitch = true;
     }
 
-    for (auto stage : selectionState.getAffectedStages()) {
-        float newVoltage = stage->getBaseOutput() + userInputState.getAngleDelta() / 360.f;
-        stage->setOutput(coerceInRange(newVoltage, 0, 1.9999));
+    bool hasChangedPitch = false;
+    if (userInputState.getModifierCommand() == QUANTIZER) {
+        // Transpose by degrees of the scale instead, one every 30 degrees
+        _transposeAngle += userInputState.getAngleDelta();
+        int transposeSteps = (int)(_transposeAngle / 30.f);
+        _transposeAngle -= transposeSteps * 30.f;
+
+        for (auto stage : selectionState.getAffectedStages()) {
+            int transpose = stage->transpose;
+            stage->transpose = coerceInRange(stage->transpose + transposeSteps, -MAX_TRANSPOSE, MAX_TRANSPOSE);
+            hasChangedPitch |= stage->transpose != transpose;
+        }
+    } else {
+        for (auto stage : selectionState.getAffectedStages()) {
+            float output = stage->getBaseOutput();
+            float newVoltage = output + userInputState.getAngleDelta() / 360.f;
+            stage->setOutput(coerceInRange(newVoltage, 0, 1.9999));
+            hasChangedPitch |= stage->getBaseOutput() != output;
+        }
     }
 
     _pitchChange += userInputState.getAngleDelta();
@@ -21,6 +37,9 @@ void PitchButtonHandler::handle(
             undoRedoManager.saveUndoRedoSnapshot();
         }
         _pitchChange = 0;
+        _transposeAngle = 0;
         _isEditingPitch = false;
     }
+
+    return hasChangedPitch;
 }
\ No newline at end of file
@@ -4,7 +4,7 @@
 
 class PitchButtonHandler : public IButtonHandler {
 public:
-    void handle(
+    bool handle(
         UserInputState &userInputState, 
         UndoRedoManager &undoRedoManager, 
         SelectionState &selectionState
@@ -13,6 +13,8 @@ public:
     bool shouldSuppressCursorRotation() const override { return true; };
     bool isEditingPitch() { return _isEditingPitch; }
 private:
+    static const int MAX_TRANSPOSE = 24; // Degrees either way
     float _pitchChange = 0; // Used to detect if the state has been mutated
+    float _transposeAngle = 0; // Turned so far towards the next transpose step
     bool _isEditingPitch = false;
 };
\ No newline at end of file
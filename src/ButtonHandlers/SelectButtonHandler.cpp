@@ -1,6 +1,6 @@
 #include "SelectButtonHandler.hpp"
 
-void SelectButtonHandler::handle(
+bool SelectButtonHandler::handle(
     UserInputState &userInputState, 
     UndoRedoManager &undoRedoManager, 
     SelectionState &selectionState
@@ -40,4 +40,7 @@ void SelectButtonHandler::handle(
             undoRedoManager.saveUndoRedoSnapshot();
         }
     }
+
+    // Selecting stages doesn't change what plays
+    return false;
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "ButtonScanner.hpp"
+
+#if defined(ARDUINO_ARCH_RP2040)
+#include <hardware/clocks.h>
+#include <hardware/irq.h>
+#include <hardware/timer.h>
+
+// The interrupt handler doesn't get any arguments
+static ButtonScanner *scanOwner = nullptr;
+
+// Counts y down through the channels, putting it on the select lines, waiting
+// for the mux to settle and shifting in the sense pin. 16 bits autopush a
+// scan, with the first channel sampled on top, then it idles so scans come
+// at a steady rate. Hand assembled, the build doesn't run pioasm:
+//
+//   .wrap_target
+//       set y, 15
+//   channel:
+//       mov pins, y [31]
+//       in pins, 1
+//       jmp y-- channel
+//       set x, 14
+//   idle:
+//       jmp x-- idle [29]
+//   .wrap
+static const uint16_t scanInstructions[] = {
+    0xe04f, // set y, 15
+    0xbf02, // mov pins, y [31]
+    0x4001, // in pins, 1
+    0x0081, // jmp y--, 1
+    0xe02e, // set x, 14
+    0x1d45, // jmp x--, 5 [29]
+};
+
+static const pio_program scanProgram = {
+    .instructions = scanInstructions,
+    .length = sizeof(scanInstructions) / sizeof(scanInstructions[0]),
+    .origin = -1,
+    .pio_version = 0,
+#if PICO_PIO_VERSION > 0
+    .used_gpio_ranges = 0,
+#endif
+};
+
+// 16 channels of 34 cycles, 15 idles of 30 and the two sets
+static const uint32_t SCAN_CYCLES = 16 * 34 + 15 * 30 + 2;
+#endif
+
+ButtonScanner::ButtonScanner(uint select0, uint select1, uint select2, uint select3, uint sensePin) {
+    _isSelectReversed = select0 > select3;
+    _selectBase = min(select0, select3);
+    _sensePin = sensePin;
+
+    int step = _isSelectReversed ? -1 : 1;
+    _areSelectsConsecutive = (int)select1 == (int)select0 + step
+        && (int)select2 == (int)select1 + step
+        && (int)select3 == (int)select2 + step;
+}
+
+// A button changes once it's been the other way for every scan in the history
+void ButtonScanner::addScan(uint16_t pressedChannels, uint64_t micros) {
+    _history[_historyIndex] = pressedChannels;
+    _historyIndex = (_historyIndex + 1) % DEBOUNCE_SCANS;
+    _scanCount++;
+
+    uint16_t pressedInAll = 0xffff;
+    uint16_t pressedInAny = 0;
+    for (uint16_t scan : _history) {
+        pressedInAll &= scan;
+        pressedInAny |= scan;
+    }
+
+    uint16_t changed = ((_debounced | pressedInAll) & pressedInAny) ^ _debounced;
+
+    while (changed != 0) {
+        uint8_t channel = __builtin_ctz(changed);
+        changed &= changed - 1;
+
+        // If the queue's full it's left as it was, and tried again next scan
+        bool isPressed = !(_debounced & (1 << channel));
+        if (_edges.push({micros, channel, isPressed})) {
+            _debounced ^= 1 << channel;
+        }
+    }
+}
+
+#if defined(ARDUINO_ARCH_RP2040)
+void ButtonScanner::begin() {
+    if (!_areSelectsConsecutive) {
+        panic("The button mux select lines have to be on consecutive pins");
+    }
+
+    scanOwner = this;
+
+    uint programOffset;
+    if (!pio_claim_free_sm_and_add_program(&scanProgram, &_pio, &_stateMachine, &programOffset)) {
+        panic("No free PIO state machine to scan the buttons");
+    }
+
+    for (uint pin = _selectBase; pin < _selectBase + 4; pin++) {
+        pio_gpio_init(_pio, pin);
+    }
+    pio_sm_set_consecutive_pindirs(_pio, _stateMachine, _selectBase, 4, true);
+    gpio_pull_up(_sensePin);
+
+    pio_sm_config config = pio_get_default_sm_config();
+    sm_config_set_wrap(&config, programOffset, programOffset + scanProgram.length - 1);
+    sm_config_set_out_pins(&config, _selectBase, 4);
+    sm_config_set_in_pins(&config, _sensePin);
+    sm_config_set_in_shift(&config, false, true, 16); // Left, so the last channel sampled ends up in bit 0
+    sm_config_set_fifo_join(&config, PIO_FIFO_JOIN_RX);
+    sm_config_set_clkdiv(&config, clock_get_hz(clk_sys) / (float)(SCAN_CYCLES * SCAN_HZ));
+    pio_sm_init(_pio, _stateMachine, programOffset, &config);
+
+    uint irqNum = pio_get_irq_num(_pio, 0);
+    pio_set_irqn_source_enabled(_pio, 0, pio_get_rx_fifo_not_empty_interrupt_source(_stateMachine), true);
+    irq_set_exclusive_handler(irqNum, &ButtonScanner::_onScanReady);
+    irq_set_enabled(irqNum, true);
+
+    pio_sm_set_enabled(_pio, _stateMachine, true);
+}
+
+void ButtonScanner::_onScanReady() {
+    ButtonScanner *scanner = scanOwner;
+    uint64_t nowMicros = time_us_64();
+
+    // More than one means the interrupt was held off, those finished a scan apart
+    uint level = pio_sm_get_rx_fifo_level(scanner->_pio, scanner->_stateMachine);
+    for (uint i = 0; i < level; i++) {
+        uint16_t samples = pio_sm_get(scanner->_pio, scanner->_stateMachine);
+
+        // Bit n is the sample taken with n on the select lines. The switches
+        // pull low, and reversed select lines pick the channel with its bits backwards
+        uint16_t pressedChannels = 0;
+        for (uint8_t selected = 0; selected < 16; selected++) {
+            if (samples & (1 << selected)) continue;
+
+            uint8_t channel = selected;
+            if (scanner->_isSelectReversed) {
+                channel = (selected & 1) << 3 | (selected & 2) << 1 | (selected & 4) >> 1 | (selected & 8) >> 3;
+            }
+            pressedChannels |= 1 << channel;
+        }
+
+        scanner->addScan(pressedChannels, nowMicros - (level - 1 - i) * (1000000 / SCAN_HZ));
+    }
+}
+#else
+// Nothing to scan off the board, scans come in through addScan
+void ButtonScanner::begin() {}
+#endif
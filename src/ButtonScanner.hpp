@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Compat.h"
+#include "SpscQueue.hpp"
+
+#if defined(ARDUINO_ARCH_RP2040)
+#include <hardware/pio.h>
+#endif
+
+// A button changing, once it's been debounced
+struct ButtonEdge {
+    uint64_t micros; // The scan that settled it
+    uint8_t channel; // On the mux
+    bool isPressed;
+};
+
+// Reads the buttons behind the switch mux without the CPU. A PIO state
+// machine steps the mux's select lines through all 16 channels and samples
+// each one, at a fixed rate whatever the cores are doing. Each scan lands in
+// an interrupt as a bitmask, which is debounced a whole mask at a time, and
+// any buttons that changed are queued up as edges for the sequencer loop.
+//
+// The select lines need to be on consecutive pins, in either order, for
+// PIO to drive them together. The switches pull the sense pin low.
+class ButtonScanner {
+    public:
+        static const uint16_t SCAN_HZ = 2000;
+        // Scans in a row a button has to agree on before it changes
+        static const uint8_t DEBOUNCE_SCANS = 8;
+
+        ButtonScanner(uint select0, uint select1, uint select2, uint select3, uint sensePin);
+
+        // Starts scanning. The interrupt fires on the core that calls this,
+        // which should be the sequencer core
+        void begin();
+
+        // Debounces one scan, a bit per channel set for the ones held down.
+        // Called from the interrupt on the board
+        void addScan(uint16_t pressedChannels, uint64_t micros);
+
+        // Consumer side of the edge queue, oldest first
+        const ButtonEdge *peekEdge() { return _edges.peek(); }
+        void dropEdge() { _edges.drop(); }
+
+        // The debounced state of every channel
+        uint16_t getPressedChannels() { return _debounced; }
+        uint32_t getScanCount() { return _scanCount; }
+
+    private:
+        uint _selectBase;
+        bool _isSelectReversed; // select0 is on the highest pin
+        bool _areSelectsConsecutive; // Checked by begin(), PIO can't drive them otherwise
+        uint _sensePin;
+
+        uint16_t _history[DEBOUNCE_SCANS] = {};
+        uint8_t _historyIndex = 0;
+        uint16_t _debounced = 0;
+        uint32_t _scanCount = 0;
+
+        SpscQueue<ButtonEdge, 32> _edges;
+
+#if defined(ARDUINO_ARCH_RP2040)
+        static void _onScanReady();
+
+        PIO _pio = nullptr;
+        uint _stateMachine = 0;
+#endif
+};
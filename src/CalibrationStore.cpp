@@ -0,0 +1,72 @@
+#include "CalibrationStore.hpp"
+#include <stddef.h>
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_RP2040)
+#include <EEPROM.h>
+
+// The smallest the core's EEPROM can be
+const size_t EEPROM_BYTES = 256;
+#endif
+
+// FNV-1a over everything before the checksum
+uint32_t CalibrationStore::checksum(const Record &record) {
+    const uint8_t *bytes = (const uint8_t *)&record;
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < offsetof(Record, checksum); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+bool CalibrationStore::loadPot(PotCalibration &calibration) {
+    Record record;
+    readRecord(record);
+
+    if (record.magic != MAGIC || record.checksum != checksum(record)) return false;
+
+    calibration = record.pot;
+    return true;
+}
+
+void CalibrationStore::savePot(const PotCalibration &calibration) {
+    Record record = {};
+    record.magic = MAGIC;
+    record.pot = calibration;
+    record.checksum = checksum(record);
+
+    writeRecord(record);
+}
+
+#if defined(ARDUINO_ARCH_RP2040)
+void CalibrationStore::begin() {
+    static_assert(sizeof(Record) <= EEPROM_BYTES, "The record doesn't fit");
+    EEPROM.begin(EEPROM_BYTES);
+}
+
+void CalibrationStore::readRecord(Record &record) {
+    EEPROM.get(0, record);
+}
+
+// The core pauses the other core and interrupts around the flash write
+void CalibrationStore::writeRecord(const Record &record) {
+    EEPROM.put(0, record);
+    EEPROM.commit();
+}
+#else
+// Stands in for the flash sector, starting out with nothing saved
+static uint8_t hostSector[64];
+
+void CalibrationStore::begin() {}
+
+void CalibrationStore::readRecord(Record &record) {
+    static_assert(sizeof(Record) <= sizeof(hostSector), "The record doesn't fit");
+    memcpy((void *)&record, hostSector, sizeof(Record));
+}
+
+void CalibrationStore::writeRecord(const Record &record) {
+    memcpy(hostSector, (const void *)&record, sizeof(Record));
+}
+#endif
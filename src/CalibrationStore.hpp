@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Compat.h"
+
+// How far each of the endless pot's two tracks reaches on this particular
+// unit, in the same 0 to 65535 as readAnalog
+struct PotCalibration {
+    uint16_t trackMin[2];
+    uint16_t trackMax[2];
+};
+
+// Per unit settings, kept in the last sector of flash through the core's
+// EEPROM emulation so they survive a power cycle. Off the board they only
+// last as long as the program does.
+class CalibrationStore {
+    public:
+        // Reads the flash sector into RAM
+        void begin();
+
+        // False if nothing's been saved yet, or it doesn't look right, and calibration's left alone
+        bool loadPot(PotCalibration &calibration);
+
+        // Erases and rewrites the sector. Both cores are held up while it
+        // does, for tens of milliseconds, so only when asked
+        void savePot(const PotCalibration &calibration);
+
+    private:
+        // Bump the number on the end whenever Record changes
+        static const uint32_t MAGIC = 0x52534301;
+
+        struct Record {
+            uint32_t magic;
+            PotCalibration pot;
+            uint32_t checksum;
+        };
+
+        static uint32_t checksum(const Record &record);
+
+        void readRecord(Record &record);
+        void writeRecord(const Record &record);
+};
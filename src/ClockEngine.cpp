@@ -0,0 +1,145 @@
+#include "ClockEngine.hpp"
+
+#if defined(ARDUINO_ARCH_RP2040)
+#include <hardware/timer.h>
+#include <hardware/sync.h>
+
+// The alarm callback only receives the alarm number
+static ClockEngine *alarmOwner = nullptr;
+#endif
+
+void ClockEngine::begin(Sequence *sequence, uint64_t nowMicros) {
+    _sequence = sequence;
+    _sequence->resetPulseTiming(nowMicros);
+    resetStats();
+
+#if defined(ARDUINO_ARCH_RP2040)
+    // The alarm interrupt fires on whichever core claims it, so this
+    // should be called from the sequencer core
+    alarmOwner = this;
+    _alarmNum = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(_alarmNum, &ClockEngine::_onAlarm);
+    _scheduleNextAlarm();
+#endif
+
+    if (_eventCallback != nullptr) {
+        _eventCallback({nowMicros, EVENT_START});
+    }
+}
+
+void ClockEngine::setScheduler(LookaheadScheduler *scheduler, void (*eventCallback)(const SequenceEvent &event)) {
+    _scheduler = scheduler;
+    _eventCallback = eventCallback;
+}
+
+void ClockEngine::poll(uint64_t nowMicros) {
+    if (_sequence == nullptr) return;
+
+    _handleDueWork(nowMicros);
+}
+
+void ClockEngine::lock() {
+#if defined(ARDUINO_ARCH_RP2040)
+    // Only ever locked from the sequencer core, so once interrupts are off the depth is safe to touch
+    uint32_t savedInterrupts = save_and_disable_interrupts();
+    if (_lockDepth++ == 0) {
+        _savedInterrupts = savedInterrupts;
+    }
+#endif
+}
+
+void ClockEngine::unlock() {
+#if defined(ARDUINO_ARCH_RP2040)
+    if (--_lockDepth > 0) return;
+
+    // Edits like tempo changes can move the next pulse boundary or event
+    _scheduleNextAlarm();
+    restore_interrupts(_savedInterrupts);
+#endif
+}
+
+void ClockEngine::rearm() {
+    lock();
+    unlock();
+}
+
+void ClockEngine::stop(uint64_t nowMicros) {
+    _isRunning = false;
+
+    if (_scheduler != nullptr) {
+        _scheduler->clear();
+    }
+
+    if (_eventCallback != nullptr) {
+        _eventCallback({nowMicros, EVENT_GATE_OFF});
+        _eventCallback({nowMicros, EVENT_STOP});
+    }
+}
+
+void ClockEngine::start(uint64_t nowMicros) {
+    _isRunning = true;
+    _sequence->resetPulseTiming(nowMicros);
+
+    // Whatever was planned before the restart is out of date
+    if (_scheduler != nullptr) {
+        _scheduler->clear();
+    }
+
+    if (_eventCallback != nullptr) {
+        _eventCallback({nowMicros, EVENT_START});
+    }
+}
+
+void ClockEngine::resetStats() {
+    _pulseCount = 0;
+    _maxLatenessMicros = 0;
+    _totalLatenessMicros = 0;
+}
+
+void ClockEngine::_handleDueWork(uint64_t nowMicros) {
+    if (!_isRunning) return;
+
+    // Catch up one pulse at a time if we've fallen behind, so no stage is skipped
+    while (_sequence->getNextPulseMicros() <= nowMicros) {
+        uint32_t latenessMicros = nowMicros - _sequence->getNextPulseMicros();
+        _maxLatenessMicros = max(_maxLatenessMicros, latenessMicros);
+        _totalLatenessMicros += latenessMicros;
+        _pulseCount++;
+
+        _sequence->advancePulse();
+        _sequence->updateOutputs(nowMicros);
+
+        if (_pulseCallback != nullptr) {
+            _pulseCallback();
+        }
+    }
+
+    if (_scheduler != nullptr) {
+        _scheduler->dispatch(nowMicros, _eventCallback);
+    }
+}
+
+#if defined(ARDUINO_ARCH_RP2040)
+void ClockEngine::_scheduleNextAlarm() {
+    // A stopped engine leaves the alarm to run out, it does nothing if it fires
+    if (_sequence == nullptr || !_isRunning) return;
+
+    while (true) {
+        uint64_t targetMicros = _sequence->getNextPulseMicros();
+        if (_scheduler != nullptr) {
+            targetMicros = min(targetMicros, _scheduler->getNextEventMicros());
+        }
+
+        // set_target returns true if the target has already passed, in which
+        // case the alarm won't fire and we have to handle it here
+        if (!hardware_alarm_set_target(_alarmNum, from_us_since_boot(targetMicros))) break;
+
+        _handleDueWork(time_us_64());
+    }
+}
+
+void ClockEngine::_onAlarm(uint alarmNum) {
+    alarmOwner->_handleDueWork(time_us_64());
+    alarmOwner->_scheduleNextAlarm();
+}
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Sequence.h"
+#include "LookaheadScheduler.hpp"
+
+// Drives the Sequence's pulse boundaries and the scheduler's planned events
+// from a hardware alarm, so their timing doesn't depend on how long the 
+// input and UI code takes to run.
+// Off the board there's no alarm, instead time is injected by calling poll()
+// with a virtual clock.
+class ClockEngine {
+public:
+    void begin(Sequence *sequence, uint64_t nowMicros);
+
+    // Planned events are dispatched to eventCallback when they're due. It also
+    // gets EVENT_START and EVENT_STOP when the engine starts and stops
+    void setScheduler(LookaheadScheduler *scheduler, void (*eventCallback)(const SequenceEvent &event));
+
+    // Handles every pulse boundary and event that's due by nowMicros
+    void poll(uint64_t nowMicros);
+
+    // Holds off pulse boundaries and events while the sequence is being changed.
+    // Anything that comes due in the meantime is handled on unlock(). Locks can 
+    // be nested, interrupts come back on with the outermost unlock()
+    void lock();
+    void unlock();
+
+    // Sets the alarm again for anything planned since it was last set, which 
+    // may be due before the next pulse
+    void rearm();
+
+    // Stops and restarts the sequence for external transport control. Call 
+    // with the engine locked. Stopping closes the gate and drops anything 
+    // planned, starting puts the next pulse one pulse after nowMicros
+    void stop(uint64_t nowMicros);
+    void start(uint64_t nowMicros);
+    bool isRunning() { return _isRunning; }
+
+    // Called after each pulse boundary, from the alarm interrupt on the board
+    void setPulseCallback(void (*pulseCallback)()) { _pulseCallback = pulseCallback; }
+
+    // How late pulse boundaries are handled compared to when they were due
+    uint32_t getPulseCount() { return _pulseCount; }
+    uint32_t getMaxLatenessMicros() { return _maxLatenessMicros; }
+    float getMeanLatenessMicros() { return _pulseCount > 0 ? _totalLatenessMicros / (float)_pulseCount : 0; }
+    void resetStats();
+
+private:
+    void _handleDueWork(uint64_t nowMicros);
+#if defined(ARDUINO_ARCH_RP2040)
+    void _scheduleNextAlarm();
+    static void _onAlarm(uint alarmNum);
+    int _alarmNum = -1;
+    uint32_t _savedInterrupts = 0; // From the outermost lock()
+    uint8_t _lockDepth = 0;
+#endif
+
+    Sequence *_sequence = nullptr;
+    void (*_pulseCallback)() = nullptr;
+    LookaheadScheduler *_scheduler = nullptr;
+    void (*_eventCallback)(const SequenceEvent &event) = nullptr;
+    bool _isRunning = true;
+    uint32_t _pulseCount = 0;
+    uint32_t _maxLatenessMicros = 0;
+    uint64_t _totalLatenessMicros = 0;
+};
@@ -0,0 +1,137 @@
+#include "ClockInput.hpp"
+
+// Edges closer together than this are treated as bounce
+const uint64_t ANALOG_DEBOUNCE_MICROS = 2000;
+
+void ClockInput::onMidiMessage(ClockMessageType type, uint64_t micros) {
+    _midiMessages.push({micros, type});
+}
+
+void ClockInput::onAnalogEdge(uint64_t micros) {
+    if (micros - _lastAnalogEdgeMicros < ANALOG_DEBOUNCE_MICROS) return;
+
+    _lastAnalogEdgeMicros = micros;
+    _analogEdges.push(micros);
+}
+
+void ClockInput::update(ClockEngine &clockEngine, Sequence &sequence, uint64_t nowMicros) {
+    ClockMessage message;
+    while (_midiMessages.pop(message)) {
+        clockEngine.lock();
+        if (message.type == CLOCK_TICK) {
+            _handleTick(CLOCK_MIDI, message.micros, clockEngine, sequence);
+        } else {
+            _handleTransport(message.type, message.micros, clockEngine, sequence);
+        }
+        clockEngine.unlock();
+    }
+
+    uint64_t edgeMicros;
+    while (_analogEdges.pop(edgeMicros)) {
+        clockEngine.lock();
+        _handleTick(CLOCK_ANALOG, edgeMicros, clockEngine, sequence);
+        clockEngine.unlock();
+    }
+
+    // The clock has gone quiet. Carry on at the last tempo by ourselves, there
+    // are no transport controls on the unit to start it again. Unless it was
+    // told to stop first, then going quiet is just what a stopped clock does
+    bool hasTimedOut = nowMicros > _lastTickMicros && nowMicros - _lastTickMicros > _getTimeoutMicros();
+    if (isFollowing() && hasTimedOut) {
+        _source = CLOCK_INTERNAL;
+        _isWaitingToStart = false;
+        _tempoTracker.reset();
+
+        if (!clockEngine.isRunning() && !_isStoppedByTransport) {
+            clockEngine.lock();
+            clockEngine.start(nowMicros);
+            clockEngine.unlock();
+        }
+    }
+}
+
+void ClockInput::_handleTick(ClockSource source, uint64_t tickMicros, ClockEngine &clockEngine, Sequence &sequence) {
+    if (_source == CLOCK_INTERNAL) {
+        _source = source;
+        _tickInPulse = 0;
+        _tempoTracker.reset();
+
+        // The analog clock has no transport, its edges are what start it
+        if (source == CLOCK_ANALOG && !clockEngine.isRunning()) {
+            _isWaitingToStart = true;
+        }
+    }
+
+    // Only one clock is followed at a time
+    if (source != _source) return;
+
+    _lastTickMicros = tickMicros;
+    _tempoTracker.onTick(tickMicros);
+
+    uint32_t ticksPerPulse = 1;
+    if (source == CLOCK_MIDI) {
+        ticksPerPulse = max(1, MIDI_TICKS_PER_QUARTER_NOTE / sequence.getSubdivision());
+    }
+
+    // The first tick after a start or continue is the start of a pulse
+    if (_isWaitingToStart) {
+        _isWaitingToStart = false;
+        _isStoppedByTransport = false;
+        _tickInPulse = 0;
+        clockEngine.start(_tempoTracker.getTickMicros());
+    }
+
+    if (clockEngine.isRunning() && _tempoTracker.hasTempo() && _tickInPulse == 0) {
+        sequence.syncPulseTiming(_tempoTracker.getTickMicros(), _tempoTracker.getMicrosPerTick() * ticksPerPulse);
+    }
+
+    _tickInPulse = (_tickInPulse + 1) % ticksPerPulse;
+}
+
+void ClockInput::_handleTransport(ClockMessageType type, uint64_t micros, ClockEngine &clockEngine, Sequence &sequence) {
+    // Transport only comes over MIDI, so it's ignored while following the analog clock
+    if (_source == CLOCK_ANALOG) return;
+
+    if (_source == CLOCK_INTERNAL) {
+        _source = CLOCK_MIDI;
+        _tempoTracker.reset();
+    }
+
+    _lastTickMicros = micros;
+
+    switch (type) {
+        case CLOCK_START:
+            sequence.rewind();
+            clockEngine.stop(micros);
+            _isWaitingToStart = true;
+            _isStoppedByTransport = false;
+            break;
+        case CLOCK_CONTINUE:
+            clockEngine.stop(micros);
+            _isWaitingToStart = true;
+            _isStoppedByTransport = false;
+            break;
+        case CLOCK_STOP:
+            clockEngine.stop(micros);
+            _isWaitingToStart = false;
+            _isStoppedByTransport = true;
+            break;
+        default:
+            break;
+    }
+}
+
+uint64_t ClockInput::_getTimeoutMicros() {
+    if (!_tempoTracker.hasTempo()) return 2000000;
+
+    return max((uint64_t)250000, (uint64_t)(_tempoTracker.getMicrosPerTick() * 4));
+}
+
+const char *ClockInput::getName(ClockSource source) {
+    switch (source) {
+        case CLOCK_INTERNAL: return "internal";
+        case CLOCK_MIDI:     return "midi";
+        case CLOCK_ANALOG:   return "analog";
+        default:             return "?";
+    }
+}
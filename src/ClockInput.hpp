@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ClockEngine.hpp"
+#include "Sequence.h"
+#include "SpscQueue.hpp"
+#include "TempoTracker.hpp"
+
+enum ClockSource : uint8_t {
+    CLOCK_INTERNAL, // The BPM pot
+    CLOCK_MIDI,
+    CLOCK_ANALOG
+};
+
+enum ClockMessageType : uint8_t {
+    CLOCK_TICK,
+    CLOCK_START,
+    CLOCK_STOP,
+    CLOCK_CONTINUE
+};
+
+struct ClockMessage {
+    uint64_t micros; // When it arrived
+    ClockMessageType type;
+};
+
+// Slaves the sequence to an external clock, either USB MIDI clock with its
+// start/stop/continue messages, or edges on the analog clock input (one per pulse).
+// Messages are stamped and queued as they arrive, from the MIDI handlers or
+// the GPIO interrupt, then fed through a TempoTracker by update().
+// Whichever clock ticks first is followed until it goes quiet, then the
+// sequence carries on at the last tempo and the BPM pot takes over again.
+// If it went quiet because it was told to stop, the sequence stays stopped
+// until the next start, continue or analog clock edge.
+class ClockInput {
+    public:
+        // Producers, safe to call from an interrupt
+        void onMidiMessage(ClockMessageType type, uint64_t micros);
+        void onAnalogEdge(uint64_t micros);
+
+        // Called from the sequencer loop with the sequence the clock engine is 
+        // playing. The engine's locked just while each message changes it
+        void update(ClockEngine &clockEngine, Sequence &sequence, uint64_t nowMicros);
+
+        ClockSource getSource() { return _source; }
+        bool isFollowing() { return _source != CLOCK_INTERNAL; }
+        TempoTracker &getTempoTracker() { return _tempoTracker; }
+
+        static const char *getName(ClockSource source);
+
+    private:
+        void _handleTick(ClockSource source, uint64_t tickMicros, ClockEngine &clockEngine, Sequence &sequence);
+        void _handleTransport(ClockMessageType type, uint64_t micros, ClockEngine &clockEngine, Sequence &sequence);
+        uint64_t _getTimeoutMicros();
+
+        SpscQueue<ClockMessage, 64> _midiMessages;
+        SpscQueue<uint64_t, 16> _analogEdges;
+        uint64_t _lastAnalogEdgeMicros = 0; // For debouncing
+
+        TempoTracker _tempoTracker;
+        ClockSource _source = CLOCK_INTERNAL;
+        uint64_t _lastTickMicros = 0;
+        uint32_t _tickInPulse = 0;
+        bool _isWaitingToStart = false; // Start or continue received, playing from the next tick
+        bool _isStoppedByTransport = false; // Stop received, and nothing since has started it again
+};
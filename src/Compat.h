@@ -0,0 +1,24 @@
+#pragma once
+
+// Lets the engine build off the board. On the board this is just Arduino.h,
+// on the host it fills in the few bits of it the engine relies on
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <sys/types.h>
+
+// The same as Arduino's, which unlike std::min/max allow mixed types
+template <class T, class L>
+auto min(const T &a, const L &b) -> decltype((b < a) ? b : a) {
+    return (b < a) ? b : a;
+}
+
+template <class T, class L>
+auto max(const T &a, const L &b) -> decltype((b < a) ? b : a) {
+    return (a < b) ? b : a;
+}
+#endif
@@ -0,0 +1,202 @@
+#include "DeltaHistory.hpp"
+
+void DeltaHistory::reset(Sequence &sequence) {
+    memset(&_committed, 0, sizeof(_committed));
+    _tail = 0;
+    _cursor = 0;
+    _bytesUsed = 0;
+    _redoBytes = 0;
+    _undoStepCount = 0;
+    _redoStepCount = 0;
+
+    // Record the starting state, then throw the step away
+    commit(sequence);
+    _tail = _cursor;
+    _bytesUsed = 0;
+    _undoStepCount = 0;
+}
+
+void DeltaHistory::commit(Sequence &sequence) {
+    // Committing a new step discards anything that could have been redone
+    _bytesUsed -= _redoBytes;
+    _redoBytes = 0;
+    _redoStepCount = 0;
+
+    // Make room for the biggest possible delta up front
+    while (DELTA_HISTORY_ARENA_SIZE - _bytesUsed < MAX_DELTA_SIZE + FRAMING_SIZE && _undoStepCount > 0) {
+        _dropOldestStep();
+    }
+
+    uint16_t length = _encodeDelta(sequence, _cursor + 2);
+    if (length == 0) return;
+
+    _writeLength(_cursor, length);
+    _writeLength(_cursor + 2 + length, length);
+
+    _cursor = (_cursor + length + FRAMING_SIZE) % DELTA_HISTORY_ARENA_SIZE;
+    _bytesUsed += length + FRAMING_SIZE;
+    _undoStepCount++;
+}
+
+bool DeltaHistory::undo(Sequence &sequence) {
+    if (_undoStepCount == 0) return false;
+
+    // Walk back over the delta using the length that trails it
+    uint16_t length = _readLength(_cursor + DELTA_HISTORY_ARENA_SIZE - 2);
+    _cursor = (_cursor + DELTA_HISTORY_ARENA_SIZE - length - FRAMING_SIZE) % DELTA_HISTORY_ARENA_SIZE;
+    _applyDelta(_cursor + 2, length);
+
+    _undoStepCount--;
+    _redoStepCount++;
+    _redoBytes += length + FRAMING_SIZE;
+    _restore(sequence);
+
+    return true;
+}
+
+bool DeltaHistory::redo(Sequence &sequence) {
+    if (_redoStepCount == 0) return false;
+
+    uint16_t length = _readLength(_cursor);
+    _applyDelta(_cursor + 2, length);
+    _cursor = (_cursor + length + FRAMING_SIZE) % DELTA_HISTORY_ARENA_SIZE;
+
+    _redoStepCount--;
+    _undoStepCount++;
+    _redoBytes -= length + FRAMING_SIZE;
+    _restore(sequence);
+
+    return true;
+}
+
+// Writes the ops that turn the committed state into the sequence's current
+// state, and updates the committed state to match. Returns the bytes written.
+uint16_t DeltaHistory::_encodeDelta(Sequence &sequence, size_t pos) {
+    size_t start = pos;
+
+    // Stage contents, one op per 32 bit word that changed
+    for (size_t i = 0; i < sequence.stageCount(); i++) {
+        Stage &stage = sequence.getStage(i);
+        uint32_t words[STAGE_WORDS];
+        _packStage(stage, words);
+
+        for (size_t w = 0; w < STAGE_WORDS; w++) {
+            uint32_t delta = words[w] ^ _committed.stageWordsById[stage.id][w];
+            if (delta == 0) continue;
+
+            _writeByte(pos++, OP_STAGE_WORD | (stage.id << 3) | w);
+            for (int byte = 0; byte < 4; byte++) {
+                _writeByte(pos++, delta >> (byte * 8));
+            }
+
+            _committed.stageWordsById[stage.id][w] = words[w];
+        }
+    }
+
+    // Stage order, which covers moves, inserts and deletes
+    for (size_t i = 0; i < sequence.stageCount(); i++) {
+        uint8_t delta = sequence.getStage(i).id ^ _committed.order[i];
+        if (delta == 0) continue;
+
+        _writeByte(pos++, OP_ORDER | i);
+        _writeByte(pos++, delta);
+        _committed.order[i] = sequence.getStage(i).id;
+    }
+
+    uint8_t stageCountDelta = sequence.stageCount() ^ _committed.stageCount;
+    if (stageCountDelta != 0) {
+        _writeByte(pos++, OP_STAGE_COUNT);
+        _writeByte(pos++, stageCountDelta);
+        _committed.stageCount = sequence.stageCount();
+    }
+
+    uint32_t scaleStepMaskDelta = sequence.scale.getStepMask() ^ _committed.scaleStepMask;
+    uint8_t scaleDivisionsDelta = sequence.scale.getDivisions() ^ _committed.scaleDivisions;
+    if (scaleStepMaskDelta != 0 || scaleDivisionsDelta != 0) {
+        _writeByte(pos++, OP_SCALE);
+        for (int byte = 0; byte < 4; byte++) {
+            _writeByte(pos++, scaleStepMaskDelta >> (byte * 8));
+        }
+        _writeByte(pos++, scaleDivisionsDelta);
+        _committed.scaleStepMask = sequence.scale.getStepMask();
+        _committed.scaleDivisions = sequence.scale.getDivisions();
+    }
+
+    return pos - start;
+}
+
+void DeltaHistory::_applyDelta(size_t pos, uint16_t length) {
+    size_t end = pos + length;
+
+    while (pos < end) {
+        uint8_t op = _readByte(pos++);
+
+        if ((op & 0x80) == OP_STAGE_WORD) {
+            uint32_t delta = 0;
+            for (int byte = 0; byte < 4; byte++) {
+                delta |= (uint32_t)_readByte(pos++) << (byte * 8);
+            }
+
+            _committed.stageWordsById[(op >> 3) & 0x0f][op & 0x07] ^= delta;
+        } else if ((op & 0xf0) == OP_ORDER) {
+            _committed.order[op & 0x0f] ^= _readByte(pos++);
+        } else if (op == OP_STAGE_COUNT) {
+            _committed.stageCount ^= _readByte(pos++);
+        } else if (op == OP_SCALE) {
+            for (int byte = 0; byte < 4; byte++) {
+                _committed.scaleStepMask ^= (uint32_t)_readByte(pos++) << (byte * 8);
+            }
+            _committed.scaleDivisions ^= _readByte(pos++);
+        }
+    }
+}
+
+// Copies the committed state back into the sequence
+void DeltaHistory::_restore(Sequence &sequence) {
+    Stage stagesById[MAX_STAGES];
+    for (uint8_t id = 0; id < MAX_STAGES; id++) {
+        stagesById[id] = _unpackStage(_committed.stageWordsById[id]);
+    }
+
+    sequence.restoreStages(stagesById, _committed.order, _committed.stageCount);
+
+    sequence.scale.setSteps(_committed.scaleDivisions, _committed.scaleStepMask);
+}
+
+// Fields that change together share a word, so a typical edit is one op
+void DeltaHistory::_packStage(Stage &stage, uint32_t *words) {
+    float output = stage.getBaseOutput();
+
+    words[0] = stage.id | (stage.pulseCount << 16) | ((uint8_t)stage.gateMode << 24);
+    words[1] = stage.isSkipped | (stage.isSelected << 8) | (stage.shouldSlideIn << 16) | (stage.shouldArpeggiate << 24);
+    words[2] = stage.arpSteps | ((uint8_t)stage.transpose << 8) | (stage.pulsePipsAngle.getBam() << 16);
+    memcpy(&words[3], &stage.arpStepWidth, 4);
+    memcpy(&words[4], &output, 4);
+}
+
+Stage DeltaHistory::_unpackStage(const uint32_t *words) {
+    Stage stage = Stage(words[0] & 0xffff);
+    stage.pulseCount = words[0] >> 16;
+    stage.gateMode = (GateMode)(words[0] >> 24);
+    stage.isSkipped = words[1] & 0xff;
+    stage.isSelected = (words[1] >> 8) & 0xff;
+    stage.shouldSlideIn = (words[1] >> 16) & 0xff;
+    stage.shouldArpeggiate = words[1] >> 24;
+    stage.arpSteps = words[2];
+    stage.transpose = (int8_t)(words[2] >> 8);
+    stage.pulsePipsAngle = Angle::fromBam(words[2] >> 16);
+
+    float output;
+    memcpy(&stage.arpStepWidth, &words[3], 4);
+    memcpy(&output, &words[4], 4);
+    stage.setOutput(output);
+
+    return stage;
+}
+
+void DeltaHistory::_dropOldestStep() {
+    uint16_t length = _readLength(_tail);
+    _tail = (_tail + length + FRAMING_SIZE) % DELTA_HISTORY_ARENA_SIZE;
+    _bytesUsed -= length + FRAMING_SIZE;
+    _undoStepCount--;
+}
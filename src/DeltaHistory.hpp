@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string.h>
+#include "Sequence.h"
+
+const size_t DELTA_HISTORY_ARENA_SIZE = 8192;
+
+// Undo/redo history that stores each step as the difference between
+// two edit states rather than as a full copy of the sequence.
+//
+// Deltas are XORs of the before and after states, so the same delta
+// takes you either way. They're stored back to back in a fixed ring of
+// bytes, each one framed by its length so it can be walked in both
+// directions. When the ring fills up, the oldest steps are dropped.
+class DeltaHistory {
+    public:
+        // Forget all steps and start from the sequence's current state
+        void reset(Sequence &sequence);
+
+        // Record everything that's changed since the last commit as one step.
+        // Nothing is recorded if nothing has changed.
+        void commit(Sequence &sequence);
+
+        bool undo(Sequence &sequence);
+        bool redo(Sequence &sequence);
+
+        uint16_t getUndoStepCount() { return _undoStepCount; }
+        uint16_t getRedoStepCount() { return _redoStepCount; }
+        size_t getBytesUsed() { return _bytesUsed; }
+
+    private:
+        // Stages are packed field by field, see _packStage, so padding never ends up in a delta
+        static const size_t STAGE_WORDS = 5;
+        static_assert(STAGE_WORDS <= 8, "Stage word indexes must fit in 3 bits");
+
+        // Op codes, see _encodeDelta for the payloads
+        static const uint8_t OP_STAGE_WORD = 0x00; // 0b0iiiiwww: stage id and word index
+        static const uint8_t OP_ORDER = 0x80;      // 0b1000pppp: position in the sequence
+        static const uint8_t OP_STAGE_COUNT = 0x90;
+        static const uint8_t OP_SCALE = 0xA0;
+
+        // Worst case, every word of every stage and every position changed
+        static const size_t MAX_DELTA_SIZE = MAX_STAGES * STAGE_WORDS * 5 + MAX_STAGES * 2 + 2 + 6;
+        static const size_t FRAMING_SIZE = 4; // Length before and after each delta
+
+        // The edit state as of the last commit, laid out so it diffs cheaply.
+        // Stages are kept by id, ids not in the sequence keep their last contents.
+        struct EditState {
+            uint32_t stageWordsById[MAX_STAGES][STAGE_WORDS];
+            uint8_t order[MAX_STAGES]; // Stage ids in sequence order
+            uint8_t stageCount;
+            uint32_t scaleStepMask;
+            uint8_t scaleDivisions;
+        };
+
+        static void _packStage(Stage &stage, uint32_t *words);
+        static Stage _unpackStage(const uint32_t *words);
+
+        uint16_t _encodeDelta(Sequence &sequence, size_t pos);
+        void _applyDelta(size_t pos, uint16_t length);
+        void _restore(Sequence &sequence);
+        void _dropOldestStep();
+
+        uint8_t _readByte(size_t pos) { return _arena[pos % DELTA_HISTORY_ARENA_SIZE]; }
+        void _writeByte(size_t pos, uint8_t value) { _arena[pos % DELTA_HISTORY_ARENA_SIZE] = value; }
+        uint16_t _readLength(size_t pos) { return _readByte(pos) | (_readByte(pos + 1) << 8); }
+        void _writeLength(size_t pos, uint16_t length) { _writeByte(pos, length); _writeByte(pos + 1, length >> 8); }
+
+        EditState _committed;
+        uint8_t _arena[DELTA_HISTORY_ARENA_SIZE];
+        size_t _tail = 0; // Start of the oldest step
+        size_t _cursor = 0; // Between the newest undo step and the oldest redo step
+        size_t _bytesUsed = 0;
+        size_t _redoBytes = 0;
+        uint16_t _undoStepCount = 0;
+        uint16_t _redoStepCount = 0;
+};
+
+static_assert(MAX_STAGES <= 16, "Stage ids and positions must fit in 4 bits");
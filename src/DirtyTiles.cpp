@@ -0,0 +1,74 @@
+#include "DirtyTiles.hpp"
+#include "RoundScreen.hpp"
+
+ScreenRect ScreenRect::unite(const ScreenRect &other) const {
+    int16_t left = min(x, other.x);
+    int16_t top = min(y, other.y);
+    int16_t right = max(x + w, other.x + other.w);
+    int16_t bottom = max(y + h, other.y + other.h);
+
+    return {left, top, (int16_t)(right - left), (int16_t)(bottom - top)};
+}
+
+ScreenRect ScreenRect::around(float centerX, float centerY, float halfWidth, float halfHeight) {
+    // Rounded outwards, so anything anti-aliased on the edge is still inside
+    int16_t left = floorf(centerX - halfWidth) - 1;
+    int16_t top = floorf(centerY - halfHeight) - 1;
+    int16_t right = ceilf(centerX + halfWidth) + 1;
+    int16_t bottom = ceilf(centerY + halfHeight) + 1;
+
+    return {left, top, (int16_t)(right - left), (int16_t)(bottom - top)};
+}
+
+void DirtyTiles::clear() {
+    for (uint16_t &row : _rows) row = 0;
+}
+
+void DirtyTiles::markAll() {
+    for (int row = 0; row < TILES_PER_SIDE; row++) {
+        _rows[row] = RoundScreen::getVisibleTiles(row);
+    }
+}
+
+void DirtyTiles::mark(const ScreenRect &rect) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+
+    int firstColumn = max(0, rect.x / TILE_SIZE);
+    int lastColumn = min(TILES_PER_SIDE - 1, (rect.x + rect.w - 1) / TILE_SIZE);
+    int firstRow = max(0, rect.y / TILE_SIZE);
+    int lastRow = min(TILES_PER_SIDE - 1, (rect.y + rect.h - 1) / TILE_SIZE);
+
+    // Entirely off screen
+    if (rect.x + rect.w <= 0 || rect.y + rect.h <= 0 || firstColumn > lastColumn || firstRow > lastRow) return;
+
+    uint16_t columns = ((1u << (lastColumn + 1)) - 1) & ~((1u << firstColumn) - 1);
+    for (int row = firstRow; row <= lastRow; row++) {
+        // Tiles in the corners are never seen on the round panel
+        _rows[row] |= columns & RoundScreen::getVisibleTiles(row);
+    }
+}
+
+DirtyTiles &DirtyTiles::operator|=(const DirtyTiles &other) {
+    for (int row = 0; row < TILES_PER_SIDE; row++) {
+        _rows[row] |= other._rows[row];
+    }
+
+    return *this;
+}
+
+bool DirtyTiles::isEmpty() const {
+    for (uint16_t row : _rows) {
+        if (row != 0) return false;
+    }
+
+    return true;
+}
+
+uint16_t DirtyTiles::getTileCount() const {
+    uint16_t count = 0;
+    for (uint16_t row : _rows) {
+        count += __builtin_popcount(row);
+    }
+
+    return count;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Compat.h"
+
+struct ScreenRect {
+    int16_t x, y, w, h;
+
+    bool intersects(const ScreenRect &other) const {
+        return x < other.x + other.w && other.x < x + w && y < other.y + other.h && other.y < y + h;
+    }
+
+    // The smallest rect holding both
+    ScreenRect unite(const ScreenRect &other) const;
+
+    static ScreenRect around(float centerX, float centerY, float halfWidth, float halfHeight);
+};
+
+// Which parts of the screen need redrawing, in 16px tiles. Rects marked dirty
+// are rounded out to whole tiles, and the frame is redrawn a row of tiles at
+// a time. Tiles outside the round panel never get marked.
+class DirtyTiles {
+    public:
+        static constexpr int16_t TILE_SIZE = 16;
+        static constexpr int16_t SCREEN_SIZE = 240;
+        static constexpr int16_t TILES_PER_SIDE = SCREEN_SIZE / TILE_SIZE;
+
+        void clear();
+        void markAll();
+        void mark(const ScreenRect &rect);
+        DirtyTiles &operator|=(const DirtyTiles &other);
+
+        bool isEmpty() const;
+        uint16_t getTileCount() const;
+
+        // One bit per tile along the row, column 0 in bit 0
+        uint16_t getRow(int tileRow) const { return _rows[tileRow]; }
+
+    private:
+        uint16_t _rows[TILES_PER_SIDE] = {}; // One bit per tile, column 0 in bit 0
+};
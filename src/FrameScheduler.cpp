@@ -0,0 +1,64 @@
+#include "FrameScheduler.hpp"
+
+// Frames in a row over budget before giving up a level of quality, and
+// under QUICK_FRAME of the budget before taking one back. Getting it back
+// takes much longer so it doesn't flicker between levels
+const uint8_t OVERRUNS_TO_DEGRADE = 3;
+const uint16_t QUICK_FRAMES_TO_RECOVER = 120;
+const float QUICK_FRAME = 0.6f;
+
+FrameScheduler::FrameScheduler(uint32_t targetFrameMicros) {
+    _targetFrameMicros = targetFrameMicros;
+}
+
+bool FrameScheduler::isFrameDue(uint64_t nowMicros) {
+    return !_hasStarted || nowMicros - _frameStartMicros >= _targetFrameMicros;
+}
+
+void FrameScheduler::beginFrame(uint64_t nowMicros) {
+    _frameStartMicros = nowMicros;
+    _phaseStartMicros = nowMicros;
+    _hasStarted = true;
+}
+
+void FrameScheduler::endPhase(FramePhase phase, uint64_t nowMicros) {
+    uint32_t micros = nowMicros - _phaseStartMicros;
+    _phaseMicros[phase] = (_phaseMicros[phase] * 7 + micros) / 8;
+    _phaseStartMicros = nowMicros;
+}
+
+void FrameScheduler::endFrame(uint64_t nowMicros) {
+    uint32_t micros = nowMicros - _frameStartMicros;
+    _frameMicros = (_frameMicros * 7 + micros) / 8;
+    _frameCount++;
+
+    if (micros > _targetFrameMicros) {
+        _overrunCount++;
+        _overrunsInARow++;
+        _quickFramesInARow = 0;
+    } else {
+        _overrunsInARow = 0;
+        _quickFramesInARow = (micros < _targetFrameMicros * QUICK_FRAME) ? _quickFramesInARow + 1 : 0;
+    }
+
+    if (_overrunsInARow >= OVERRUNS_TO_DEGRADE) {
+        if (_quality < QUALITY_LOWEST) _quality = (RenderQuality)(_quality + 1);
+        _overrunsInARow = 0;
+    } else if (_quickFramesInARow >= QUICK_FRAMES_TO_RECOVER) {
+        if (_quality > QUALITY_FULL) _quality = (RenderQuality)(_quality - 1);
+        _quickFramesInARow = 0;
+    }
+}
+
+// Doesn't count towards the quality either way, it didn't cost anything
+void FrameScheduler::skipFrame(uint64_t nowMicros) {
+    _frameStartMicros = nowMicros;
+    _hasStarted = true;
+    _skippedCount++;
+}
+
+void FrameScheduler::resetStats() {
+    _frameCount = 0;
+    _overrunCount = 0;
+    _skippedCount = 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+
+// The parts of a frame that get timed, in the order they run
+enum FramePhase : uint8_t {
+    PHASE_ANIMATE, // Stepping the animations up to now
+    PHASE_DIFF,    // Collecting elements and working out what changed
+    PHASE_DRAW,    // Redrawing the dirty rects
+    PHASE_COUNT
+};
+
+// What gets given up when frames are over budget, in the order it's given up.
+// Each level keeps everything given up by the ones before it
+enum RenderQuality : uint8_t {
+    QUALITY_FULL,
+    QUALITY_NO_ARC_SMOOTHING,   // Stage outputs are rasterized without anti-aliasing
+    QUALITY_NO_PIP_ANIMATION,   // Pulse pips jump to their gate mode instead of turning
+    QUALITY_SLOW_DEBUG_TEXT,    // The fps and debug text only update a couple of times a second
+    QUALITY_LOWEST = QUALITY_SLOW_DEBUG_TEXT
+};
+
+// Paces the render loop to a target frame time and keeps track of how much
+// of it each phase takes. A few frames in a row over budget drop the quality
+// a level, and a good while comfortably under budget brings it back up.
+class FrameScheduler {
+    public:
+        FrameScheduler(uint32_t targetFrameMicros);
+
+        // Whether it's been a whole frame since the last one started
+        bool isFrameDue(uint64_t nowMicros);
+
+        void beginFrame(uint64_t nowMicros);
+        // Ends phase, timing it from the end of the phase before
+        void endPhase(FramePhase phase, uint64_t nowMicros);
+        void endFrame(uint64_t nowMicros);
+        // Lets a frame slot go by without drawing, when it would look the same as the last
+        void skipFrame(uint64_t nowMicros);
+
+        RenderQuality getQuality() { return _quality; }
+        bool isSmoothingArcs() { return _quality < QUALITY_NO_ARC_SMOOTHING; }
+        bool isAnimatingPulsePips() { return _quality < QUALITY_NO_PIP_ANIMATION; }
+        // How long debug text is left before it's updated, 0 for every frame
+        uint32_t getDebugTextMillis() { return _quality < QUALITY_SLOW_DEBUG_TEXT ? 0 : 500; }
+
+        uint32_t getTargetFrameMicros() { return _targetFrameMicros; }
+
+        // Smoothed over the last few frames
+        uint32_t getPhaseMicros(FramePhase phase) { return _phaseMicros[phase]; }
+        uint32_t getFrameMicros() { return _frameMicros; }
+
+        uint32_t getFrameCount() { return _frameCount; }
+        uint32_t getOverrunCount() { return _overrunCount; }
+        uint32_t getSkippedCount() { return _skippedCount; }
+        void resetStats();
+
+    private:
+        uint32_t _targetFrameMicros;
+        RenderQuality _quality = QUALITY_FULL;
+
+        uint64_t _frameStartMicros = 0;
+        uint64_t _phaseStartMicros = 0;
+        bool _hasStarted = false;
+
+        uint8_t _overrunsInARow = 0;
+        uint16_t _quickFramesInARow = 0; // Comfortably under budget
+
+        uint32_t _phaseMicros[PHASE_COUNT] = {};
+        uint32_t _frameMicros = 0;
+
+        uint32_t _frameCount = 0;
+        uint32_t _overrunCount = 0;
+        uint32_t _skippedCount = 0;
+};
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include "GlyphCache.hpp"
+
+GlyphCache::GlyphCache(int16_t width, int16_t height, size_t budgetBytes) {
+    _width = width;
+    _height = height;
+    _slotCount = budgetBytes / getSlotBytes();
+}
+
+void GlyphCache::begin(TFT_eSPI *tft) {
+    // Reserved first, so the sprites never get moved
+    _sprites.reserve(_slotCount);
+    _slots.reserve(_slotCount);
+
+    for (size_t i = 0; i < _slotCount; i++) {
+        _sprites.emplace_back(tft);
+        _sprites.back().setColorDepth(COLOUR_DEPTH);
+        _sprites.back().createSprite(_width, _height);
+        _slots.push_back({0, 0, false});
+    }
+
+    // Blits skip whatever reads back as the background, which is bgColour rounded to RGB332
+    if (_slotCount > 0) {
+        _sprites[0].fillSprite(bgColour);
+        _transparentColour = _sprites[0].readPixel(0, 0);
+    }
+}
+
+TFT_eSprite *GlyphCache::get(uint64_t key, bool &isCached) {
+    _useCount++;
+
+    size_t leastRecentlyUsed = 0;
+    for (size_t i = 0; i < _slots.size(); i++) {
+        Slot &slot = _slots[i];
+
+        if (slot.isUsed && slot.key == key) {
+            slot.lastUsed = _useCount;
+            _hitCount++;
+            isCached = true;
+            return &_sprites[i];
+        }
+
+        // An empty slot always beats a used one
+        Slot &best = _slots[leastRecentlyUsed];
+        if (best.isUsed && (!slot.isUsed || slot.lastUsed < best.lastUsed)) {
+            leastRecentlyUsed = i;
+        }
+    }
+
+    if (_slots.empty()) {
+        isCached = false;
+        return nullptr;
+    }
+
+    Slot &slot = _slots[leastRecentlyUsed];
+    if (slot.isUsed) _evictionCount++;
+    slot = {key, _useCount, true};
+    _missCount++;
+
+    TFT_eSprite *sprite = &_sprites[leastRecentlyUsed];
+    sprite->fillSprite(bgColour);
+    isCached = false;
+    return sprite;
+}
+
+void GlyphCache::blit(TFT_eSprite *sprite, TFT_eSprite *target, int32_t x, int32_t y) {
+    sprite->pushToSprite(target, x - _width / 2, y - _height / 2, _transparentColour);
+}
+
+void GlyphCache::resetStats() {
+    _hitCount = 0;
+    _missCount = 0;
+    _evictionCount = 0;
+}
+
+const char *GlyphCache::getStatsHeader() {
+    return "glyphs          hits    misses evicted   hit%  slots";
+}
+
+void GlyphCache::formatStats(const char *name, char *text, size_t size) {
+    uint32_t lookups = _hitCount + _missCount;
+    snprintf(text, size, "%-10s %9lu %9lu %7lu %5.1f%%  %u x %u B",
+        name, (unsigned long)_hitCount, (unsigned long)_missCount, (unsigned long)_evictionCount,
+        lookups > 0 ? 100.f * _hitCount / lookups : 0.f, (unsigned)_slotCount, (unsigned)getSlotBytes());
+}
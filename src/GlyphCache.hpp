@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <TFT_eSPI.h>
+
+// Keeps things that are slow to draw, like anti-aliased rings and text,
+// rasterized in small sprites so they can be blitted instead. Every slot
+// is the same size and they're all allocated up front, so the cache never
+// grows past its budget. When it's full the least recently used one goes.
+// Slots are RGB332 like the strips they're blitted into.
+class GlyphCache {
+    public:
+        static const int8_t COLOUR_DEPTH = 8;
+
+        GlyphCache(int16_t width, int16_t height, size_t budgetBytes);
+
+        // Allocates the slots, call once the display is set up
+        void begin(TFT_eSPI *tft);
+
+        // The sprite holding key. If it wasn't cached, isCached is false
+        // and the sprite is cleared to bgColour, ready to be drawn into
+        TFT_eSprite *get(uint64_t key, bool &isCached);
+
+        // Draws sprite centred on x, y, leaving anything in bgColour transparent
+        void blit(TFT_eSprite *sprite, TFT_eSprite *target, int32_t x, int32_t y);
+
+        int16_t getWidth() { return _width; }
+        int16_t getHeight() { return _height; }
+        size_t getSlotCount() { return _slotCount; }
+        size_t getSlotBytes() { return _width * _height * COLOUR_DEPTH / 8; }
+        size_t getBytes() { return _slotCount * getSlotBytes(); }
+
+        uint32_t getHitCount() { return _hitCount; }
+        uint32_t getMissCount() { return _missCount; }
+        uint32_t getEvictionCount() { return _evictionCount; }
+        void resetStats();
+        static const char *getStatsHeader();
+        void formatStats(const char *name, char *text, size_t size);
+
+        uint16_t bgColour = 0;
+
+    private:
+        struct Slot {
+            uint64_t key;
+            uint32_t lastUsed;
+            bool isUsed;
+        };
+
+        int16_t _width;
+        int16_t _height;
+        size_t _slotCount;
+        std::vector<Slot> _slots;
+        std::vector<TFT_eSprite> _sprites;
+        uint32_t _useCount = 0;
+        uint16_t _transparentColour = 0; // bgColour as the slots read it back, after RGB332
+
+        uint32_t _hitCount = 0;
+        uint32_t _missCount = 0;
+        uint32_t _evictionCount = 0;
+};
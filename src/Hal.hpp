@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Compat.h"
+
+enum HalPinMode : uint8_t {
+    HAL_INPUT,
+    HAL_INPUT_PULLUP,
+    HAL_OUTPUT
+};
+
+// The bits of hardware the engine and input code touch. PicoHal drives the
+// board, MockHal stands in for it on the host with a virtual clock and pins
+// that can be set and inspected.
+class IHal {
+    public:
+        virtual ~IHal() {}
+
+        virtual uint64_t getMicros() = 0;
+        uint32_t getMillis() { return getMicros() / 1000; }
+
+        // For timing short bits of code. Wraps every few seconds, so only differences mean anything
+        virtual uint32_t getCycleCount() = 0;
+        virtual uint32_t getCyclesPerMicro() = 0;
+
+        virtual void setPinMode(uint pin, HalPinMode mode) = 0;
+        virtual bool readPin(uint pin) = 0;
+        virtual void writePin(uint pin, bool value) = 0;
+        virtual void writePwm(uint pin, uint8_t value) = 0;
+        // 0 to 65535 over the input's range, without waiting on a conversion
+        virtual uint16_t readAnalog(uint pin) = 0;
+
+        // USB MIDI. Writing returns false if there's no room for the packet right now
+        virtual bool isMidiConnected() = 0;
+        virtual bool writeMidiPacket(const uint8_t packet[4]) = 0;
+};
+
+// Defined by whichever platform is being built, main.cpp on the board 
+// and native/HostMain.cpp on the host
+IHal &getHal();
@@ -7,9 +7,17 @@ InteractionManager::InteractionManager() {
         {PITCH, &pitchButtonHandler},
         {ARP, &arpButtonHandler}
     };
+
+    for (uint8_t id = 0; id < MAX_STAGES; id++) {
+        _clonedFromIdById[id] = id;
+    }
 }
 
-void InteractionManager::processQuantizerConfigInput(UndoRedoManager &undoRedoManager, UserInputState &userInputState) {
+bool InteractionManager::processQuantizerConfigInput(UndoRedoManager &undoRedoManager, UserInputState &userInputState) {
+  Scale &scale = undoRedoManager.getSequence()->scale;
+  int divisions = scale.getDivisions();
+  bool hasChangedScale = false;
+
   if (userInputState.getBaseCommand() == QUANTIZER) {
     // Exit quantizer config
     if (userInputState.getBaseButton().fallingEdge()) {
@@ -18,13 +26,50 @@ void InteractionManager::processQuantizerConfigInput(UndoRedoManager &undoRedoMa
   } else if (userInputState.getBaseCommand() == SELECT) {
     // Toggle current pip
     if (userInputState.getBaseButton().fallingEdge()) {
-      int selectedNote = (int)round(_quantizerConfigCursorPos) % 12;
-      undoRedoManager.getSequence()->quantizer[selectedNote] = !undoRedoManager.getSequence()->quantizer[selectedNote];
+      scale.toggleStep((int)round(_quantizerConfigCursorPos) % divisions);
+      hasChangedScale = true;
+      undoRedoManager.saveUndoRedoSnapshot();
+    }
+  } else if (userInputState.getBaseCommand() == PITCH) {
+    // Turn through the scale library, one scale every 30 degrees
+    _scaleBrowseAngle += userInputState.getAngleDelta();
+    int scaleSteps = (int)(_scaleBrowseAngle / 30.f);
+
+    if (scaleSteps != 0) {
+      _scaleBrowseAngle -= scaleSteps * 30.f;
+
+      int index = scaleLibrary.indexOf(scale);
+      int scaleCount = scaleLibrary.size();
+      index = (index == -1) ? 0 : ((index + scaleSteps) % scaleCount + scaleCount) % scaleCount;
+      scale = scaleLibrary.getScale(index);
+      _quantizerConfigCursorPos = 0;
+      _hasBrowsedScales = true;
+      hasChangedScale = true;
+    }
+
+    if (userInputState.getBaseButton().fallingEdge()) {
+      if (_hasBrowsedScales) {
+        undoRedoManager.saveUndoRedoSnapshot();
+      }
+      _scaleBrowseAngle = 0;
+      _hasBrowsedScales = false;
+    }
+
+    // The knob's busy browsing
+    return hasChangedScale;
+  } else if (userInputState.getBaseCommand() == CLONE) {
+    // Keep the current scale in the next user slot, going round them in turn
+    if (userInputState.getBaseButton().fallingEdge()) {
+      size_t firstUserIndex = scaleLibrary.size() - USER_SCALE_COUNT;
+      scaleLibrary.saveUserScale(firstUserIndex + _nextUserScaleIndex, scale);
+      _nextUserScaleIndex = (_nextUserScaleIndex + 1) % USER_SCALE_COUNT;
     }
   }
 
-  _quantizerConfigCursorPos += userInputState.getAngleDelta() / 360.f * 12.f;
-  _quantizerConfigCursorPos = fwrap(_quantizerConfigCursorPos, 0, 12); 
+  _quantizerConfigCursorPos += userInputState.getAngleDelta() / 360.f * divisions;
+  _quantizerConfigCursorPos = fwrap(_quantizerConfigCursorPos, 0, divisions); 
+
+  return hasChangedScale;
 }
 
 void InteractionManager::processInput(UndoRedoManager &undoRedoManager, UserInputState &userInputState) {
@@ -34,25 +79,24 @@ void InteractionManager::processInput(UndoRedoManager &undoRedoManager, UserInpu
   bool shouldResetHiddenValue = true;
 
   // Update highlighted stage
-  float degreesPerStage = 360 / (float)sequence.stageCount();
-
   if (!_isEditingPosition) {
-    _highlightedStageIndex = (int)roundf(_cursorAngle / degreesPerStage) % sequence.stageCount();
+    _highlightedStageIndex = _cursorAngle.nearestDivision(sequence.stageCount());
   }
 
   SelectionState selectionState = SelectionState(sequence, _highlightedStageIndex); 
 
-  bool isShiftHeld = false;
   bool shouldSupressCursorRotation = false;
+  // Set by anything below that changes stages or the scale directly, the sequence's own methods count edits themselves
+  bool hasEdited = false;
   _isEditingPosition = false;
 
   if (undoRedoManager.isInQuantizerConfig) {
     shouldSupressCursorRotation = true;
-    processQuantizerConfigInput(undoRedoManager, userInputState);
+    hasEdited = processQuantizerConfigInput(undoRedoManager, userInputState);
   } else if (buttonHandlers.find(userInputState.getBaseCommand()) != buttonHandlers.end()) {
     IButtonHandler &handler = *buttonHandlers[userInputState.getBaseCommand()];
 
-    handler.handle(userInputState, undoRedoManager, selectionState);
+    hasEdited = handler.handle(userInputState, undoRedoManager, selectionState);
     shouldSupressCursorRotation = handler.shouldSuppressCursorRotation();
   } else if (userInputState.getBaseCommand() == UNDO) {
     if (userInputState.getBaseButton().risingEdge()) {
@@ -68,6 +112,7 @@ void InteractionManager::processInput(UndoRedoManager &undoRedoManager, UserInpu
       for (auto stage : selectionState.getAffectedStages()) {
         stage->isSkipped = !stage->isSkipped;
       }
+      hasEdited = true;
   
       sequence.updateNextStageIndex();
 
@@ -84,6 +129,7 @@ void InteractionManager::processInput(UndoRedoManager &undoRedoManager, UserInpu
         stage->pulseCount = coerceInRange(stage->pulseCount + (_hiddenValue > 0 ? 1 : -1), 1, 8);
       }
       _mutationCanary += (_hiddenValue > 0 ? 1 : -1);
+      hasEdited = true;
 
       _hiddenValue = 0;
     }
@@ -97,26 +143,22 @@ void InteractionManager::processInput(UndoRedoManager &undoRedoManager, UserInpu
       for (auto stage : selectionState.getAffectedStages()) {
         stage->shouldSlideIn = !stage->shouldSlideIn;
       }
+      hasEdited = true;
 
       undoRedoManager.saveUndoRedoSnapshot();
     }
   } else if (userInputState.getBaseCommand() == CLONE) {
     if (userInputState.getBaseButton().risingEdge()) {
-      // Iterate from the end to the beginning because deleting 
-      // stages moves around the data in the stages vector causing 
+      // Iterate from the end to the beginning because inserting 
+      // stages moves around the data in the stages array causing 
       // the pointers in affected stages to point to the wrong stage. 
       // Iterating in reverse is a workaround to that issue
       auto rit = selectionState.getAffectedStages().rbegin();
       while (rit != selectionState.getAffectedStages().rend()) {
-        if (sequence.stageCount() >= MAX_STAGES) { break; }
+        size_t cloneIndex = sequence.cloneStage(sequence.indexOfStage(*rit));
+        if (cloneIndex == NO_STAGE) { break; }
 
-        // Copy everything about the stage, except deselect it
-        Stage newStage = **rit;
-        newStage.isSelected = false;
-        newStage.id = sequence.getNewStageId();
-        undoRedoManager.stageDrawInfoById[newStage.id] = undoRedoManager.stageDrawInfoById[(**rit).id];
-
-        sequence.insertStage(sequence.indexOfStage(*rit) + 1, newStage);
+        _clonedFromIdById[sequence.getStage(cloneIndex).id] = (**rit).id;
 
         ++rit;
       }
@@ -126,7 +168,7 @@ void InteractionManager::processInput(UndoRedoManager &undoRedoManager, UserInpu
   } else if (userInputState.getBaseCommand() == DELETE) {
     if (userInputState.getBaseButton().risingEdge()) {
       // Iterate from the end to the beginning because deleting 
-      // stages moves around the data in the stages vector causing 
+      // stages moves around the data in the stages array causing 
       // the pointers in affected stages to point to the wrong stage. 
       // Iterating in reverse is a workaround to that issue
       auto rit = selectionState.getAffectedStages().rbegin();
@@ -141,6 +183,11 @@ void InteractionManager::processInput(UndoRedoManager &undoRedoManager, UserInpu
     shouldResetHiddenValue = false;
     _isEditingPosition = true;
 
+    // Holding move and pressing redo shows or hides the performance overlay
+    if (userInputState.getModifierCommand() == REDO && userInputState.getModifierButton().risingEdge()) {
+      _isShowingPerfHud = !_isShowingPerfHud;
+    }
+
     _hiddenValue += userInputState.getAngleDelta();
     float degreesPerStage = 360 / (float)sequence.stageCount();
 
@@ -149,13 +196,12 @@ void InteractionManager::processInput(UndoRedoManager &undoRedoManager, UserInpu
       int direction = (_hiddenValue > 0) ? 1 : -1;
       _mutationCanary += direction;
       
-      std::vector<size_t> indexesOfStagesToMove;
+      uint16_t stagesToMove = 0;
       for (Stage* stage : selectionState.getAffectedStages()) {
-        size_t stageIndex = sequence.indexOfStage(stage);
-        indexesOfStagesToMove.push_back(stageIndex);
+        stagesToMove |= 1 << sequence.indexOfStage(stage);
       }
 
-      sequence.moveStages(indexesOfStagesToMove, direction);
+      sequence.moveStages(stagesToMove, direction);
 
       // The highlightedStage will be moved by this action, so update the index
       _highlightedStageIndex = wrap((int)_highlightedStageIndex + direction, 0, sequence.stageCount());
@@ -175,11 +221,14 @@ void InteractionManager::processInput(UndoRedoManager &undoRedoManager, UserInpu
 
   if (!shouldSupressCursorRotation) {
     // Cusor
-    _cursorAngle += userInputState.getAngleDelta();
-    _cursorAngle = fwrap(_cursorAngle, 0, 360); 
+    _cursorAngle += Angle::fromDegrees(userInputState.getAngleDelta());
   }
 
   if (shouldResetHiddenValue) {
     _hiddenValue = 0;
   }
+
+  if (hasEdited) {
+    sequence.markEdited();
+  }
 }
\ No newline at end of file
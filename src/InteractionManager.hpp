@@ -1,6 +1,8 @@
 #pragma once
 
+#include <map>
 #include "Sequence.h"
+#include "Scale.hpp"
 #include "Button.h"
 #include "UserInputState.hpp"
 #include "SelectionState.hpp"
@@ -13,12 +15,19 @@ class InteractionManager {
 public:
     InteractionManager();
     void processInput(UndoRedoManager &undoRedoManager, UserInputState &userInputState);
-    void processQuantizerConfigInput(UndoRedoManager &undoRedoManager, UserInputState &userInputState);
+    bool processQuantizerConfigInput(UndoRedoManager &undoRedoManager, UserInputState &userInputState);
 
     bool _isEditingPosition = false;
     uint8_t _highlightedStageIndex = 0;
-    float _cursorAngle = 0;
-    float _quantizerConfigCursorPos = 0;
+    Angle _cursorAngle;
+    float _quantizerConfigCursorPos = 0; // In steps of the scale's divisions
+    float _scaleBrowseAngle = 0;
+    bool _hasBrowsedScales = false;
+    size_t _nextUserScaleIndex = 0;
+    bool _isShowingPerfHud = false;
+    // The stage each one was cloned from, or its own id. The renderer owns the draw
+    // info, so this goes out in the snapshot for it to start clones where their original is
+    uint8_t _clonedFromIdById[MAX_STAGES];
     // These shouldn't be needed once all the buttons have dedicated handlers
     float _hiddenValue = 0;
     float _mutationCanary = 0;
@@ -27,5 +36,6 @@ public:
     SelectButtonHandler selectButtonHandler;
     PitchButtonHandler pitchButtonHandler;
     ArpButtonHandler arpButtonHandler;
+    ScaleLibrary scaleLibrary;
     std::map<Command, IButtonHandler*> buttonHandlers;
 };
\ No newline at end of file
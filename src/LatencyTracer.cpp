@@ -0,0 +1,105 @@
+#include "LatencyTracer.hpp"
+#include <stdio.h>
+#include <algorithm>
+
+LatencyTracer latencyTracer;
+
+LatencyTracer &getLatencyTracer() {
+    return latencyTracer;
+}
+
+uint16_t LatencyTracer::begin(LatencySource source, uint64_t inputMicros) {
+    uint16_t id = _latestId.load() + 1;
+    if (id == 0) id = 1;
+
+    // The id goes last, so it doesn't match until the rest's there
+    Trace &trace = _traces[id % RECENT_TRACES];
+    trace.source = source;
+    trace.inputMicros = inputMicros;
+    trace.id = id;
+
+    _latestId = id;
+    return id;
+}
+
+void LatencyTracer::record(LatencyStage stage, uint16_t id, uint64_t nowMicros) {
+    const Trace &trace = _traces[id % RECENT_TRACES];
+    if (id != 0 && trace.id == id) {
+        addSample(stage, trace, nowMicros);
+    }
+}
+
+void LatencyTracer::recordOldest(LatencyStage stage, uint16_t afterId, uint16_t upToId, uint64_t nowMicros) {
+    // Anything older's been forgotten anyway
+    if ((uint16_t)(upToId - afterId) > RECENT_TRACES) {
+        afterId = upToId - RECENT_TRACES;
+    }
+
+    for (uint16_t id = afterId + 1; id != (uint16_t)(upToId + 1); id++) {
+        const Trace &trace = _traces[id % RECENT_TRACES];
+
+        if (id != 0 && trace.id == id) {
+            addSample(stage, trace, nowMicros);
+            return;
+        }
+    }
+}
+
+void LatencyTracer::addSample(LatencyStage stage, const Trace &trace, uint64_t nowMicros) {
+    SampleRing &ring = _rings[stage];
+    Sample &sample = ring.samples[ring.count++ % SAMPLES_PER_STAGE];
+    sample.inputMicros = trace.inputMicros;
+    sample.latencyMicros = (nowMicros > trace.inputMicros) ? nowMicros - trace.inputMicros : 0;
+    sample.source = trace.source;
+}
+
+void LatencyTracer::reset() {
+    for (SampleRing &ring : _rings) ring.count = 0;
+}
+
+const char *LatencyTracer::getName(LatencyStage stage) {
+    switch (stage) {
+        case LATENCY_EDIT:   return "edit";
+        case LATENCY_RENDER: return "render";
+        case LATENCY_SCREEN: return "screen";
+        case LATENCY_GATE:   return "gate";
+        case LATENCY_MIDI:   return "midi";
+        default:             return "?";
+    }
+}
+
+const char *LatencyTracer::getName(LatencySource source) {
+    switch (source) {
+        case LATENCY_BUTTON: return "button";
+        case LATENCY_KNOB:   return "knob";
+        default:             return "?";
+    }
+}
+
+const char *LatencyTracer::getTableHeader() {
+    return "stage   source   count     p50 us     p90 us     p99 us     max us";
+}
+
+bool LatencyTracer::formatTableRow(LatencyStage stage, LatencySource source, char *text, size_t size) {
+    // Only ever used from the one core, for serial
+    static uint32_t latencies[SAMPLES_PER_STAGE];
+
+    SampleRing &ring = _rings[stage];
+    uint32_t sampleCount = min(ring.count.load(), (uint32_t)SAMPLES_PER_STAGE);
+    uint16_t count = 0;
+    for (uint32_t i = 0; i < sampleCount; i++) {
+        if (ring.samples[i].source == source) {
+            latencies[count++] = ring.samples[i].latencyMicros;
+        }
+    }
+
+    if (count == 0) return false;
+
+    std::sort(latencies, latencies + count);
+    auto percentile = [&](float fraction) { return (unsigned long)latencies[min((uint16_t)(fraction * count), (uint16_t)(count - 1))]; };
+
+    snprintf(text, size, "%-7s %-6s %7u %10lu %10lu %10lu %10lu",
+        getName(stage), getName(source), count,
+        percentile(0.5f), percentile(0.9f), percentile(0.99f), (unsigned long)latencies[count - 1]);
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include "Compat.h"
+
+enum LatencySource : uint8_t {
+    LATENCY_BUTTON,
+    LATENCY_KNOB,
+    LATENCY_SOURCE_COUNT
+};
+
+// How far an input's got, each timed from the input itself
+enum LatencyStage : uint8_t {
+    LATENCY_EDIT,   // InteractionManager's handled it
+    LATENCY_RENDER, // A frame showing it has started drawing
+    LATENCY_SCREEN, // That frame's finished going out over DMA
+    LATENCY_GATE,   // The first gate edge from a plan it changed, so it includes waiting for the pulse
+    LATENCY_MIDI,   // And that gate's MIDI message written to USB
+    LATENCY_STAGE_COUNT
+};
+
+// Follows button edges and knob turns from processInput to the screen, the
+// gate pin and USB MIDI. Each input gets an id that's passed along with
+// whatever it changed, and each stage it reaches adds a timestamped sample
+// to that stage's ring in RAM. A ring each, so the knob's steady stream of
+// edits doesn't push out the rarer gates. Percentiles come from sorting a
+// ring when asked for.
+//
+// Inputs are traced on core 1 and the screen and MIDI on core 0. Like
+// PerfStats it's only statistics, so a sample read while it's being written
+// isn't worth locking for
+class LatencyTracer {
+    public:
+        static const uint16_t RECENT_TRACES = 64; // About a quarter of a second of knob turning
+        static const uint16_t SAMPLES_PER_STAGE = 128;
+
+        // Starts following an input, returns its id. Ids are never 0, so 0 can mean no trace
+        uint16_t begin(LatencySource source, uint64_t inputMicros);
+        uint16_t getLatestId() { return _latestId.load(); }
+
+        // The trace's got to stage. 0, or an id too old to remember, is ignored
+        void record(LatencyStage stage, uint16_t id, uint64_t nowMicros);
+        // For outputs that only ever show the latest state, like the screen. Of
+        // the traces after afterId, up to upToId, the oldest is the one that waited longest
+        void recordOldest(LatencyStage stage, uint16_t afterId, uint16_t upToId, uint64_t nowMicros);
+
+        void reset();
+
+        static const char *getName(LatencyStage stage);
+        static const char *getName(LatencySource source);
+
+        // A line of text for the table printed over serial. False if there's nothing to put in it
+        static const char *getTableHeader();
+        bool formatTableRow(LatencyStage stage, LatencySource source, char *text, size_t size);
+
+    private:
+        struct Trace {
+            uint16_t id;
+            LatencySource source;
+            uint64_t inputMicros;
+        };
+
+        struct Sample {
+            uint32_t inputMicros; // Wraps every hour or so, it's only for lining samples up
+            uint32_t latencyMicros;
+            LatencySource source;
+        };
+
+        struct SampleRing {
+            Sample samples[SAMPLES_PER_STAGE];
+            std::atomic<uint32_t> count {0}; // Full once it's past SAMPLES_PER_STAGE
+        };
+
+        void addSample(LatencyStage stage, const Trace &trace, uint64_t nowMicros);
+
+        Trace _traces[RECENT_TRACES] = {}; // By id
+        std::atomic<uint16_t> _latestId {0};
+
+        SampleRing _rings[LATENCY_STAGE_COUNT];
+};
+
+LatencyTracer &getLatencyTracer();
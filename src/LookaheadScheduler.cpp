@@ -0,0 +1,202 @@
+#include "LookaheadScheduler.hpp"
+#include <string.h>
+
+void LookaheadScheduler::plan(Sequence &sequence, uint64_t nowMicros) {
+    uint32_t pulseIndex = sequence.getPulseIndex();
+
+    // Everything up to the lookahead's queued, and nothing's changed since
+    bool isUpToDate = _hasPlanned && sequence.getEditCount() == _plannedEditCount 
+        && _lastPlannedPulseIndex == pulseIndex + _lookaheadPulses;
+    if (isUpToDate) return;
+
+    _plannedEditCount = sequence.getEditCount();
+    PulseEvents planned[MAX_LOOKAHEAD_PULSES + 1];
+
+    // Play a copy of the sequence from the current pulse up to the lookahead
+    Sequence future = sequence;
+    future.updateOutputs(nowMicros);
+    bool shouldGateBeOpen = future.getGate();
+
+    for (uint8_t i = 0; i <= _lookaheadPulses; i++) {
+        if (i > 0) future.advancePulse();
+        _eventsForPulse(future, planned[i]);
+    }
+
+    // Start over if we've fallen behind, or an edit has changed a pulse that's already queued
+    bool needsReplan = !_hasPlanned || pulseIndex > _lastPlannedPulseIndex;
+    for (uint8_t i = 0; i <= _lookaheadPulses && pulseIndex + i <= _lastPlannedPulseIndex && !needsReplan; i++) {
+        needsReplan = _hashEvents(planned[i]) != _pulseHashes[(pulseIndex + i) % HASH_SLOTS];
+    }
+
+    if (needsReplan) {
+        // Anything already queued gets thrown away by dispatch()
+        _generation++;
+        _replanCount++;
+        _hasPlanned = true;
+        bool isQueued = true;
+
+        if (!shouldGateBeOpen) {
+            isQueued &= _push({nowMicros, EVENT_GATE_OFF});
+        }
+
+        // The current pulse has already started, so bring the outputs 
+        // straight into line and only keep what's still to come
+        for (uint8_t e = 0; e < planned[0].count; e++) {
+            SequenceEvent event = planned[0].events[e];
+
+            if (event.type == EVENT_PITCH) {
+                uint64_t slideEndMicros = event.micros + event.slideMicros;
+                event.slideMicros = (slideEndMicros > nowMicros) ? slideEndMicros - nowMicros : 0;
+                event.micros = nowMicros;
+                isQueued &= _push(event);
+            } else if (event.type == EVENT_GATE_ON && shouldGateBeOpen) {
+                event.micros = nowMicros;
+                isQueued &= _push(event);
+            } else if (event.type == EVENT_GATE_OFF && shouldGateBeOpen) {
+                isQueued &= _push(event);
+            } else if (event.type == EVENT_CLOCK && event.clockIndex > _lastDispatchedClockIndex.load()) {
+                // Ticks that were due but got thrown away still go out, late rather than never
+                isQueued &= _push(event);
+            }
+        }
+
+        // Losing a gate off would leave the gate stuck open, so rather than carry on
+        // with a gap in the plan it's all made again next time round, gate off first
+        if (!isQueued) {
+            _hasPlanned = false;
+            return;
+        }
+
+        _pulseHashes[pulseIndex % HASH_SLOTS] = _hashEvents(planned[0]);
+        _lastPlannedPulseIndex = pulseIndex;
+    }
+
+    // Queue up the pulses that haven't been planned yet
+    for (uint8_t i = 1; i <= _lookaheadPulses; i++) {
+        if (pulseIndex + i <= _lastPlannedPulseIndex) continue;
+        if (_queue.spaceLeft() < planned[i].count) break; // Try again next time round
+
+        // Only the planner pushes, so the space checked for is still there
+        for (uint8_t e = 0; e < planned[i].count; e++) {
+            _push(planned[i].events[e]);
+        }
+
+        _pulseHashes[(pulseIndex + i) % HASH_SLOTS] = _hashEvents(planned[i]);
+        _lastPlannedPulseIndex = pulseIndex + i;
+    }
+}
+
+void LookaheadScheduler::dispatch(uint64_t nowMicros, void (*handler)(const SequenceEvent &event)) {
+    const SequenceEvent *event;
+
+    while ((event = _queue.peek()) != nullptr) {
+        // Planned before an edit, a newer plan has replaced it
+        if (event->generation != _generation.load()) {
+            _queue.drop();
+            continue;
+        }
+
+        if (event->micros > nowMicros) break;
+
+        if (event->type == EVENT_CLOCK) {
+            _lastDispatchedClockIndex.store(event->clockIndex);
+        }
+
+        handler(*event);
+        _queue.drop();
+    }
+}
+
+void LookaheadScheduler::clear() {
+    _generation++;
+    _hasPlanned = false;
+}
+
+uint64_t LookaheadScheduler::getNextEventMicros() {
+    const SequenceEvent *event = _queue.peek();
+
+    if (event == nullptr) return UINT64_MAX;
+    if (event->generation != _generation.load()) return 0;
+
+    return event->micros;
+}
+
+// Works out the events for the pulse the sequence has just moved on to
+void LookaheadScheduler::_eventsForPulse(Sequence &future, PulseEvents &pulseEvents) {
+    Stage &stage = future.getActiveStage();
+    uint64_t pulseMicros = future.getLastPulseMicros();
+    unsigned long microsPerPulse = future.getMicrosPerPulse();
+    uint32_t slideMicros = future.isSliding() ? microsPerPulse * future.getGateLength() : 0;
+
+    // Run to the end of any slide to find where the output settles
+    future.updateOutputs(pulseMicros + slideMicros);
+    uint8_t midiNote = future.getMidiNote();
+
+    pulseEvents.count = 0;
+    pulseEvents.events[pulseEvents.count++] = {pulseMicros, EVENT_PITCH, 0, 0, future.getOutput(), slideMicros};
+
+    // Mirrors the gate logic in Sequence::updateOutputs
+    if (stage.gateMode == HELD) {
+        if (future.getCurrentPulseInStage() == 0) {
+            pulseEvents.events[pulseEvents.count++] = {pulseMicros, EVENT_GATE_ON, 0, midiNote};
+        }
+
+        if (future.isLastPulseOfStage()) {
+            pulseEvents.events[pulseEvents.count++] = {pulseMicros + (uint64_t)(microsPerPulse * HELD_GATE_LENGTH), EVENT_GATE_OFF};
+        }
+    } else if (stage.isPulseActive(future.getCurrentPulseInStage())) {
+        pulseEvents.events[pulseEvents.count++] = {pulseMicros, EVENT_GATE_ON, 0, midiNote};
+        pulseEvents.events[pulseEvents.count++] = {pulseMicros + (uint64_t)(microsPerPulse * future.getGateLength()), EVENT_GATE_OFF};
+    }
+
+    // Clock ticks spread evenly through the pulse
+    uint8_t clocksPerPulse = min(MAX_CLOCKS_PER_PULSE, max(1, MIDI_TICKS_PER_QUARTER_NOTE / future.getSubdivision()));
+    for (uint8_t i = 0; i < clocksPerPulse; i++) {
+        SequenceEvent &clock = pulseEvents.events[pulseEvents.count++];
+        clock = {pulseMicros + (uint64_t)microsPerPulse * i / clocksPerPulse, EVENT_CLOCK};
+        clock.clockIndex = future.getPulseIndex() * clocksPerPulse + i + 1;
+    }
+
+    // dispatch() stops at the first event that isn't due, so they have to be in time order.
+    // There are only a handful, and std::stable_sort would want a buffer off the heap
+    for (uint8_t i = 1; i < pulseEvents.count; i++) {
+        SequenceEvent event = pulseEvents.events[i];
+        uint8_t j = i;
+
+        for (; j > 0 && pulseEvents.events[j - 1].micros > event.micros; j--) {
+            pulseEvents.events[j] = pulseEvents.events[j - 1];
+        }
+
+        pulseEvents.events[j] = event;
+    }
+}
+
+// FNV-1a over everything but the generation
+uint32_t LookaheadScheduler::_hashEvents(PulseEvents &pulseEvents) {
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const void *data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ ((const uint8_t*)data)[i]) * 16777619u;
+        }
+    };
+
+    for (uint8_t e = 0; e < pulseEvents.count; e++) {
+        SequenceEvent &event = pulseEvents.events[e];
+        mix(&event.micros, sizeof(event.micros));
+        mix(&event.type, sizeof(event.type));
+        mix(&event.midiNote, sizeof(event.midiNote));
+        mix(&event.output, sizeof(event.output));
+        mix(&event.slideMicros, sizeof(event.slideMicros));
+        mix(&event.clockIndex, sizeof(event.clockIndex));
+    }
+
+    return hash;
+}
+
+bool LookaheadScheduler::_push(SequenceEvent event) {
+    event.generation = _generation.load();
+    if (_queue.push(event)) return true;
+
+    _droppedCount++;
+    return false;
+}
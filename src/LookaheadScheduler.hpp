@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Sequence.h"
+#include "SpscQueue.hpp"
+
+const uint8_t MAX_LOOKAHEAD_PULSES = 4;
+// Enough for a 16th note pulse, longer pulses only get the first few
+const uint8_t MAX_CLOCKS_PER_PULSE = 6;
+// Pitch, gate on and gate off, then the clocks
+const uint8_t MAX_EVENTS_PER_PULSE = 3 + MAX_CLOCKS_PER_PULSE;
+
+enum SequenceEventType : uint8_t {
+    EVENT_GATE_ON,
+    EVENT_GATE_OFF,
+    EVENT_PITCH,
+    EVENT_CLOCK, // A 24 PPQN MIDI clock tick
+    EVENT_START, // Sent by the clock engine when it starts or stops
+    EVENT_STOP
+};
+
+// Fields an event type doesn't use are left at their defaults
+struct SequenceEvent {
+    uint64_t micros = 0; // When the event is due
+    SequenceEventType type = EVENT_GATE_ON;
+    uint32_t generation = 0; // Which plan the event belongs to. 32 bits, so a queued event can't outlive enough replans to match again
+    uint8_t midiNote = 0; // EVENT_GATE_ON only
+    float output = 0; // EVENT_PITCH only, the output to move to
+    uint32_t slideMicros = 0; // EVENT_PITCH only, how long to take getting there. 0 jumps straight to it
+    uint32_t clockIndex = 0; // EVENT_CLOCK only, counts up from 1 so no tick is sent twice
+};
+
+// Plays a copy of the sequence a few pulses ahead of the real one and queues
+// up the gate and pitch changes it makes, stamped with when they're due.
+// dispatch() then hands them to the outputs at exactly the right time, no
+// matter how busy the sequencer loop is.
+//
+// If an edit changes a pulse that has already been planned, everything still
+// queued is thrown away and the pulses are planned again. Nothing's looked at 
+// again until the sequence is edited or moves on a pulse.
+class LookaheadScheduler {
+    public:
+        LookaheadScheduler(uint8_t lookaheadPulses = 2) : _lookaheadPulses(min(lookaheadPulses, MAX_LOOKAHEAD_PULSES)) {}
+
+        // Called from the sequencer loop. It only pushes to the queue, so it
+        // can run while dispatch() is being called from the alarm
+        void plan(Sequence &sequence, uint64_t nowMicros);
+
+        // Throws away everything queued, the next plan() starts from scratch
+        void clear();
+
+        // Passes every event that's due by nowMicros to handler
+        void dispatch(uint64_t nowMicros, void (*handler)(const SequenceEvent &event));
+
+        // When dispatch() next has work to do. 0 if there are thrown away 
+        // events to clear out, UINT64_MAX if nothing is queued
+        uint64_t getNextEventMicros();
+
+        uint32_t getReplanCount() { return _replanCount; }
+        // Events that didn't fit in the queue. Their plan is made again from scratch
+        uint32_t getDroppedCount() { return _droppedCount; }
+
+    private:
+        struct PulseEvents {
+            SequenceEvent events[MAX_EVENTS_PER_PULSE];
+            uint8_t count;
+        };
+
+        void _eventsForPulse(Sequence &future, PulseEvents &pulseEvents);
+        uint32_t _hashEvents(PulseEvents &pulseEvents);
+        bool _push(SequenceEvent event);
+
+        static const uint8_t HASH_SLOTS = MAX_LOOKAHEAD_PULSES + 1;
+
+        // A plan is a gate off, the rest of the current pulse, then the lookahead. The
+        // last plan can still be queued when the next one's made, until dispatch() drops it
+        static const size_t MAX_PLAN_EVENTS = 1 + (MAX_LOOKAHEAD_PULSES + 1) * MAX_EVENTS_PER_PULSE;
+        static const size_t QUEUE_CAPACITY = 128;
+        static_assert(QUEUE_CAPACITY >= 2 * MAX_PLAN_EVENTS, "The queue must hold an old plan and a new one");
+
+        SpscQueue<SequenceEvent, QUEUE_CAPACITY> _queue;
+        uint8_t _lookaheadPulses;
+        std::atomic<uint32_t> _generation {0};
+        bool _hasPlanned = false;
+        uint32_t _lastPlannedPulseIndex = 0;
+        uint32_t _pulseHashes[HASH_SLOTS] = {}; // Indexed by pulse index, used to spot edits to planned pulses
+        uint32_t _plannedEditCount = 0; // The sequence's edit count when it was last planned
+        uint32_t _replanCount = 0;
+        uint32_t _droppedCount = 0;
+        std::atomic<uint32_t> _lastDispatchedClockIndex {0};
+};
@@ -0,0 +1,66 @@
+#include "MidiOutput.hpp"
+#include "LatencyTracer.hpp"
+#include <stdio.h>
+
+bool MidiOutput::send(uint8_t status, uint8_t data1, uint8_t data2, uint64_t micros, uint16_t traceId) {
+    if (!_queue.push({micros, status, (uint8_t)(data1 & 0x7F), (uint8_t)(data2 & 0x7F), traceId})) {
+        _droppedCount++;
+        return false;
+    }
+
+    return true;
+}
+
+void MidiOutput::flush(uint64_t nowMicros) {
+    _maxQueueDepth = max(_maxQueueDepth, (uint32_t)_queue.size());
+
+    const MidiMessage *message;
+    while ((message = _queue.peek()) != nullptr) {
+        // Nobody's listening, don't save up a burst of stale notes for when they are
+        if (!getHal().isMidiConnected()) {
+            _queue.drop();
+            continue;
+        }
+
+        // TinyUSB's buffer is full, try again next time
+        if (!_writePacket(*message)) break;
+
+        uint32_t latencyMicros = (nowMicros > message->micros) ? nowMicros - message->micros : 0;
+        _maxLatencyMicros = max(_maxLatencyMicros, latencyMicros);
+        _totalLatencyMicros += latencyMicros;
+        _sentCount++;
+
+        if (message->traceId != 0) {
+            getLatencyTracer().record(LATENCY_MIDI, message->traceId, nowMicros);
+        }
+
+        _queue.drop();
+    }
+}
+
+void MidiOutput::resetStats() {
+    _sentCount = 0;
+    _droppedCount = 0;
+    _maxLatencyMicros = 0;
+    _totalLatencyMicros = 0;
+    _maxQueueDepth = 0;
+}
+
+const char *MidiOutput::getStatsHeader() {
+    return "midi out        sent  dropped   mean us    max us  max queued";
+}
+
+void MidiOutput::formatStats(char *text, size_t size) {
+    snprintf(text, size, "%-10s %9lu %8lu %9.1f %9lu %11lu",
+        "usb", (unsigned long)_sentCount, (unsigned long)getDroppedCount(), getMeanLatencyMicros(),
+        (unsigned long)_maxLatencyMicros, (unsigned long)_maxQueueDepth);
+}
+
+bool MidiOutput::_writePacket(const MidiMessage &message) {
+    // The code index number is the top of the status byte for channel
+    // messages, and 0xF for single byte real time messages
+    uint8_t codeIndex = (message.status >= 0xF8) ? 0x0F : message.status >> 4;
+    uint8_t packet[4] = {codeIndex, message.status, message.data1, message.data2};
+
+    return getHal().writeMidiPacket(packet);
+}
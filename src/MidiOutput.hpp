@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Hal.hpp"
+#include "SpscQueue.hpp"
+
+enum MidiStatus : uint8_t {
+    MIDI_NOTE_OFF = 0x80,
+    MIDI_NOTE_ON = 0x90,
+    MIDI_CLOCK = 0xF8,
+    MIDI_START = 0xFA,
+    MIDI_CONTINUE = 0xFB,
+    MIDI_STOP = 0xFC
+};
+
+struct MidiMessage {
+    uint64_t micros; // When it was meant to go out
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+    uint16_t traceId; // The input that led to it, if it's being traced
+};
+
+// Queues MIDI messages from the sequencer core and writes them to USB from
+// the render core, so a slow or stalled USB host can never hold up the clock.
+// Sending only ever pushes onto a lock-free queue. If it's full the message
+// is dropped and counted rather than waiting.
+class MidiOutput {
+    public:
+        // Producer, from the sequencer core or its interrupts. A traceId has
+        // the latency tracer told when the message is written
+        bool send(uint8_t status, uint8_t data1, uint8_t data2, uint64_t micros, uint16_t traceId = 0);
+        bool sendNoteOn(uint8_t note, uint8_t velocity, uint8_t channel, uint64_t micros, uint16_t traceId = 0) { return send(MIDI_NOTE_ON | ((channel - 1) & 0x0F), note, velocity, micros, traceId); }
+        bool sendNoteOff(uint8_t note, uint8_t channel, uint64_t micros, uint16_t traceId = 0) { return send(MIDI_NOTE_OFF | ((channel - 1) & 0x0F), note, 0, micros, traceId); }
+        bool sendRealTime(MidiStatus status, uint64_t micros) { return send(status, 0, 0, micros); }
+
+        // Consumer, from the render core. Writes as many queued messages as
+        // TinyUSB will take in one go, whatever's left waits for the next call
+        void flush(uint64_t nowMicros);
+
+        // How late messages go out compared to when they were meant to,
+        // and how many couldn't be queued at all
+        uint32_t getSentCount() { return _sentCount; }
+        uint32_t getDroppedCount() { return _droppedCount.load(); }
+        uint32_t getMaxLatencyMicros() { return _maxLatencyMicros; }
+        float getMeanLatencyMicros() { return _sentCount > 0 ? _totalLatencyMicros / (float)_sentCount : 0; }
+        uint32_t getMaxQueueDepth() { return _maxQueueDepth; }
+        void resetStats();
+
+        // A line of text for the perf table printed over serial
+        static const char *getStatsHeader();
+        void formatStats(char *text, size_t size);
+
+    private:
+        bool _writePacket(const MidiMessage &message);
+
+        SpscQueue<MidiMessage, 64> _queue;
+
+        uint32_t _sentCount = 0;
+        std::atomic<uint32_t> _droppedCount {0};
+        uint32_t _maxLatencyMicros = 0;
+        uint64_t _totalLatencyMicros = 0;
+        uint32_t _maxQueueDepth = 0;
+};
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <Arduino.h>
+#include "Hal.hpp"
 
 class Multiplexer {
     public:
@@ -10,17 +10,17 @@ class Multiplexer {
             _select2 = select2;
             _select3 = select3;
 
-            pinMode(_select0, OUTPUT);
-            pinMode(_select1, OUTPUT);
-            pinMode(_select2, OUTPUT);
-            pinMode(_select3, OUTPUT);
+            getHal().setPinMode(_select0, HAL_OUTPUT);
+            getHal().setPinMode(_select1, HAL_OUTPUT);
+            getHal().setPinMode(_select2, HAL_OUTPUT);
+            getHal().setPinMode(_select3, HAL_OUTPUT);
         }
 
         void select(uint channel) {
-            gpio_put(_select0, channel & 1);
-            gpio_put(_select1, channel >> 1 & 1);
-            gpio_put(_select2, channel >> 2 & 1);
-            gpio_put(_select3, channel >> 3 & 1);
+            getHal().writePin(_select0, channel & 1);
+            getHal().writePin(_select1, channel >> 1 & 1);
+            getHal().writePin(_select2, channel >> 2 & 1);
+            getHal().writePin(_select3, channel >> 3 & 1);
         }
 
     private:
@@ -0,0 +1,111 @@
+#include "PerfStats.hpp"
+#include <stdio.h>
+
+PerfStats perfStats;
+
+PerfStats &getPerfStats() {
+    return perfStats;
+}
+
+// Small values get a bucket each, after that each power of two is split in four
+uint8_t PerfHistogram::bucketOf(uint32_t cycles) {
+    if (cycles < (1u << SUB_BUCKET_BITS)) return cycles;
+
+    uint8_t topBit = 31 - __builtin_clz(cycles);
+    uint8_t subBucket = (cycles >> (topBit - SUB_BUCKET_BITS)) & ((1u << SUB_BUCKET_BITS) - 1);
+    return ((topBit - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + subBucket;
+}
+
+uint32_t PerfHistogram::bucketStart(uint8_t bucket) {
+    if (bucket < (1u << SUB_BUCKET_BITS)) return bucket;
+
+    uint8_t topBit = (bucket >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+    uint32_t subBucket = bucket & ((1u << SUB_BUCKET_BITS) - 1);
+    return ((1u << SUB_BUCKET_BITS) + subBucket) << (topBit - SUB_BUCKET_BITS);
+}
+
+void PerfHistogram::record(uint32_t cycles) {
+    _buckets[bucketOf(cycles)]++;
+    _count++;
+    _totalCycles += cycles;
+    if (cycles < _minCycles) _minCycles = cycles;
+    if (cycles > _maxCycles) _maxCycles = cycles;
+}
+
+void PerfHistogram::reset() {
+    for (uint32_t &bucket : _buckets) bucket = 0;
+    _count = 0;
+    _totalCycles = 0;
+    _minCycles = UINT32_MAX;
+    _maxCycles = 0;
+}
+
+uint32_t PerfHistogram::getPercentileCycles(float percentile) {
+    if (_count == 0) return 0;
+
+    uint32_t countBelow = 0;
+    uint32_t wanted = percentile * _count;
+    for (uint8_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+        countBelow += _buckets[bucket];
+
+        if (countBelow > wanted) {
+            uint32_t bucketEnd = (bucket + 1 < BUCKET_COUNT) ? bucketStart(bucket + 1) - 1 : UINT32_MAX;
+            return min(bucketEnd, _maxCycles);
+        }
+    }
+
+    return _maxCycles;
+}
+
+void PerfStats::add(PerfCounter counter, uint32_t cycles) {
+    _frameCycles[counter] += cycles;
+    _framePartsAdded |= 1 << counter;
+}
+
+// Parts that didn't happen this frame aren't recorded, so they don't drag the minimums to 0
+void PerfStats::endFrame() {
+    for (uint8_t counter = 0; counter < PERF_FRAME_PART_COUNT; counter++) {
+        if (_framePartsAdded & (1 << counter)) {
+            _histograms[counter].record(_frameCycles[counter]);
+        }
+
+        _frameCycles[counter] = 0;
+    }
+
+    _framePartsAdded = 0;
+}
+
+void PerfStats::record(PerfCounter counter, uint32_t cycles) {
+    _histograms[counter].record(cycles);
+}
+
+void PerfStats::reset() {
+    for (PerfHistogram &histogram : _histograms) histogram.reset();
+}
+
+const char *PerfStats::getName(PerfCounter counter) {
+    switch (counter) {
+        case PERF_CLEAR:    return "clear";
+        case PERF_STAGES:   return "stages";
+        case PERF_ARCS:     return "arcs";
+        case PERF_TEXT:     return "text";
+        case PERF_DMA_WAIT: return "dma wait";
+        case PERF_ANIMATE:  return "animate";
+        case PERF_INPUT:    return "input";
+        case PERF_SEQUENCE: return "sequence";
+        default:            return "?";
+    }
+}
+
+const char *PerfStats::getTableHeader() {
+    return "counter        count     min us     avg us     p99 us     max us";
+}
+
+void PerfStats::formatTableRow(PerfCounter counter, char *text, size_t size) {
+    PerfHistogram &histogram = _histograms[counter];
+
+    snprintf(text, size, "%-10s %9lu %10.1f %10.1f %10.1f %10.1f",
+        getName(counter), (unsigned long)histogram.getCount(),
+        cyclesToMicros(histogram.getMinCycles()), cyclesToMicros(histogram.getMeanCycles()),
+        cyclesToMicros(histogram.getPercentileCycles(0.99f)), cyclesToMicros(histogram.getMaxCycles()));
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stddef.h>
+#include "Hal.hpp"
+
+enum PerfCounter : uint8_t {
+    // Parts of a frame, added up over the whole frame. Arcs are counted in
+    // the stages too when they're part of one
+    PERF_CLEAR,
+    PERF_STAGES,
+    PERF_ARCS,
+    PERF_TEXT,
+    PERF_FRAME_PART_COUNT,
+
+    // Timed on their own every time they run
+    PERF_DMA_WAIT = PERF_FRAME_PART_COUNT, // From a frame being due to the last one finishing sending
+    PERF_ANIMATE,
+    PERF_INPUT,
+    PERF_SEQUENCE,
+    PERF_COUNTER_COUNT
+};
+
+// How long something takes, in cycles. Buckets go up in quarters of a
+// power of two, so percentiles are never more than 25% out
+class PerfHistogram {
+    public:
+        void record(uint32_t cycles);
+        void reset();
+
+        uint32_t getCount() { return _count; }
+        uint32_t getMinCycles() { return _count > 0 ? _minCycles : 0; }
+        uint32_t getMaxCycles() { return _maxCycles; }
+        uint32_t getMeanCycles() { return _count > 0 ? _totalCycles / _count : 0; }
+        // The top of the bucket the percentile lands in, percentile from 0 to 1
+        uint32_t getPercentileCycles(float percentile);
+
+    private:
+        static const uint8_t SUB_BUCKET_BITS = 2;
+        static const uint8_t BUCKET_COUNT = (32 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+        static uint8_t bucketOf(uint32_t cycles);
+        static uint32_t bucketStart(uint8_t bucket);
+
+        uint32_t _buckets[BUCKET_COUNT] = {};
+        uint32_t _count = 0;
+        uint64_t _totalCycles = 0;
+        uint32_t _minCycles = UINT32_MAX;
+        uint32_t _maxCycles = 0;
+};
+
+// Timing histograms for the bits of the firmware that matter for keeping up.
+// The frame parts are recorded on core 0 and input and the sequence on core 1.
+// They're only statistics, so a reset landing in the middle of a record on
+// the other core isn't worth locking for
+class PerfStats {
+    public:
+        // Adds to a frame part, which is recorded at the end of the frame
+        void add(PerfCounter counter, uint32_t cycles);
+        void endFrame();
+
+        void record(PerfCounter counter, uint32_t cycles);
+        void reset();
+
+        PerfHistogram &get(PerfCounter counter) { return _histograms[counter]; }
+        float cyclesToMicros(uint32_t cycles) { return cycles / (float)getHal().getCyclesPerMicro(); }
+
+        static const char *getName(PerfCounter counter);
+
+        // A line of text for the table printed over serial
+        static const char *getTableHeader();
+        void formatTableRow(PerfCounter counter, char *text, size_t size);
+
+    private:
+        PerfHistogram _histograms[PERF_COUNTER_COUNT];
+        uint32_t _frameCycles[PERF_FRAME_PART_COUNT] = {};
+        uint8_t _framePartsAdded = 0; // One bit per part
+};
+
+PerfStats &getPerfStats();
+
+// Times itself from being made to going out of scope
+class PerfScope {
+    public:
+        PerfScope(PerfCounter counter) : _counter(counter), _startCycles(getHal().getCycleCount()) {}
+
+        ~PerfScope() {
+            uint32_t cycles = getHal().getCycleCount() - _startCycles;
+
+            if (_counter < PERF_FRAME_PART_COUNT) {
+                getPerfStats().add(_counter, cycles);
+            } else {
+                getPerfStats().record(_counter, cycles);
+            }
+        }
+
+    private:
+        PerfCounter _counter;
+        uint32_t _startCycles;
+};
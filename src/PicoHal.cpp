@@ -0,0 +1,63 @@
+#include "PicoHal.hpp"
+#include <hardware/structs/m33.h>
+#include <hardware/clocks.h>
+
+uint64_t PicoHal::getMicros() {
+    return time_us_64();
+}
+
+// The M33's DWT cycle counter, which is free running once enabled
+uint32_t PicoHal::getCycleCount() {
+    return m33_hw->dwt_cyccnt;
+}
+
+uint32_t PicoHal::getCyclesPerMicro() {
+    return clock_get_hz(clk_sys) / 1000000;
+}
+
+void PicoHal::enableCycleCounter() {
+    m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+    m33_hw->dwt_cyccnt = 0;
+    m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+}
+
+void PicoHal::setPinMode(uint pin, HalPinMode mode) {
+    switch (mode) {
+        case HAL_INPUT:        pinMode(pin, INPUT); break;
+        case HAL_INPUT_PULLUP: pinMode(pin, INPUT_PULLUP); break;
+        case HAL_OUTPUT:       pinMode(pin, OUTPUT); break;
+    }
+}
+
+// Straight to the SDK rather than digitalRead/Write, these get called from interrupts
+bool PicoHal::readPin(uint pin) {
+    return gpio_get(pin);
+}
+
+void PicoHal::writePin(uint pin, bool value) {
+    gpio_put(pin, value);
+}
+
+void PicoHal::writePwm(uint pin, uint8_t value) {
+    analogWrite(pin, value);
+}
+
+// The ADC pins are sampled all the time and come from the filter, anything
+// else falls back to a blocking read
+uint16_t PicoHal::readAnalog(uint pin) {
+    if (pin >= 26 && pin < 26 + AdcSampler::CHANNEL_COUNT) {
+        _adcSampler.update();
+        return _adcSampler.read(pin - 26);
+    }
+
+    return analogRead(pin) << 6;
+}
+
+bool PicoHal::isMidiConnected() {
+    return _usbMidi->mounted();
+}
+
+// Packets queue up in TinyUSB's FIFO and go out together in the next transfer
+bool PicoHal::writeMidiPacket(const uint8_t packet[4]) {
+    return _usbMidi->writePacket(packet);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <Adafruit_TinyUSB.h>
+#include "Hal.hpp"
+#include "AdcSampler.hpp"
+
+class PicoHal : public IHal {
+    public:
+        PicoHal(Adafruit_USBD_MIDI *usbMidi) : _usbMidi(usbMidi) {}
+
+        uint64_t getMicros() override;
+        uint32_t getCycleCount() override;
+        uint32_t getCyclesPerMicro() override;
+
+        // The cycle counter is per core, so each core has to start its own
+        void enableCycleCounter();
+
+        // Starts sampling the analog inputs, from the core that reads them
+        void beginAnalog() { _adcSampler.begin(); }
+
+        void setPinMode(uint pin, HalPinMode mode) override;
+        bool readPin(uint pin) override;
+        void writePin(uint pin, bool value) override;
+        void writePwm(uint pin, uint8_t value) override;
+        uint16_t readAnalog(uint pin) override;
+
+        bool isMidiConnected() override;
+        bool writeMidiPacket(const uint8_t packet[4]) override;
+
+    private:
+        Adafruit_USBD_MIDI *_usbMidi;
+        AdcSampler _adcSampler;
+};
@@ -1,4 +1,13 @@
 #include "Render.hpp"
+#include "DirtyTiles.hpp"
+#include "RoundScreen.hpp"
+#include "GlyphCache.hpp"
+#include "FrameScheduler.hpp"
+#include "PerfStats.hpp"
+#include "Tweens.hpp"
+#include "LatencyTracer.hpp"
+#include <stdio.h>
+#include <stddef.h>
 
 #define SCREEN_WIDTH 240
 #define SCREEN_HALF_WIDTH 120
@@ -13,23 +22,175 @@ const uint16_t COLOUR_ACTIVE =    0xfd4f;
 const uint16_t COLOUR_INACTIVE =  0xaa21;
 const uint16_t COLOUR_SKIPPED =   0x5180;
 
+// The strips are 8 bit, which TFT_eSPI stores as RGB332. These are expanded
+// back to exactly the colours above on the way to the display, the
+// anti-aliasing blends in between get the nearest RGB332 colour
+constexpr uint16_t PALETTE_COLOURS[] = {COLOUR_BG, COLOUR_BEAT, COLOUR_USER, COLOUR_ACTIVE, COLOUR_INACTIVE, COLOUR_SKIPPED};
+
+// As TFT_eSPI does it when drawing into an 8 bit sprite
+constexpr uint8_t toRgb332(uint16_t colour) {
+  return (colour & 0xE000) >> 8 | (colour & 0x0700) >> 6 | (colour & 0x0018) >> 3;
+}
+
+constexpr bool arePaletteColoursDistinct() {
+  for (uint16_t a : PALETTE_COLOURS) {
+    int matchCount = 0;
+    for (uint16_t b : PALETTE_COLOURS) matchCount += toRgb332(a) == toRgb332(b);
+    if (matchCount > 1) return false;
+  }
+  return true;
+}
+static_assert(arePaletteColoursDistinct(), "Two of the UI colours are the same in RGB332");
+
+// RGB332 to RGB565, byte swapped ready for DMA
+uint16_t panelColours[256];
+
 TFT_eSPI tft = TFT_eSPI();
-TFT_eSprite screens[2] = {TFT_eSprite(&tft), TFT_eSprite(&tft)};
-TFT_eSprite* curScreen = &screens[0];
-uint16_t* screenPtrs[2];
-uint8_t curScreenIndex = 0;
+
+// The frame is drawn a row of tiles at a time into one of these strips, while
+// the other is sent to the display. Everything is drawn in screen coordinates,
+// a viewport moves it up into the strip
+const int16_t STRIP_ROWS = DirtyTiles::TILE_SIZE;
+TFT_eSprite strips[2] = {TFT_eSprite(&tft), TFT_eSprite(&tft)};
+uint8_t* stripPtrs[2];
+TFT_eSprite* curScreen = &strips[0]; // Whichever strip is being drawn into
+
+struct StripState {
+  bool isRendered; // And waiting to be sent, or being sent
+  int16_t y;
+  uint16_t columns; // The dirty tiles along it, which are all that get sent
+  int16_t clipX; // The screen x of the strip's first column
+};
+StripState stripStates[2] = {};
 
 int32_t lastFrameMillis = 0;
 float fps = 0;
-int32_t lastAnimationTickMillis = 0;
-float msPerFrame = 0;
+
+// Everything that eases, which is only what's still on its way
+Tweens tweens;
+
+// 60fps, which is about as fast as the panel can take a full frame
+FrameScheduler frameScheduler = FrameScheduler(16667);
+
+// What the debug text says. It's held onto between updates when frames are over budget
+long shownFps = 0;
+long shownMsPerFrame = 0;
+Command shownCommands[16];
+uint8_t shownCommandCount = 0;
+int32_t lastDebugTextMillis = 0;
+
+// The performance overlay, in microseconds. It's only updated twice a second so it can be read
+struct PerfHudRow {
+  long minMicros, meanMicros, p99Micros;
+};
+PerfHudRow perfHudRows[PERF_COUNTER_COUNT];
+int32_t lastPerfHudMillis = 0;
+
+bool isWaitingForDma = false;
+uint32_t dmaWaitStartCycles = 0;
+
+// Input traces up to these have been drawn, and sent to the display
+uint16_t drawnTraceId = 0;
+uint16_t sentTraceId = 0;
+
+// Everything on screen is drawn as an element: a box it stays inside and a
+// hash of whatever decides how it looks. Only tiles under elements that
+// changed get cleared, redrawn and sent to the display
+struct ScreenElement {
+  ScreenRect bounds;
+  uint32_t hash;
+};
+
+// A stage is up to five elements, more while its gate mode's being edited. Past
+// this the whole screen's redrawn
+const size_t MAX_SCREEN_ELEMENTS = 128;
+
+ScreenElement screenElements[2][MAX_SCREEN_ELEMENTS]; // This frame's and the last one's
+size_t screenElementCounts[2] = {0, 0};
+uint8_t curElementsIndex = 0;
+bool isCollectingElements = false;
+ScreenRect drawClipRect;
+
+// The frame being drawn. Its strips are drawn over a few calls, so they're
+// all drawn from a copy of the snapshot it started with
+bool isFrameInProgress = false;
+SequenceSnapshot frameSnapshot;
+StageDrawInfo *frameStageDrawInfoById;
+uint16_t animatedStageIds = 0; // Bit per stage id that was on screen last time the animations were stepped
+DirtyTiles frameTiles;
+int16_t nextTileRow = 0;
+
+// The strip being sent, and which of its tiles are still to go
+int8_t pushStripIndex = -1;
+uint16_t pushColumns = 0;
+int16_t pushRow = 0;
+
+// A DMA window needs its pixels in one block, so strips are expanded to RGB565 into here first.
+// They go a few rows at a time, each trimmed to what the round panel shows of those rows
+const int16_t PUSH_CHUNK_ROWS = 8;
+uint16_t dmaStaging[SCREEN_WIDTH * PUSH_CHUNK_ROWS];
+
+// FNV-1a over whatever an element is drawn with. Floats are rounded to
+// sixteenths, so animations that have all but settled stop redrawing
+class ElementHash {
+  public:
+    ElementHash &add(int value) {
+      for (int byte = 0; byte < 4; byte++) {
+        _hash = (_hash ^ ((value >> (byte * 8)) & 0xFF)) * 16777619u;
+      }
+      return *this;
+    }
+
+    ElementHash &add(float value) { return add((int)lroundf(value * 16)); }
+    ElementHash &add(Angle value) { return add((int)value.getBam()); }
+
+    ElementHash &add(const char *text) {
+      while (*text) add((int)*text++);
+      return *this;
+    }
+
+    uint32_t get() { return _hash; }
+
+  private:
+    uint32_t _hash = 2166136261u;
+};
+
+// Stage outputs are blitted from here, they're at most 27px across. With the
+// strips and staging buffer the caches come to under 40 KB
+GlyphCache shapeCache = GlyphCache(32, 32, 8 * 1024);
+// Text and the piano
+GlyphCache wideCache = GlyphCache(96, 24, 14 * 1024);
+
+// Top byte of a wide cache key
+const uint64_t GLYPH_TEXT = 1ull << 56;
+const uint64_t GLYPH_PIANO = 2ull << 56;
+
+int pianoPipSpacing = 5;
+int pianoPipSize = 4;
+
+void buildPanelColours();
+void beginFrame(const SequenceSnapshot &snapshot, StageDrawInfo *stageDrawInfoById);
+void skipCleanTileRows();
+void renderNextStrip(int8_t stripIndex);
+void drawScene(const SequenceSnapshot &snapshot, StageDrawInfo *stageDrawInfoById);
+void updateDebugText(const SequenceSnapshot &snapshot);
+void updatePerfHud();
+void drawPerfHud();
+void drawText(const char *text, int32_t x, int32_t y, uint16_t colour);
+void drawNumber(long number, int32_t x, int32_t y, uint16_t colour);
+ScreenRect pianoBounds(Vec2 pos);
+ScreenRect pianoPipBounds(Vec2 pos, float highlightedPitch, float size);
 
 void drawStageOutput(float output, uint16_t colour, Vec2 pos);
-void drawPulses(Stage& stage, float angle, Vec2 pos, int8_t currentPulseInStage, GateMode gateMode, float pulseAnticipation);
-void drawHeldPulses(Stage& stage, float angle, Vec2 pos, float pulseAnticipation);
-void drawPulsePips(Stage& stage, float angle, Vec2 pos, int8_t currentPulseInStage, GateMode gateMode);
+void drawPulses(const StageSnapshot& stage, Angle angle, Vec2 pos, int8_t currentPulseInStage, GateMode gateMode, float pulseAnticipation);
+void drawPulsesElement(const StageSnapshot& stage, Angle angle, Vec2 pos, int8_t currentPulseInStage, GateMode gateMode, float pulseAnticipation, ElementHash hash);
+ScreenRect pulsesBounds(const StageSnapshot& stage, Angle angle, Vec2 pos);
+void drawHeldPulses(const StageSnapshot& stage, Angle angle, Vec2 pos, int8_t currentPulseInStage, float pulseAnticipation);
+void drawPulsePips(const StageSnapshot& stage, Angle angle, Vec2 pos, int8_t currentPulseInStage, GateMode gateMode);
 void drawStageStrikethrough(Vec2 pos);
-void drawPiano(Vec2 pos);
+ScreenRect strikethroughBounds(Vec2 pos);
+void drawPiano(TFT_eSprite *target, Vec2 pos);
+void drawCachedPiano(Vec2 pos);
 void drawPianoPip(Vec2 pos, float highlightedPitch, float size, uint16_t colour);
 
 void initScreen() {
@@ -37,135 +198,433 @@ void initScreen() {
   tft.initDMA();
   tft.setRotation(1);
   tft.fillScreen(COLOUR_BG);
-  screenPtrs[0] = (uint16_t*)screens[0].createSprite(SCREEN_WIDTH, SCREEN_HEIGHT);
-  screenPtrs[1] = (uint16_t*)screens[1].createSprite(SCREEN_WIDTH, SCREEN_HEIGHT);
-  screens[0].setTextDatum(MC_DATUM);
-  screens[1].setTextDatum(MC_DATUM);
+  strips[0].setColorDepth(8);
+  strips[1].setColorDepth(8);
+  stripPtrs[0] = (uint8_t*)strips[0].createSprite(SCREEN_WIDTH, STRIP_ROWS);
+  stripPtrs[1] = (uint8_t*)strips[1].createSprite(SCREEN_WIDTH, STRIP_ROWS);
+  buildPanelColours();
+  strips[0].setTextDatum(MC_DATUM);
+  strips[1].setTextDatum(MC_DATUM);
+  shapeCache.bgColour = COLOUR_BG;
+  wideCache.bgColour = COLOUR_BG;
+  shapeCache.begin(&tft);
+  wideCache.begin(&tft);
   tft.startWrite(); // TFT chip select held low permanently
 }
 
-float degreesPerStage(float stageCount) {
-  return 360 / stageCount;
+void buildPanelColours() {
+  // TFT_eSPI's own expansion, for the blends
+  const uint8_t blues[] = {0, 11, 21, 31};
+  for (int rgb332 = 0; rgb332 < 256; rgb332++) {
+    uint16_t colour = (rgb332 & 0xE0) << 8 | (rgb332 & 0xC0) << 5
+      | (rgb332 & 0x1C) << 6 | (rgb332 & 0x1C) << 3
+      | blues[rgb332 & 0x03];
+    panelColours[rgb332] = colour >> 8 | colour << 8;
+  }
+
+  for (uint16_t colour : PALETTE_COLOURS) {
+    panelColours[toRgb332(colour)] = colour >> 8 | colour << 8;
+  }
+}
+
+// Where stage index sits when they're spread evenly round the circle
+Angle stageAngle(size_t index, size_t stageCount) {
+  return Angle::fromBam(index * 0x10000 / stageCount);
+}
+
+FrameScheduler &getFrameScheduler() {
+  return frameScheduler;
+}
+
+bool formatGlyphCacheStats(uint8_t index, char *text, size_t size) {
+  switch (index) {
+    case 0: shapeCache.formatStats("shapes", text, size); return true;
+    case 1: wideCache.formatStats("wide", text, size); return true;
+    default: return false;
+  }
+}
+
+void resetGlyphCacheStats() {
+  shapeCache.resetStats();
+  wideCache.resetStats();
+}
+
+size_t getGlyphCacheBytes() {
+  return shapeCache.getBytes() + wideCache.getBytes();
 }
 
 void updateAnimations(
-  UndoRedoManager &undoRedoManager,
-  InteractionManager &interactionManager
+  const SequenceSnapshot &snapshot,
+  StageDrawInfo *stageDrawInfoById
 ) {
-  Sequence *sequence = undoRedoManager.getSequence();
+  PerfScope scope(PERF_ANIMATE);
+  uint defaultStagePositionRadius = 48 + 3 * snapshot.stageCount;
+
+  // A new clone starts off wherever its original is and eases out from there
+  uint16_t stageIds = 0;
+  for (size_t i = 0; i < snapshot.stageCount; i++) {
+    const StageSnapshot& stage = snapshot.stages[i];
+    bool isNew = !(animatedStageIds & (1 << stage.id));
+    bool isOriginalShown = animatedStageIds & (1 << stage.clonedFromId);
+
+    if (isNew && stage.clonedFromId != stage.id && isOriginalShown) {
+      stageDrawInfoById[stage.id] = stageDrawInfoById[stage.clonedFromId];
+    }
 
-  if ((millis() - lastAnimationTickMillis) > 16 || lastAnimationTickMillis == 0) {
-    lastAnimationTickMillis += 16;
+    stageIds |= 1 << stage.id;
+  }
+  animatedStageIds = stageIds;
+
+  // Targets are set every frame, but only ones that changed start anything easing
+  for (size_t i = 0; i < snapshot.stageCount; i++) {
+    const StageSnapshot& stage = snapshot.stages[i];
+    StageDrawInfo& stageDrawInfo = stageDrawInfoById[stage.id];
+    bool isHighlighted = snapshot.highlightedStageIndex == i || stage.isSelected;
+
+    // Update position
+    float targetRadius = defaultStagePositionRadius;
+    targetRadius += (isHighlighted ? 8 : 0);
+    if (snapshot.isEditingPosition) {
+      targetRadius += (isHighlighted ? 4 : -8);
+    }
 
-    uint defaultStagePositionRadius = 48 + 3 * sequence->stageCount();
+    if (snapshot.isInQuantizerConfig) {
+      targetRadius = 100;
+    }
 
-    for (size_t i = 0; i < sequence->stageCount(); i++) {
-      Stage& stage = sequence->getStage(i);
-      StageDrawInfo& stageDrawInfo = undoRedoManager.stageDrawInfoById[stage.id];
-      bool isHighlighted = interactionManager._highlightedStageIndex == i || stage.isSelected;
+    Angle targetAngle = stageAngle(i, snapshot.stageCount);
 
-      // Update position
-      float targetRadius = defaultStagePositionRadius;
-      targetRadius += (isHighlighted ? 8 : 0);
-      if (interactionManager._isEditingPosition) {
-        targetRadius += (isHighlighted ? 4 : -8);
-      }
+    bool isEditingGateModeOfThisStage = snapshot.isEditingGateMode && isHighlighted;
+    if (isEditingGateModeOfThisStage || !frameScheduler.isAnimatingPulsePips()) {
+      tweens.jumpTo(&stageDrawInfo.pulsePipsAngle, stage.pulsePipsAngle);
+    } else {
+      tweens.easeTo(&stageDrawInfo.pulsePipsAngle, stage.pulsePipsAngle);
+    }
 
-      if (undoRedoManager.isInQuantizerConfig) {
-        targetRadius = 100;
-      }
+    if (snapshot.isEditingPosition && isHighlighted) {
+      tweens.jumpTo(&stageDrawInfo.angle, targetAngle + Angle::fromDegrees(snapshot.hiddenValue));
+    } else {
+      tweens.easeTo(&stageDrawInfo.angle, targetAngle);
+    }
 
-      float targetAngle = i * degreesPerStage(sequence->stageCount());
-      if (interactionManager._isEditingPosition && isHighlighted) {
-        stageDrawInfo.angle = targetAngle + interactionManager._hiddenValue;
-      }
+    tweens.easeTo(&stageDrawInfo.radius, targetRadius);
 
-      bool isEditingGateModeOfThisStage = interactionManager.gateModeButtonHandler.isEditingGateMode() && (i == interactionManager._highlightedStageIndex || stage.isSelected);
-      if (isEditingGateModeOfThisStage) {
-        stageDrawInfo.pulsePipsAngle = stage.pulsePipsAngle;
-      } else {
-        stage.pulsePipsAngle = stage.gateMode * 90;
-        stageDrawInfo.pulsePipsAngle = stageDrawInfo.pulsePipsAngle + degBetweenAngles(stageDrawInfo.pulsePipsAngle, stage.pulsePipsAngle) * 0.1;
-      }
+    if (snapshot.isEditingPitch) {
+      tweens.jumpTo(&stageDrawInfo.output, stage.output);
+    } else {
+      tweens.easeTo(&stageDrawInfo.output, stage.output);
+    }
+  }
 
-      if (interactionManager._isEditingPosition && isHighlighted) {
-        stageDrawInfo.angle = targetAngle + interactionManager._hiddenValue;
-      } else {
-        stageDrawInfo.angle = stageDrawInfo.angle + degBetweenAngles(stageDrawInfo.angle, targetAngle) * 0.1;
-      }
+  tweens.update(getHal().getMillis());
+}
+
+// Nothing's easing and nothing's changed since the last frame, so drawing
+// another would come out the same. The perf HUD changes by itself
+bool isSceneAtRest(const SequenceSnapshot &snapshot) {
+  return tweens.isAtRest() && !snapshot.isShowingPerfHud
+    && memcmp(&snapshot, &frameSnapshot, offsetof(SequenceSnapshot, latestTraceId)) == 0;
+}
 
-      stageDrawInfo.radius = lerp(stageDrawInfo.radius, targetRadius, 0.1);
+// Adds an element while collecting, otherwise says whether it overlaps the rect being redrawn
+bool beginElement(const ScreenRect &bounds, uint32_t hash) {
+  if (isCollectingElements) {
+    // Off the edge of the round panel, it'll never be seen
+    if (!RoundScreen::isVisible(bounds)) return false;
 
-      uint curStagePulseTally = undoRedoManager.stagePulseTallyById[stage.id];
-      if (interactionManager.pitchButtonHandler.isEditingPitch()) {
-        stageDrawInfo.output = stage.getOutput(curStagePulseTally);
-      } else {
-        stageDrawInfo.output = lerp(stageDrawInfo.output, stage.getOutput(curStagePulseTally), 0.1);
+    size_t &count = screenElementCounts[curElementsIndex];
+    if (count < MAX_SCREEN_ELEMENTS) {
+      screenElements[curElementsIndex][count] = {bounds, hash};
+    }
+
+    // Counting past the end is noticed later, and redraws everything
+    count++;
+    return false;
+  }
+
+  return bounds.intersects(drawClipRect);
+}
+
+// The bounds of an arc from drawArc, whose angles start at 6 o'clock. Its
+// ends are squared off, so the inner corners can reach past the outer ones
+ScreenRect arcBounds(Vec2 center, float radius, float innerRadius, float startAngle, float endAngle) {
+  Vec2 corners[] = {
+    Vec2::fromPolar(radius, startAngle - 180) + center, Vec2::fromPolar(radius, endAngle - 180) + center,
+    Vec2::fromPolar(innerRadius, startAngle - 180) + center, Vec2::fromPolar(innerRadius, endAngle - 180) + center
+  };
+  // The ends are anti-aliased a pixel past the corners
+  ScreenRect bounds = ScreenRect::around(corners[0].x, corners[0].y, 1, 1);
+  for (Vec2 corner : corners) {
+    bounds = bounds.unite(ScreenRect::around(corner.x, corner.y, 1, 1));
+  }
+
+  // The arc bulges out furthest wherever it crosses an axis
+  float sweep = fwrap(endAngle - startAngle, 0, 360);
+  for (int axisAngle = 0; axisAngle < 360; axisAngle += 90) {
+    if (fwrap(axisAngle - startAngle, 0, 360) <= sweep) {
+      Vec2 crossing = Vec2::fromPolar(radius, axisAngle - 180) + center;
+      bounds = bounds.unite(ScreenRect::around(crossing.x, crossing.y, 1, 1));
+    }
+  }
+
+  return bounds;
+}
+
+// Copies the next bit of the strip being sent into the staging buffer and
+// starts DMA on it. The strip's free to draw into again as soon as its last
+// bit is copied. False once there's nothing left to send
+bool pushNextChunk() {
+  while (pushStripIndex != -1) {
+    StripState &strip = stripStates[pushStripIndex];
+    uint8_t *stripPixels = stripPtrs[pushStripIndex];
+
+    // Each run of dirty tiles goes on its own
+    int16_t firstColumn = __builtin_ctz(pushColumns);
+    int16_t runLength = __builtin_ctz(~(pushColumns >> firstColumn));
+    int16_t rowCount = min(PUSH_CHUNK_ROWS, STRIP_ROWS - pushRow);
+    int16_t stripRow = pushRow;
+    int16_t y = strip.y + stripRow;
+    ScreenSpan columns = RoundScreen::getVisibleColumns({
+      (int16_t)(firstColumn * DirtyTiles::TILE_SIZE), y, (int16_t)(runLength * DirtyTiles::TILE_SIZE), rowCount
+    });
+
+    pushRow += rowCount;
+    if (pushRow >= STRIP_ROWS) {
+      pushRow = 0;
+      pushColumns &= ~(((1u << runLength) - 1) << firstColumn);
+    }
+
+    if (pushColumns == 0) {
+      strip.isRendered = false;
+      pushStripIndex = -1;
+    }
+
+    // All of these rows are past the edge of the panel
+    if (columns.isEmpty()) continue;
+
+    int16_t width = columns.length();
+    uint16_t *staged = dmaStaging;
+    for (int16_t row = 0; row < rowCount; row++) {
+      const uint8_t *pixel = &stripPixels[(stripRow + row) * SCREEN_WIDTH + columns.start - strip.clipX];
+      for (int16_t column = 0; column < width; column++) {
+        *staged++ = panelColours[*pixel++];
       }
     }
+
+    tft.pushImageDMA(columns.start, y, width, rowCount, dmaStaging);
+    return true;
   }
+
+  return false;
 }
 
-void swapScreenBuffer() {
-  curScreenIndex = !curScreenIndex;
-  curScreen = &screens[curScreenIndex];
+// Starts sending the next drawn strip, if there is one. Strips are drawn top
+// to bottom, so the highest one has been waiting longest
+void startPushingStrip() {
+  if (pushStripIndex != -1) return;
+
+  for (int8_t i = 0; i < 2; i++) {
+    if (!stripStates[i].isRendered) continue;
+
+    if (pushStripIndex == -1 || stripStates[i].y < stripStates[pushStripIndex].y) {
+      pushStripIndex = i;
+    }
+  }
+
+  if (pushStripIndex != -1) {
+    pushColumns = stripStates[pushStripIndex].columns;
+    pushRow = 0;
+  }
 }
 
-void renderIfDmaIsReady(
-  UndoRedoManager &undoRedoManager,
-  InteractionManager &interactionManager,
-  const std::vector<Button*> &activeButtons
+void updateDisplay(
+  const SequenceSnapshot &snapshot,
+  StageDrawInfo *stageDrawInfoById
 ) {
-  if (!tft.dmaBusy()) {
-    int32_t frameStartMillis = millis();
-
-    tft.pushImageDMA(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, screenPtrs[curScreenIndex]);
-    swapScreenBuffer();
-    render(
-      undoRedoManager, 
-      interactionManager,
-      activeButtons
-    );
+  bool isFrameDue = frameScheduler.isFrameDue(getHal().getMicros());
+  if (isFrameDue && !isWaitingForDma) {
+    isWaitingForDma = true;
+    dmaWaitStartCycles = getHal().getCycleCount();
+  }
+
+  if (isFrameDue && !isFrameInProgress) {
+    getPerfStats().record(PERF_DMA_WAIT, getHal().getCycleCount() - dmaWaitStartCycles);
+    isWaitingForDma = false;
+
+    if (isSceneAtRest(snapshot)) {
+      frameScheduler.skipFrame(getHal().getMicros());
+
+      // Whatever came in didn't change anything. If a frame's still going out, they go with it
+      if (sentTraceId == drawnTraceId) sentTraceId = snapshot.latestTraceId;
+      drawnTraceId = snapshot.latestTraceId;
+    } else {
+      beginFrame(snapshot, stageDrawInfoById);
+    }
+  }
+
+  // Keep the display busy, then draw the next strip while it goes
+  if (!tft.dmaBusy() && !pushNextChunk()) {
+    startPushingStrip();
+    pushNextChunk();
+  }
+
+  if (isFrameInProgress) {
+    for (int8_t i = 0; i < 2; i++) {
+      if (!stripStates[i].isRendered) {
+        renderNextStrip(i);
+        break;
+      }
+    }
+  }
+
+  if (!tft.dmaBusy() && !pushNextChunk()) {
+    startPushingStrip();
+    pushNextChunk();
+  }
 
-    msPerFrame = msPerFrame * 0.9 + (millis() - frameStartMillis) * 0.1;
+  // Done once everything's been drawn and copied out to send
+  bool isFrameDone = nextTileRow >= DirtyTiles::TILES_PER_SIDE
+    && !stripStates[0].isRendered && !stripStates[1].isRendered;
 
-    int32_t deltaMillis = millis() - lastFrameMillis;
-    fps = fps * 0.9 + (100000 / deltaMillis * 0.1);
+  if (isFrameInProgress && isFrameDone) {
+    isFrameInProgress = false;
+    frameScheduler.endFrame(getHal().getMicros());
+    getPerfStats().endFrame();
+  }
 
-    lastFrameMillis = millis();
+  // The last of it's reached the display
+  if (!isFrameInProgress && pushStripIndex == -1 && !tft.dmaBusy() && sentTraceId != drawnTraceId) {
+    getLatencyTracer().recordOldest(LATENCY_SCREEN, sentTraceId, drawnTraceId, getHal().getMicros());
+    sentTraceId = drawnTraceId;
   }
 }
 
-void render(
-    UndoRedoManager &undoRedoManager,
-    InteractionManager &interactionManager,
-    const std::vector<Button*> &activeButtons
+bool isDisplayUpToDate() {
+  return !isFrameInProgress && pushStripIndex == -1 && !frameScheduler.isFrameDue(getHal().getMicros());
+}
+
+// Steps the animations, works out what's changed since the last frame, and
+// sets up the strips that need drawing
+void beginFrame(
+    const SequenceSnapshot &snapshot,
+    StageDrawInfo *stageDrawInfoById
 ) {
-  Sequence *sequence = undoRedoManager.getSequence();
+  frameScheduler.beginFrame(getHal().getMicros());
+  getLatencyTracer().recordOldest(LATENCY_RENDER, drawnTraceId, snapshot.latestTraceId, getHal().getMicros());
+  drawnTraceId = snapshot.latestTraceId;
+
+  updateAnimations(snapshot, stageDrawInfoById);
+  frameScheduler.endPhase(PHASE_ANIMATE, getHal().getMicros());
+  updateDebugText(snapshot);
+  if (snapshot.isShowingPerfHud) updatePerfHud();
+
+  frameSnapshot = snapshot;
+  frameStageDrawInfoById = stageDrawInfoById;
+
+  // Find out what's on screen this frame
+  curElementsIndex = !curElementsIndex;
+  screenElementCounts[curElementsIndex] = 0;
+  isCollectingElements = true;
+  drawScene(frameSnapshot, frameStageDrawInfoById);
+  isCollectingElements = false;
+
+  // Anything that moved or changed is dirty where it was and where it is now.
+  // Elements are matched up by the order they're drawn in
+  const ScreenElement *elements = screenElements[curElementsIndex];
+  const ScreenElement *lastElements = screenElements[!curElementsIndex];
+  size_t elementCount = screenElementCounts[curElementsIndex];
+  size_t lastElementCount = screenElementCounts[!curElementsIndex];
+
+  frameTiles.clear();
+  if (elementCount > MAX_SCREEN_ELEMENTS || lastElementCount > MAX_SCREEN_ELEMENTS) {
+    frameTiles.markAll();
+  } else {
+    for (size_t i = 0; i < max(elementCount, lastElementCount); i++) {
+      bool isSame = i < elementCount && i < lastElementCount
+        && elements[i].hash == lastElements[i].hash
+        && memcmp(&elements[i].bounds, &lastElements[i].bounds, sizeof(ScreenRect)) == 0;
+      if (isSame) continue;
+
+      if (i < elementCount) frameTiles.mark(elements[i].bounds);
+      if (i < lastElementCount) frameTiles.mark(lastElements[i].bounds);
+    }
+  }
+
+  nextTileRow = 0;
+  skipCleanTileRows();
+  isFrameInProgress = true;
+  frameScheduler.endPhase(PHASE_DIFF, getHal().getMicros());
+  if (nextTileRow >= DirtyTiles::TILES_PER_SIDE) frameScheduler.endPhase(PHASE_DRAW, getHal().getMicros());
 
-  curScreen->fillSprite(COLOUR_BG);
+  // Frames can take under a millisecond now that most of the screen is left alone
+  int32_t deltaMillis = getHal().getMillis() - lastFrameMillis;
+  if (deltaMillis < 1) deltaMillis = 1;
+  fps = fps * 0.9 + (100000 / deltaMillis * 0.1);
 
-  float targetDegreesPerStage = 360 / (float)sequence->stageCount();
+  lastFrameMillis = getHal().getMillis();
+}
+
+void skipCleanTileRows() {
+  while (nextTileRow < DirtyTiles::TILES_PER_SIDE && frameTiles.getRow(nextTileRow) == 0) {
+    nextTileRow++;
+  }
+}
+
+// Draws the next row of tiles with anything dirty on it into the strip
+void renderNextStrip(int8_t stripIndex) {
+  if (nextTileRow >= DirtyTiles::TILES_PER_SIDE) return;
+
+  // Drawn from the first dirty tile to the last, only the dirty ones get sent
+  uint16_t columns = frameTiles.getRow(nextTileRow);
+  int16_t firstColumn = __builtin_ctz(columns);
+  int16_t lastColumn = 31 - __builtin_clz(columns);
+  drawClipRect = {
+    (int16_t)(firstColumn * DirtyTiles::TILE_SIZE), (int16_t)(nextTileRow * STRIP_ROWS),
+    (int16_t)((lastColumn - firstColumn + 1) * DirtyTiles::TILE_SIZE), STRIP_ROWS
+  };
+
+  curScreen = &strips[stripIndex];
+  curScreen->setViewport(-drawClipRect.x, -drawClipRect.y, drawClipRect.x + drawClipRect.w, drawClipRect.y + STRIP_ROWS, true);
+
+  // Only clear what the panel shows, the corners are never sent
+  {
+    PerfScope scope(PERF_CLEAR);
+    for (int16_t y = drawClipRect.y; y < drawClipRect.y + drawClipRect.h; y++) {
+      ScreenSpan span = RoundScreen::getSpan(y).intersect(drawClipRect.x, drawClipRect.x + drawClipRect.w);
+      if (!span.isEmpty()) {
+        curScreen->drawFastHLine(span.start, y, span.length(), COLOUR_BG);
+      }
+    }
+  }
 
+  drawScene(frameSnapshot, frameStageDrawInfoById);
+
+  stripStates[stripIndex] = {true, drawClipRect.y, columns, drawClipRect.x};
+  nextTileRow++;
+  skipCleanTileRows();
+
+  if (nextTileRow >= DirtyTiles::TILES_PER_SIDE) frameScheduler.endPhase(PHASE_DRAW, getHal().getMicros());
+}
+
+void drawScene(
+    const SequenceSnapshot &snapshot,
+    StageDrawInfo *stageDrawInfoById
+) {
   // Beat Indicator
   if (true) {
-    size_t nextStageIndex = sequence->getNextStageIndex();
-    Stage &activeStage = sequence->getActiveStage();
-    StageDrawInfo& activeStageDrawInfo = undoRedoManager.stageDrawInfoById[activeStage.id];
-    Stage &nextStage = sequence->getStage(nextStageIndex);
-    StageDrawInfo& nextStageDrawInfo = undoRedoManager.stageDrawInfoById[nextStage.id];
-    float angle = activeStageDrawInfo.angle;
+    const StageSnapshot &activeStage = snapshot.stages[snapshot.activeStageIndex];
+    StageDrawInfo& activeStageDrawInfo = stageDrawInfoById[activeStage.id];
+    const StageSnapshot &nextStage = snapshot.stages[snapshot.nextStageIndex];
+    StageDrawInfo& nextStageDrawInfo = stageDrawInfoById[nextStage.id];
+    Angle angle = activeStageDrawInfo.angle;
     float polarRadius = activeStageDrawInfo.radius;
-    float progress = powf(sequence->getPulseAnticipation(), 2);
-
-    if (sequence->isLastPulseOfStage()) {
-      auto degToNextStage = degBetweenAngles(angle, nextStageDrawInfo.angle);
+    float progress = powf(snapshot.pulseAnticipation, 2);
 
-      if (degToNextStage < 0) {
-        degToNextStage += 360; 
-      }
+    if (snapshot.isLastPulseOfStage) {
+      // Always clockwise
+      uint16_t toNextStage = (nextStageDrawInfo.angle - angle).getBam();
 
-      angle += degToNextStage * powf(progress, 2);
+      angle += Angle::fromBam(lroundf(toNextStage * powf(progress, 2)));
       polarRadius = lerp(activeStageDrawInfo.radius, nextStageDrawInfo.radius, powf(progress, 2));
     } 
     
@@ -175,7 +634,7 @@ void render(
     if (activeStage.gateMode == HELD) {
       // Held note
       radius = 12 + 4 * powf(1 - progress, 3);
-    } else if (activeStage.isPulseActive(sequence->getCurrentPulseInStage())) {
+    } else if (!activeStage.isSkipped && isPulseActive(snapshot.currentPulseInStage, activeStage.gateMode)) {
       // Active pulse
       radius = 2 + 16 * (1 - progress);
     } else {
@@ -183,16 +642,22 @@ void render(
       radius = 10 + 2 * (1 - progress);
     }
 
-    curScreen->fillCircle(pos.x, pos.y, radius, COLOUR_BEAT);
+    // fillCircle works in whole pixels
+    int x = pos.x;
+    int y = pos.y;
+
+    if (beginElement(ScreenRect::around(x, y, radius, radius), ElementHash().add(x).add(y).add((int)radius).get())) {
+      curScreen->fillCircle(x, y, radius, COLOUR_BEAT);
+    }
   }
 
   // Stages
-  for (size_t i = 0; i < sequence->stageCount(); i++) {
-    Stage& curStage = sequence->getStage(i);
-    StageDrawInfo& stageDrawInfo = undoRedoManager.stageDrawInfoById[curStage.id];
+  for (size_t i = 0; i < snapshot.stageCount; i++) {
+    const StageSnapshot& curStage = snapshot.stages[i];
+    StageDrawInfo& stageDrawInfo = stageDrawInfoById[curStage.id];
 
-    bool isActive = sequence->indexOfActiveStage() == i;
-    bool isHighlighted = interactionManager._highlightedStageIndex == i || curStage.isSelected;
+    bool isActive = snapshot.activeStageIndex == i;
+    bool isHighlighted = snapshot.highlightedStageIndex == i || curStage.isSelected;
 
     Vec2 stagePos = Vec2::fromPolar(stageDrawInfo.radius, stageDrawInfo.angle) + screenCenter;
 
@@ -209,72 +674,109 @@ void render(
     
     // Slide indicator
     if (curStage.shouldSlideIn) {
-      float endAngle = wrapDeg(180 + stageDrawInfo.angle);
-      float degToStartAngle = -targetDegreesPerStage * 0.75f;
-      float startAngle = wrapDeg(endAngle + degToStartAngle);
-
-      curScreen->drawArc(
-        screenCenter.x, screenCenter.y, // Position
-        stageDrawInfo.radius + 1, stageDrawInfo.radius - 1, // Radius, Inner Radius
-        startAngle, endAngle, // Arc start & end 
-        COLOUR_SKIPPED, COLOUR_BG, // Colour, AA Colour
-        false // Smoothing
-      );
-
-      if (isActive && sequence->isSliding()) {
+      // drawArc starts from the bottom
+      Angle end = stageDrawInfo.angle + Angle::fromBam(Angle::HALF_TURN);
+      Angle sweep = Angle::fromBam(3 * Angle::QUARTER_TURN / snapshot.stageCount);
+      Angle start = end - sweep;
+      float endAngle = end.toDegrees();
+      float startAngle = start.toDegrees();
+      bool isSlidingIn = isActive && snapshot.isSliding;
+
+      ElementHash hash = ElementHash().add(stageDrawInfo.radius).add(start).add(end);
+      if (isSlidingIn) hash.add(snapshot.pulseAnticipation);
+
+      if (beginElement(arcBounds(screenCenter, stageDrawInfo.radius + 1, stageDrawInfo.radius - 1, startAngle, endAngle), hash.get())) {
+        PerfScope scope(PERF_ARCS);
         curScreen->drawArc(
           screenCenter.x, screenCenter.y, // Position
           stageDrawInfo.radius + 1, stageDrawInfo.radius - 1, // Radius, Inner Radius
-          startAngle, wrapDeg(startAngle - degToStartAngle * sequence->getPulseAnticipation()), // Arc start & end 
-          COLOUR_ACTIVE, COLOUR_BG, // Colour, AA Colour
+          startAngle, endAngle, // Arc start & end 
+          COLOUR_SKIPPED, COLOUR_BG, // Colour, AA Colour
           false // Smoothing
         );
+
+        if (isSlidingIn) {
+          curScreen->drawArc(
+            screenCenter.x, screenCenter.y, // Position
+            stageDrawInfo.radius + 1, stageDrawInfo.radius - 1, // Radius, Inner Radius
+            startAngle, (start + Angle::fromBam(lroundf(sweep.getBam() * snapshot.pulseAnticipation))).toDegrees(), // Arc start & end 
+            COLOUR_ACTIVE, COLOUR_BG, // Colour, AA Colour
+            false // Smoothing
+          );
+        }
       }
     }
 
-    drawStageOutput(stageDrawInfo.output, colour, stagePos);
+    bool isEditingGateModeOfThisStage = snapshot.isEditingGateMode && isHighlighted;
+    bool arePulsePipsAnimating = abs(stageDrawInfo.pulsePipsAngle.degreesTo(curStage.pulsePipsAngle)) > 10;
+    bool isShowingAllGateModes = isEditingGateModeOfThisStage || arePulsePipsAnimating;
+    int8_t currentPulseInStage = isActive ? snapshot.currentPulseInStage : -1;
+    Angle pipsAngle = stageDrawInfo.angle + stageDrawInfo.pulsePipsAngle;
+
+    // The output, each gate mode's pulses and the strikethrough are elements of
+    // their own, so the playhead passing a stage only redraws the pips it lights
+    ElementHash outputHash = ElementHash().add(stagePos.x).add(stagePos.y).add(stageDrawInfo.output).add(colour);
+    if (beginElement(ScreenRect::around(stagePos.x, stagePos.y, shapeCache.getWidth() / 2, shapeCache.getHeight() / 2), outputHash.get())) {
+      PerfScope scope(PERF_STAGES);
+      drawStageOutput(stageDrawInfo.output, colour, stagePos);
+    }
 
-    bool isEditingGateModeOfThisStage = interactionManager.gateModeButtonHandler.isEditingGateMode() && (i == interactionManager._highlightedStageIndex || curStage.isSelected);
-    bool arePulsePipsAnimating = abs(degBetweenAngles(stageDrawInfo.pulsePipsAngle, curStage.pulsePipsAngle)) > 10;
+    bool isDrawingHeldPulses = curStage.gateMode == HELD || isShowingAllGateModes;
+    ElementHash pulsesHash = ElementHash()
+      .add(stagePos.x).add(stagePos.y).add(pipsAngle).add(curStage.pulseCount)
+      .add(currentPulseInStage).add(curStage.isSkipped);
 
-    if (curStage.gateMode == EACH || isEditingGateModeOfThisStage || arePulsePipsAnimating) {
-      drawPulses(curStage, stageDrawInfo.angle + stageDrawInfo.pulsePipsAngle, stagePos, isActive ? sequence->getCurrentPulseInStage() : -1, EACH, sequence->getPulseAnticipation());
+    if (curStage.gateMode == EACH || isShowingAllGateModes) {
+      drawPulsesElement(curStage, pipsAngle, stagePos, currentPulseInStage, EACH, snapshot.pulseAnticipation, pulsesHash);
     }
 
-    if (curStage.gateMode == HELD || isEditingGateModeOfThisStage || arePulsePipsAnimating) {
-      drawPulses(curStage, stageDrawInfo.angle - 90 + stageDrawInfo.pulsePipsAngle, stagePos, isActive ? sequence->getCurrentPulseInStage() : -1, HELD, sequence->getPulseAnticipation());
+    if (isDrawingHeldPulses) {
+      drawPulsesElement(curStage, pipsAngle - Angle::fromBam(Angle::QUARTER_TURN), stagePos, currentPulseInStage, HELD, snapshot.pulseAnticipation, pulsesHash);
     }
 
-    if (curStage.gateMode == FIRST || isEditingGateModeOfThisStage || arePulsePipsAnimating) {
-      drawPulses(curStage, stageDrawInfo.angle - 180 + stageDrawInfo.pulsePipsAngle, stagePos, isActive ? sequence->getCurrentPulseInStage() : -1, FIRST, sequence->getPulseAnticipation());
+    if (curStage.gateMode == FIRST || isShowingAllGateModes) {
+      drawPulsesElement(curStage, pipsAngle - Angle::fromBam(Angle::HALF_TURN), stagePos, currentPulseInStage, FIRST, snapshot.pulseAnticipation, pulsesHash);
     }
 
-    if (curStage.gateMode == NONE || isEditingGateModeOfThisStage || arePulsePipsAnimating) {
-      drawPulses(curStage, stageDrawInfo.angle - 270 + stageDrawInfo.pulsePipsAngle, stagePos, isActive ? sequence->getCurrentPulseInStage() : -1, NONE, sequence->getPulseAnticipation());
+    if (curStage.gateMode == NONE || isShowingAllGateModes) {
+      drawPulsesElement(curStage, pipsAngle + Angle::fromBam(Angle::QUARTER_TURN), stagePos, currentPulseInStage, NONE, snapshot.pulseAnticipation, pulsesHash);
     }
 
-    if (curStage.isSkipped) { drawStageStrikethrough(stagePos); }
+    if (curStage.isSkipped && beginElement(strikethroughBounds(stagePos), ElementHash().add(stagePos.x).add(stagePos.y).get())) {
+      drawStageStrikethrough(stagePos);
+    }
 
     // Selected indicator
     if (curStage.isSelected) {
       Vec2 selectionPipPos = Vec2::fromPolar(stageDrawInfo.radius + 16, stageDrawInfo.angle) + screenCenter;
-
-      curScreen->fillCircle(
-        selectionPipPos.x, selectionPipPos.y, // Position,
-        2,
-        COLOUR_USER
-      );
+      int x = selectionPipPos.x;
+      int y = selectionPipPos.y;
+
+      if (beginElement(ScreenRect::around(x, y, 2, 2), ElementHash().add(x).add(y).get())) {
+        curScreen->fillCircle(
+          x, y, // Position,
+          2,
+          COLOUR_USER
+        );
+      }
     }
   }
 
   // Cursor
-  curScreen->drawArc(
-    SCREEN_HALF_WIDTH, SCREEN_HALF_HEIGHT, // Position
-    SCREEN_HALF_WIDTH + 2, SCREEN_HALF_WIDTH - 5, // Radius, Inner Radius
-    fwrap(interactionManager._cursorAngle + 180 - 4, 0, 360), fwrap(interactionManager._cursorAngle + 180 + 4, 0, 360), // Arc start & end 
-    COLOUR_USER, COLOUR_BG, // Colour, AA Colour
-    false // Smoothing
-  );
+  Angle cursorCentre = snapshot.cursorAngle + Angle::fromBam(Angle::HALF_TURN);
+  float cursorStartAngle = (cursorCentre - Angle::fromDegrees(4)).toDegrees();
+  float cursorEndAngle = (cursorCentre + Angle::fromDegrees(4)).toDegrees();
+
+  if (beginElement(arcBounds(screenCenter, SCREEN_HALF_WIDTH + 2, SCREEN_HALF_WIDTH - 5, cursorStartAngle, cursorEndAngle), ElementHash().add(snapshot.cursorAngle).get())) {
+    PerfScope scope(PERF_ARCS);
+    curScreen->drawArc(
+      SCREEN_HALF_WIDTH, SCREEN_HALF_HEIGHT, // Position
+      SCREEN_HALF_WIDTH + 2, SCREEN_HALF_WIDTH - 5, // Radius, Inner Radius
+      cursorStartAngle, cursorEndAngle, // Arc start & end 
+      COLOUR_USER, COLOUR_BG, // Colour, AA Colour
+      false // Smoothing
+    );
+  }
   
   // if (gpio_get(4)) {
   //   // BPM
@@ -283,57 +785,170 @@ void render(
   //   curScreen->drawString("bpm", screenCenter.x, screenCenter.y + 6, 2);
   // }
 
-  if (interactionManager.pitchButtonHandler.isEditingPitch()) {
-    drawPiano(screenCenter);
-    
-    for (size_t i = 0; i < sequence->stageCount(); i++) {
-      Stage& curStage = sequence->getStage(i);
-      bool isHighlighted = interactionManager._highlightedStageIndex == i || curStage.isSelected;
+  if (snapshot.isEditingPitch) {
+    ElementHash hash;
+    for (size_t i = 0; i < snapshot.stageCount; i++) {
+      const StageSnapshot& curStage = snapshot.stages[i];
+      // In pixels along the keys, a sixteenth of an octave would be nearly 4
+      if (snapshot.highlightedStageIndex == i || curStage.isSelected) hash.add(curStage.baseOutput * 12 * pianoPipSpacing);
+    }
 
-      if (isHighlighted) {
-        drawPianoPip(screenCenter, curStage.getBaseOutput() * 12, 3, COLOUR_USER);
+    if (beginElement(pianoBounds(screenCenter), hash.get())) {
+      drawCachedPiano(screenCenter);
+      
+      for (size_t i = 0; i < snapshot.stageCount; i++) {
+        const StageSnapshot& curStage = snapshot.stages[i];
+        bool isHighlighted = snapshot.highlightedStageIndex == i || curStage.isSelected;
+
+        if (isHighlighted) {
+          drawPianoPip(screenCenter, curStage.baseOutput * 12, 3, COLOUR_USER);
+        }
       }
     }
   }
 
-  if (undoRedoManager.isInQuantizerConfig) {
-    drawPiano(screenCenter);
+  if (snapshot.isInQuantizerConfig) {
+    ElementHash hash = ElementHash().add((int)snapshot.scaleStepMask).add(snapshot.scaleDivisions).add(snapshot.quantizerConfigCursorPos);
+
+    if (beginElement(pianoBounds(screenCenter), hash.get())) {
+      drawCachedPiano(screenCenter);
 
-    // Enabled keys 
-    for (int i = 0; i < 12; i++) {
-      if (sequence->quantizer[i]) {
-        drawPianoPip(screenCenter, i, 4, COLOUR_INACTIVE);
+      // Enabled steps, which land between the keys for scales that aren't 12-TET
+      for (int i = 0; i < snapshot.scaleDivisions; i++) {
+        if ((snapshot.scaleStepMask >> i) & 1) {
+          drawPianoPip(screenCenter, i * 12.f / snapshot.scaleDivisions, 4, COLOUR_INACTIVE);
+        }
       }
+
+      // User's cursor
+      drawPianoPip(screenCenter, snapshot.quantizerConfigCursorPos, 2, COLOUR_USER);
     }
 
-    // User's cursor
-    drawPianoPip(screenCenter, interactionManager._quantizerConfigCursorPos, 2, COLOUR_USER);
+    drawText(snapshot.scaleName, screenCenter.x, screenCenter.y + 50, COLOUR_INACTIVE);
   }
 
-  if(sequence->getGate()) {
-    drawPianoPip(screenCenter, sequence->getMidiNote(), 2, COLOUR_ACTIVE);
+  // There whether the gate's on or not, so the elements after it keep their places as it flickers
+  if (beginElement(pianoPipBounds(screenCenter, snapshot.midiNote, 2), ElementHash().add(snapshot.gate).add(snapshot.midiNote).get()) && snapshot.gate) {
+    drawPianoPip(screenCenter, snapshot.midiNote, 2, COLOUR_ACTIVE);
   }
   
   // FPS
-  curScreen->setTextColor(COLOUR_INACTIVE);
-  curScreen->drawNumber(fps/100, screenCenter.x, 12, 2);
-  curScreen->drawString("fps", screenCenter.x, 24, 2);
+  drawNumber(shownFps, screenCenter.x, 12, COLOUR_INACTIVE);
+  drawText("fps", screenCenter.x, 24, COLOUR_INACTIVE);
 
   // ms/frame
-  curScreen->setTextColor(COLOUR_INACTIVE);
-  curScreen->drawNumber(msPerFrame, screenCenter.x, SCREEN_HEIGHT - 12, 2);
-  curScreen->drawString("ms/frame", screenCenter.x, SCREEN_HEIGHT - 24, 2);
+  drawNumber(shownMsPerFrame, screenCenter.x, SCREEN_HEIGHT - 12, COLOUR_INACTIVE);
+  drawText("ms/frame", screenCenter.x, SCREEN_HEIGHT - 24, COLOUR_INACTIVE);
 
   // Debug
-  for (int i = 0; i < activeButtons.size(); i++) {
+  for (int i = 0; i < shownCommandCount; i++) {
     Vec2 pos = Vec2::fromPolar(SCREEN_HALF_WIDTH - 25, 290 - i * 10) + screenCenter;
 
-    curScreen->setTextColor(COLOUR_INACTIVE);
-    curScreen->drawString(toString(activeButtons[i]->_command), pos.x, pos.y, 2);
+    drawText(toString(shownCommands[i]), pos.x, pos.y, COLOUR_INACTIVE);
   }
+
+  if (snapshot.isShowingPerfHud) drawPerfHud();
 }
 
-void drawPulsePips(Stage& stage, float angle, Vec2 pos, int8_t currentPulseInStage, GateMode gateMode) {
+void updatePerfHud() {
+  int32_t nowMillis = getHal().getMillis();
+  if (nowMillis - lastPerfHudMillis < 500) return;
+  lastPerfHudMillis = nowMillis;
+
+  PerfStats &perfStats = getPerfStats();
+  for (uint8_t counter = 0; counter < PERF_COUNTER_COUNT; counter++) {
+    PerfHistogram &histogram = perfStats.get((PerfCounter)counter);
+
+    perfHudRows[counter] = {
+      lroundf(perfStats.cyclesToMicros(histogram.getMinCycles())),
+      lroundf(perfStats.cyclesToMicros(histogram.getMeanCycles())),
+      lroundf(perfStats.cyclesToMicros(histogram.getPercentileCycles(0.99f)))
+    };
+  }
+}
+
+// A table of min, mean and p99 microseconds for each counter, over the middle of the screen
+void drawPerfHud() {
+  const int16_t rowHeight = 16;
+  const int16_t top = screenCenter.y - (PERF_COUNTER_COUNT + 1) * rowHeight / 2 + rowHeight / 2;
+  const int16_t nameX = screenCenter.x - 52;
+  const int16_t columnXs[] = {(int16_t)(screenCenter.x + 6), (int16_t)(screenCenter.x + 38), (int16_t)(screenCenter.x + 70)};
+
+  // Blanks out whatever's behind it so it can be read
+  ScreenRect bounds = ScreenRect::around(screenCenter.x, screenCenter.y, 96, (PERF_COUNTER_COUNT + 1) * rowHeight / 2 + 2);
+  if (beginElement(bounds, 0)) {
+    curScreen->fillRect(bounds.x, bounds.y, bounds.w, bounds.h, COLOUR_BG);
+  }
+
+  drawText("us", nameX, top, COLOUR_INACTIVE);
+  drawText("min", columnXs[0], top, COLOUR_INACTIVE);
+  drawText("avg", columnXs[1], top, COLOUR_INACTIVE);
+  drawText("p99", columnXs[2], top, COLOUR_INACTIVE);
+
+  for (uint8_t counter = 0; counter < PERF_COUNTER_COUNT; counter++) {
+    int16_t y = top + (counter + 1) * rowHeight;
+    const PerfHudRow &row = perfHudRows[counter];
+
+    drawText(PerfStats::getName((PerfCounter)counter), nameX, y, COLOUR_INACTIVE);
+    drawNumber(row.minMicros, columnXs[0], y, COLOUR_USER);
+    drawNumber(row.meanMicros, columnXs[1], y, COLOUR_USER);
+    drawNumber(row.p99Micros, columnXs[2], y, COLOUR_USER);
+  }
+}
+
+// Every frame, unless frames are over budget, then only every so often
+void updateDebugText(const SequenceSnapshot &snapshot) {
+  int32_t nowMillis = getHal().getMillis();
+  if (nowMillis - lastDebugTextMillis < (int32_t)frameScheduler.getDebugTextMillis()) return;
+  lastDebugTextMillis = nowMillis;
+
+  shownFps = fps / 100;
+  shownMsPerFrame = frameScheduler.getFrameMicros() / 1000;
+  shownCommandCount = snapshot.activeCommandCount;
+  std::copy(snapshot.activeCommands, snapshot.activeCommands + snapshot.activeCommandCount, shownCommands);
+}
+
+// Text is drawn centred in font 2, which is 16px tall
+void drawText(const char *text, int32_t x, int32_t y, uint16_t colour) {
+  int16_t width = curScreen->textWidth(text, 2);
+
+  if (!beginElement(ScreenRect::around(x, y, width / 2 + 1, 8), ElementHash().add(text).add(x).add(y).add(colour).get())) return;
+  PerfScope scope(PERF_TEXT);
+
+  // Too long for the cache
+  if (width > wideCache.getWidth()) {
+    curScreen->setTextColor(colour);
+    curScreen->drawString(text, x, y, 2);
+    return;
+  }
+
+  // FNV-1a, with the colour on top
+  uint64_t textHash = 14695981039346656037ull;
+  for (const char *c = text; *c; c++) {
+    textHash = (textHash ^ (uint8_t)*c) * 1099511628211ull;
+  }
+  uint64_t key = GLYPH_TEXT | ((uint64_t)colour << 40) | (textHash & 0xFFFFFFFFFFull);
+
+  bool isCached;
+  TFT_eSprite *glyph = wideCache.get(key, isCached);
+  if (!isCached) {
+    glyph->setTextDatum(MC_DATUM);
+    glyph->setTextColor(colour);
+    glyph->drawString(text, wideCache.getWidth() / 2, wideCache.getHeight() / 2, 2);
+  }
+
+  wideCache.blit(glyph, curScreen, x, y);
+}
+
+void drawNumber(long number, int32_t x, int32_t y, uint16_t colour) {
+  char text[12];
+  snprintf(text, sizeof(text), "%ld", number);
+  drawText(text, x, y, colour);
+}
+
+void drawPulsePips(const StageSnapshot& stage, Angle angle, Vec2 pos, int8_t currentPulseInStage, GateMode gateMode) {
+  Vec2Fx posFx = Vec2Fx::fromVec2(pos);
+
   int rowCount = stage.pulseCount / 4 + (stage.pulseCount % 4 > 0);
   int pxPerPip = 7;
 
@@ -347,7 +962,7 @@ void drawPulsePips(Stage& stage, float angle, Vec2 pos, int8_t currentPulseInSta
     float startAngle = (pulsesInRow - 1) * -0.5f * degPerPip + 180;
 
     for (int rowIndex = 0; rowIndex < pulsesInRow; rowIndex++) {
-      float pulseAngle = angle + startAngle + (pulsesInRow - rowIndex - 1) * degPerPip;
+      Angle pulseAngle = angle + Angle::fromDegrees(startAngle + (pulsesInRow - rowIndex - 1) * degPerPip);
       uint8_t pulseIndex = row * 4 + rowIndex;
 
       uint16_t colour;
@@ -358,9 +973,9 @@ void drawPulsePips(Stage& stage, float angle, Vec2 pos, int8_t currentPulseInSta
         colour = (isActive) ? COLOUR_INACTIVE :  COLOUR_SKIPPED;
       }
 
-      Vec2 pipPos = pos + Vec2::fromPolar(rowRadius, pulseAngle);
+      Vec2Fx pipCorner = posFx + Vec2Fx::fromPolar(rowRadius, pulseAngle) - Vec2Fx(Vec2Fx::ONE * 3 / 2, Vec2Fx::ONE * 3 / 2);
       curScreen->fillRect(
-        pipPos.x - 1.5, pipPos.y - 1.5, // Position
+        pipCorner.pixelX(), pipCorner.pixelY(), // Position
         3, 3,
         colour
       );
@@ -368,7 +983,8 @@ void drawPulsePips(Stage& stage, float angle, Vec2 pos, int8_t currentPulseInSta
   }
 }
 
-void drawHeldPulses(Stage& stage, float angle, Vec2 pos, int8_t currentPulseInStage, float pulseAnticipation) {
+void drawHeldPulses(const StageSnapshot& stage, Angle angle, Vec2 pos, int8_t currentPulseInStage, float pulseAnticipation) {
+  PerfScope scope(PERF_ARCS);
   bool isStageActive = currentPulseInStage > 0;
 
   // 0 to pulseCount
@@ -390,8 +1006,10 @@ void drawHeldPulses(Stage& stage, float angle, Vec2 pos, int8_t currentPulseInSt
     float degPerPip = degsPerPixel[rowRadius] * pxPerPip;
 
     float degsInArc = pulsesInRow * degPerPip;
-    float startAngle = wrapDeg(angle - degsInArc * 0.5f);
-    float endAngle = wrapDeg(angle + degsInArc * 0.5f);
+    Angle halfArc = Angle::fromDegrees(degsInArc * 0.5f);
+    float startAngle = (angle - halfArc).toDegrees();
+    Angle end = angle + halfArc;
+    float endAngle = end.toDegrees();
 
     curScreen->drawArc(
       pos.x, pos.y, // Position
@@ -407,7 +1025,7 @@ void drawHeldPulses(Stage& stage, float angle, Vec2 pos, int8_t currentPulseInSt
       curScreen->drawArc(
         pos.x, pos.y, // Position
         rowRadius + 2, rowRadius - 1, // Radius, Inner Radius
-        wrapDeg(endAngle - degsInArc * rowProgress), endAngle, // Arc start & end 
+        (end - Angle::fromDegrees(degsInArc * rowProgress)).toDegrees(), endAngle, // Arc start & end 
         COLOUR_ACTIVE, COLOUR_BG, // Colour, AA Colour
         false // Smoothing
       );
@@ -415,7 +1033,7 @@ void drawHeldPulses(Stage& stage, float angle, Vec2 pos, int8_t currentPulseInSt
   }
 }
 
-void drawPulses(Stage& stage, float angle, Vec2 pos, int8_t currentPulseInStage, GateMode gateMode, float pulseAnticipation) {
+void drawPulses(const StageSnapshot& stage, Angle angle, Vec2 pos, int8_t currentPulseInStage, GateMode gateMode, float pulseAnticipation) {
   if (gateMode == HELD) {
     drawHeldPulses(stage, angle, pos, currentPulseInStage, pulseAnticipation);
   } else {
@@ -423,35 +1041,95 @@ void drawPulses(Stage& stage, float angle, Vec2 pos, int8_t currentPulseInStage,
   }
 }
 
+// Only the held arc of the active stage moves between pulses
+void drawPulsesElement(const StageSnapshot& stage, Angle angle, Vec2 pos, int8_t currentPulseInStage, GateMode gateMode, float pulseAnticipation, ElementHash hash) {
+  hash.add(gateMode);
+  if (gateMode == HELD && currentPulseInStage >= 0) hash.add(pulseAnticipation);
+
+  if (beginElement(pulsesBounds(stage, angle, pos), hash.get())) {
+    PerfScope scope(PERF_STAGES);
+    drawPulses(stage, angle, pos, currentPulseInStage, gateMode, pulseAnticipation);
+  }
+}
+
+// Around a gate mode's rows of pips, or its held arcs, which reach a little further
+ScreenRect pulsesBounds(const StageSnapshot& stage, Angle angle, Vec2 pos) {
+  ScreenRect bounds = ScreenRect::around(pos.x, pos.y, 0, 0);
+  int rowCount = stage.pulseCount / 4 + (stage.pulseCount % 4 > 0);
+  int pxPerPip = 7;
+
+  for (int row = 0; row < rowCount; row++) {
+    int pulsesInRow = min(4, stage.pulseCount - 4 * row);
+    int rowRadius = 20 + ((row == 0 || row == 2) ? 0 : 6);
+    Angle halfArc = Angle::fromDegrees(pulsesInRow * degsPerPixel[rowRadius] * pxPerPip * 0.5f);
+    float startAngle = (angle - halfArc).toDegrees();
+    float endAngle = (angle + halfArc).toDegrees();
+
+    // Pips are 3px squares on the row, the arcs go from a pixel inside it to two outside
+    ScreenRect rowBounds = arcBounds(pos, rowRadius + 2, rowRadius - 2, startAngle, endAngle);
+    bounds = (row == 0) ? rowBounds : bounds.unite(rowBounds);
+  }
+
+  return bounds;
+}
+
 void drawStageOutput(float output, uint16_t colour, Vec2 pos) {
   int octave = (int)output;
   float semitone = output - octave;
 
-  if (semitone < 0.5) {
-    curScreen->fillSmoothCircle(
-      pos.x, pos.y,
-      semitone * 8 + 2,
-      colour, COLOUR_BG
-    );
-  } else {
-    curScreen->drawArc(
-      pos.x, pos.y, // Position
-      semitone * 8 + 2, (semitone - 0.5) * 2 * 11, // Radius, Inner Radius
-      0, 359, // Arc start & end 
-      colour, COLOUR_BG, // Colour, AA Colour
-      true // Smoothing
-    );
+  // It's all drawn in whole pixels, so these are everything that decides how it looks
+  bool isRing = semitone >= 0.5;
+  int32_t radius = semitone * 8 + 2;
+  int32_t innerRadius = isRing ? (semitone - 0.5) * 2 * 11 : 0;
+  int32_t extraSize = max(0, semitone * 8 - 8 + 3);
+  bool isSmooth = frameScheduler.isSmoothingArcs();
+
+  uint64_t key = (uint64_t)isSmooth << 48 | (uint64_t)colour << 32 | octave << 16 | isRing << 15 | radius << 10 | innerRadius << 4 | extraSize;
+
+  bool isCached;
+  TFT_eSprite *glyph = shapeCache.get(key, isCached);
+  if (!isCached) {
+    int32_t x = shapeCache.getWidth() / 2;
+    int32_t y = shapeCache.getHeight() / 2;
+
+    if (!isRing) {
+      if (isSmooth) {
+        glyph->fillSmoothCircle(
+          x, y,
+          radius,
+          colour, COLOUR_BG
+        );
+      } else {
+        glyph->fillCircle(x, y, radius, colour);
+      }
+    } else {
+      glyph->drawArc(
+        x, y, // Position
+        radius, innerRadius, // Radius, Inner Radius
+        0, 359, // Arc start & end 
+        colour, COLOUR_BG, // Colour, AA Colour
+        isSmooth // Smoothing
+      );
+    }
+
+    for (int i = 0; i < octave; i++) {
+      glyph->drawCircle(
+        x, y,
+        10 + 2 * i + extraSize,
+        colour
+      );
+    }
   }
 
-  for (int i = 0; i < octave; i++) {
-    float extraSize = max(0, semitone * 8 - 8 + 3);
+  shapeCache.blit(glyph, curScreen, pos.x, pos.y);
+}
 
-    curScreen->drawCircle(
-      pos.x, pos.y,
-      10 + 2 * i + extraSize,
-      colour
-    );
-  }
+// Around the strikethrough and its border, which reach further towards the centre than out
+ScreenRect strikethroughBounds(Vec2 pos) {
+  Vec2 d = (pos - screenCenter).normalized();
+  Vec2 inner = pos + d * -33.5;
+  Vec2 outer = pos + d * 17.5;
+  return ScreenRect::around(inner.x, inner.y, 3, 3).unite(ScreenRect::around(outer.x, outer.y, 3, 3));
 }
 
 void drawStageStrikethrough(Vec2 pos) {
@@ -513,14 +1191,26 @@ Vec2 unscaledPianoPositions[] = {
   Vec2(6,   1)  // B
 };
 
-int pianoPipSpacing = 5;
-int pianoPipSize = 4;
+// Around the keys and any pip between them, including the ones past each end
+ScreenRect pianoBounds(Vec2 pos) {
+  return ScreenRect::around(pos.x, pos.y, 8 * pianoPipSpacing + pianoPipSize + 2, pianoPipSpacing + pianoPipSize + 2);
+}
+
+void drawCachedPiano(Vec2 pos) {
+  bool isCached;
+  TFT_eSprite *glyph = wideCache.get(GLYPH_PIANO, isCached);
+  if (!isCached) {
+    drawPiano(glyph, Vec2(wideCache.getWidth() / 2, wideCache.getHeight() / 2));
+  }
+
+  wideCache.blit(glyph, curScreen, pos.x, pos.y);
+}
 
-void drawPiano(Vec2 pos) {
+void drawPiano(TFT_eSprite *target, Vec2 pos) {
   for (Vec2 unscaledPos : unscaledPianoPositions) {
     Vec2 finalPos = unscaledPos * pianoPipSpacing + pos;
 
-    curScreen->drawSmoothCircle(
+    target->drawSmoothCircle(
       finalPos.x, finalPos.y,
       pianoPipSize,
       COLOUR_INACTIVE,
@@ -529,6 +1219,23 @@ void drawPiano(Vec2 pos) {
   }
 }
 
+// Around the spot drawPianoPip draws, or both halves of it between B and the next C
+ScreenRect pianoPipBounds(Vec2 pos, float highlightedPitch, float size) {
+  float wrapped = fwrap(highlightedPitch, 0, 12);
+  int a = floor(wrapped);
+  int b = (int)ceil(wrapped) % 12;
+  float remainder = wrapped - a;
+
+  if (a == 11) {
+    Vec2 userPos1 = lerp(unscaledPianoPositions[11], Vec2(8, 1), remainder) * pianoPipSpacing + pos;
+    Vec2 userPos2 = lerp(Vec2(-8, 1), unscaledPianoPositions[0], remainder) * pianoPipSpacing + pos;
+    return ScreenRect::around(userPos1.x, userPos1.y, size, size).unite(ScreenRect::around(userPos2.x, userPos2.y, size, size));
+  }
+
+  Vec2 userPos = lerp(unscaledPianoPositions[a], unscaledPianoPositions[b], remainder) * pianoPipSpacing + pos;
+  return ScreenRect::around(userPos.x, userPos.y, size, size);
+}
+
 void drawPianoPip(Vec2 pos, float highlightedPitch, float size, uint16_t colour) {
   float foo = fwrap(highlightedPitch, 0, 12);
   int a = floor(foo);
@@ -1,28 +1,27 @@
 #pragma once
 
-#include <Arduino.h>
+#include "Compat.h"
 #include <TFT_eSPI.h>
 #include "Vec2.h"
-#include "Sequence.h"
-#include "UndoRedoManager.hpp"
-#include "Button.h"
-#include "InteractionManager.hpp"
+#include "Stage.hpp"
+#include "SequenceSnapshot.hpp"
+#include "FrameScheduler.hpp"
 
 void initScreen();
 
-void updateAnimations(
-    UndoRedoManager &undoRedoManager,
-    InteractionManager &interactionManager
-);
+FrameScheduler &getFrameScheduler();
+
+// A row of hits and misses for each glyph cache, under GlyphCache::getStatsHeader. False past the last
+bool formatGlyphCacheStats(uint8_t index, char *text, size_t size);
+void resetGlyphCacheStats();
+size_t getGlyphCacheBytes();
 
-void render(
-    UndoRedoManager &undoRedoManager,
-    InteractionManager &interactionManager,
-    const std::vector<Button*> &activeButtons
+// Call as often as possible. Starts a frame when one's due, draws the next
+// strip of it and keeps DMA sending the ones already drawn
+void updateDisplay(
+    const SequenceSnapshot &snapshot,
+    StageDrawInfo *stageDrawInfoById
 );
 
-void renderIfDmaIsReady(
-    UndoRedoManager &undoRedoManager, 
-    InteractionManager &interactionManager,
-    const std::vector<Button*> &activeButtons
-);
\ No newline at end of file
+// Whether the last frame has been drawn and sent, with nothing due yet
+bool isDisplayUpToDate();
@@ -0,0 +1,75 @@
+#include "RoundScreen.hpp"
+
+// Built once at startup, it's only a few hundred bytes
+struct SpanTable {
+    ScreenSpan spans[RoundScreen::SIZE];
+    uint16_t visibleTiles[DirtyTiles::TILES_PER_SIDE];
+
+    SpanTable() {
+        // Pixel centres are at x + 0.5, so everything is doubled to stay in integers
+        const int32_t diameter = RoundScreen::SIZE;
+
+        for (int16_t y = 0; y < RoundScreen::SIZE; y++) {
+            int32_t dy = 2 * y + 1 - diameter;
+            int16_t halfWidth = 0;
+            while (halfWidth < RoundScreen::SIZE / 2) {
+                int32_t dx = 2 * halfWidth + 1;
+                if (dx * dx + dy * dy > diameter * diameter) break;
+                halfWidth++;
+            }
+
+            spans[y] = {(int16_t)(RoundScreen::SIZE / 2 - halfWidth), (int16_t)(RoundScreen::SIZE / 2 + halfWidth)};
+        }
+
+        for (int tileRow = 0; tileRow < DirtyTiles::TILES_PER_SIDE; tileRow++) {
+            visibleTiles[tileRow] = 0;
+
+            for (int column = 0; column < DirtyTiles::TILES_PER_SIDE; column++) {
+                ScreenRect tile = {
+                    (int16_t)(column * DirtyTiles::TILE_SIZE), (int16_t)(tileRow * DirtyTiles::TILE_SIZE),
+                    DirtyTiles::TILE_SIZE, DirtyTiles::TILE_SIZE
+                };
+
+                if (RoundScreen::isVisible(tile)) {
+                    visibleTiles[tileRow] |= 1u << column;
+                }
+            }
+        }
+    }
+};
+
+static SpanTable spanTable;
+
+ScreenSpan RoundScreen::getSpan(int16_t y) {
+    if (y < 0 || y >= SIZE) return {0, 0};
+
+    return spanTable.spans[y];
+}
+
+ScreenSpan RoundScreen::getVisibleColumns(const ScreenRect &rect) {
+    int16_t top = max(0, rect.y);
+    int16_t bottom = min(SIZE, rect.y + rect.h);
+    if (bottom <= top) return {0, 0};
+
+    // Rows get wider towards the middle, so the widest row in rect is the one nearest it
+    int16_t widestRow = (bottom <= SIZE / 2) ? bottom - 1 : (top >= SIZE / 2) ? top : SIZE / 2;
+    ScreenSpan widest = spanTable.spans[widestRow];
+
+    return widest.intersect(rect.x, rect.x + rect.w);
+}
+
+uint32_t RoundScreen::countVisiblePixels(const ScreenRect &rect) {
+    uint32_t count = 0;
+
+    for (int16_t y = max(0, rect.y); y < min(SIZE, rect.y + rect.h); y++) {
+        count += getSpan(y).intersect(rect.x, rect.x + rect.w).length();
+    }
+
+    return count;
+}
+
+uint16_t RoundScreen::getVisibleTiles(int tileRow) {
+    if (tileRow < 0 || tileRow >= DirtyTiles::TILES_PER_SIDE) return 0;
+
+    return spanTable.visibleTiles[tileRow];
+}
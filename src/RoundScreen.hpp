@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Compat.h"
+#include "DirtyTiles.hpp"
+
+// A run of pixels along a row, end not included
+struct ScreenSpan {
+    int16_t start, end;
+
+    bool isEmpty() const { return end <= start; }
+    int16_t length() const { return isEmpty() ? 0 : end - start; }
+
+    ScreenSpan intersect(int16_t otherStart, int16_t otherEnd) const {
+        return {max(start, otherStart), min(end, otherEnd)};
+    }
+};
+
+// The GC9A01 panel is round, so only a circle out of the square frame is
+// ever seen. This is the visible span of every row of it, a pixel counting
+// as visible when its centre is inside the circle.
+class RoundScreen {
+    public:
+        static constexpr int16_t SIZE = DirtyTiles::SCREEN_SIZE;
+
+        static ScreenSpan getSpan(int16_t y);
+
+        // The columns of rect that are visible on any of its rows
+        static ScreenSpan getVisibleColumns(const ScreenRect &rect);
+        static bool isVisible(const ScreenRect &rect) { return !getVisibleColumns(rect).isEmpty(); }
+
+        // How many pixels of rect are visible
+        static uint32_t countVisiblePixels(const ScreenRect &rect);
+
+        // One bit per tile on the given row of 16px tiles, set when any of the tile is visible
+        static uint16_t getVisibleTiles(int tileRow);
+};
@@ -0,0 +1,137 @@
+#include "Scale.hpp"
+
+static const ScaleDefinition builtInScales[] = {
+    {"Major",      12, 0xAB5},
+    {"Dorian",     12, 0x6AD},
+    {"Phrygian",   12, 0x5AB},
+    {"Lydian",     12, 0xAD5},
+    {"Mixolydian", 12, 0x6B5},
+    {"Minor",      12, 0x5AD},
+    {"Locrian",    12, 0x56B},
+    {"Harm minor", 12, 0x9AD},
+    {"Major pent", 12, 0x295},
+    {"Minor pent", 12, 0x4A9},
+    {"Blues",      12, 0x4E9},
+    {"Whole tone", 12, 0x555},
+    {"Chromatic",  12, 0xFFF},
+    {"19-TET maj", 19, 0x24949},
+    {"24-TET rast", 24, 0x244491},
+    {"24-TET chrom", 24, 0xFFFFFF}
+};
+
+static const size_t BUILT_IN_SCALE_COUNT = sizeof(builtInScales) / sizeof(builtInScales[0]);
+static const char *userScaleNames[USER_SCALE_COUNT] = {"User 1", "User 2", "User 3", "User 4"};
+
+// Rounds towards negative infinity, unlike /
+static inline int floorDiv(int a, int b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+void Scale::setSteps(uint8_t divisions, uint32_t stepMask) {
+    _divisions = min(MAX_SCALE_DIVISIONS, max(1, divisions));
+    _stepMask = (_divisions == 32) ? stepMask : stepMask & ((1u << _divisions) - 1);
+
+    _rebuildTables();
+}
+
+int Scale::quantize(int step, int transposeDegrees) {
+    if (_degreeCount == 0) return step;
+
+    int octave = floorDiv(step, _divisions);
+    int stepInOctave = step - octave * _divisions;
+
+    if (transposeDegrees == 0) {
+        return step + _nearestStepOffset[stepInOctave];
+    }
+
+    int degree = _nearestDegree[stepInOctave] + transposeDegrees;
+    int degreeOctave = floorDiv(degree, _degreeCount);
+    degree -= degreeOctave * _degreeCount;
+
+    return (octave + degreeOctave) * _divisions + _stepOfDegree[degree];
+}
+
+uint8_t Scale::getMidiNote(float output, int transposeDegrees) {
+    int step = quantize(lroundf(output * _divisions), transposeDegrees);
+    int note = (_divisions == 12) ? 60 + step : 60 + (int)lroundf(step * 12.f / _divisions);
+
+    return min(127, max(0, note));
+}
+
+void Scale::_rebuildTables() {
+    _degreeCount = 0;
+    for (uint8_t step = 0; step < _divisions; step++) {
+        if (hasStep(step)) {
+            _stepOfDegree[_degreeCount++] = step;
+        }
+    }
+
+    for (int step = 0; step < _divisions; step++) {
+        _nearestStepOffset[step] = 0;
+        _nearestDegree[step] = 0;
+        if (_degreeCount == 0) continue;
+
+        int distToClosestStepUp = 0;
+        while (!hasStep(step + distToClosestStepUp)) distToClosestStepUp++;
+
+        int distToClosestStepDown = 0;
+        while (!hasStep((step - distToClosestStepDown + _divisions) % _divisions)) distToClosestStepDown++;
+
+        int offset = (distToClosestStepUp < distToClosestStepDown) ? distToClosestStepUp : -distToClosestStepDown;
+        _nearestStepOffset[step] = offset;
+
+        // Which degree that is, counting on from this octave's
+        int target = step + offset;
+        int octave = floorDiv(target, _divisions);
+        int targetInOctave = target - octave * _divisions;
+
+        for (uint8_t degree = 0; degree < _degreeCount; degree++) {
+            if (_stepOfDegree[degree] == targetInOctave) {
+                _nearestDegree[step] = degree + octave * _degreeCount;
+                break;
+            }
+        }
+    }
+}
+
+ScaleLibrary::ScaleLibrary() {
+    for (size_t i = 0; i < USER_SCALE_COUNT; i++) {
+        _userScales[i] = Scale(12, 0xFFF);
+    }
+}
+
+size_t ScaleLibrary::size() {
+    return BUILT_IN_SCALE_COUNT + USER_SCALE_COUNT;
+}
+
+const char *ScaleLibrary::getName(size_t index) {
+    if (index < BUILT_IN_SCALE_COUNT) return builtInScales[index].name;
+    if (index < size()) return userScaleNames[index - BUILT_IN_SCALE_COUNT];
+
+    return "";
+}
+
+Scale ScaleLibrary::getScale(size_t index) {
+    if (index < BUILT_IN_SCALE_COUNT) return Scale(builtInScales[index].divisions, builtInScales[index].stepMask);
+    if (index < size()) return _userScales[index - BUILT_IN_SCALE_COUNT];
+
+    return Scale();
+}
+
+bool ScaleLibrary::isUserScale(size_t index) {
+    return index >= BUILT_IN_SCALE_COUNT && index < size();
+}
+
+void ScaleLibrary::saveUserScale(size_t index, Scale scale) {
+    if (isUserScale(index)) {
+        _userScales[index - BUILT_IN_SCALE_COUNT] = scale;
+    }
+}
+
+int ScaleLibrary::indexOf(Scale scale) {
+    for (size_t i = 0; i < size(); i++) {
+        if (getScale(i) == scale) return i;
+    }
+
+    return -1;
+}
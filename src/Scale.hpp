@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Compat.h"
+
+// The most steps an octave can be divided into, one bit of the step mask each
+const uint8_t MAX_SCALE_DIVISIONS = 32;
+const uint8_t USER_SCALE_COUNT = 4;
+
+// A set of steps out of an octave divided into equal steps. 12 divisions is
+// the usual 12-TET, but anything from 1 to MAX_SCALE_DIVISIONS works.
+// Lookup tables are rebuilt whenever the steps change, so quantizing a
+// note is just a table read or two.
+class Scale {
+    public:
+        Scale(uint8_t divisions, uint32_t stepMask) { setSteps(divisions, stepMask); }
+        Scale() : Scale(12, 0xFFF) {}
+
+        void setSteps(uint8_t divisions, uint32_t stepMask);
+        void toggleStep(uint8_t step) { setSteps(_divisions, _stepMask ^ (1u << (step % _divisions))); }
+
+        uint8_t getDivisions() { return _divisions; }
+        uint32_t getStepMask() { return _stepMask; }
+        bool hasStep(uint8_t step) { return (_stepMask >> (step % _divisions)) & 1; }
+        uint8_t getDegreeCount() { return _degreeCount; }
+
+        // Snaps step (in any octave) to the nearest step in the scale, ties go
+        // down, then moves it by transposeDegrees steps of the scale.
+        // An empty scale leaves the step alone
+        int quantize(int step, int transposeDegrees = 0);
+
+        // The MIDI note for an output, which has one unit per octave with 0 at
+        // middle C. Steps that fall between 12-TET notes go to the nearest one
+        uint8_t getMidiNote(float output, int transposeDegrees = 0);
+
+        bool operator==(const Scale &other) const { return _divisions == other._divisions && _stepMask == other._stepMask; }
+
+    private:
+        void _rebuildTables();
+
+        uint8_t _divisions;
+        uint32_t _stepMask;
+        uint8_t _degreeCount;
+        int8_t _nearestStepOffset[MAX_SCALE_DIVISIONS]; // From each step to the nearest one in the scale
+        int8_t _nearestDegree[MAX_SCALE_DIVISIONS]; // Can be -1 or _degreeCount when the nearest is in the next octave
+        uint8_t _stepOfDegree[MAX_SCALE_DIVISIONS];
+};
+
+struct ScaleDefinition {
+    const char *name;
+    uint8_t divisions;
+    uint32_t stepMask; // Bit n set when step n is in the scale
+};
+
+// The built in scales, followed by a few slots the user can save their own to
+class ScaleLibrary {
+    public:
+        ScaleLibrary();
+
+        size_t size();
+        const char *getName(size_t index);
+        Scale getScale(size_t index);
+
+        bool isUserScale(size_t index);
+        void saveUserScale(size_t index, Scale scale);
+
+        // Where scale is in the library, or -1 if it isn't
+        int indexOf(Scale scale);
+
+    private:
+        Scale _userScales[USER_SCALE_COUNT];
+};
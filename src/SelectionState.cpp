@@ -2,7 +2,14 @@
 
 SelectionState::SelectionState(Sequence &sequence, uint8_t highlightedStageIndex) {
     _highlightedStage = &sequence.getStage(highlightedStageIndex);
-    _selectedStages = sequence.getSelectedStages();
+
+    // Note: Stage deletion and insertion depend on this
+    // being in index order
+    for (size_t i = 0; i < sequence.stageCount(); i++) {
+        if (sequence.getStage(i).isSelected) {
+            _selectedStages.push_back(&sequence.getStage(i));
+        }
+    }
 
     _affectedStages = _selectedStages;
     if (!_highlightedStage->isSelected) {
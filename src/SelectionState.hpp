@@ -1,16 +1,37 @@
 #pragma once
 
+#include <iterator>
 #include "Sequence.h"
 
+// Stages, kept in place rather than on the heap. There can never be more than MAX_STAGES
+class StageList {
+    public:
+        void push_back(Stage *stage) {
+            if (_count < MAX_STAGES) _stages[_count++] = stage;
+        }
+
+        size_t size() const { return _count; }
+        Stage *operator[](size_t index) const { return _stages[index]; }
+
+        Stage **begin() { return _stages; }
+        Stage **end() { return _stages + _count; }
+        std::reverse_iterator<Stage**> rbegin() { return std::reverse_iterator<Stage**>(end()); }
+        std::reverse_iterator<Stage**> rend() { return std::reverse_iterator<Stage**>(begin()); }
+
+    private:
+        Stage *_stages[MAX_STAGES];
+        size_t _count = 0;
+};
+
 class SelectionState {
     public:
         SelectionState(Sequence &sequence, uint8_t highlightedStageIndex);
 
-        std::vector<Stage*> &getAffectedStages() { return _affectedStages; };
-        std::vector<Stage*> &getSelectedStages() { return _selectedStages; };
+        StageList &getAffectedStages() { return _affectedStages; };
+        StageList &getSelectedStages() { return _selectedStages; };
         Stage *getHighlightedStage() { return _highlightedStage; };
     private: 
         Stage *_highlightedStage;
-        std::vector<Stage*> _selectedStages;
-        std::vector<Stage*> _affectedStages;
+        StageList _selectedStages;
+        StageList _affectedStages;
 };
\ No newline at end of file
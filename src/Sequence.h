@@ -2,48 +2,63 @@
 
 #define MAX_STAGES 16
 
+// Pulse timing is kept in fixed point microseconds with this many fractional bits,
+// so a tempo that isn't a whole number of microseconds per pulse doesn't drift.
+// Only the pulse length and the fraction of a microsecond are fixed point,
+// when a pulse started is kept in whole microseconds so it never overflows
+#define PULSE_FX_BITS 24
+#define PULSE_FX_FRACTION_MASK ((1ull << PULSE_FX_BITS) - 1)
+// Phase through a pulse runs from 0 to PULSE_PHASE_ONE
+#define PULSE_PHASE_ONE (1u << 16)
+
+// Held notes close their gate this far through the last pulse to leave a gap before the next stage
+const float HELD_GATE_LENGTH = 0.9375f;
+
 #include <vector>
-#include <Adafruit_TinyUSB.h>
-#include <MIDI.h>
 #include <algorithm>
+#include <type_traits>
 #include "utils.h"
 #include "Stage.hpp"
+#include "Scale.hpp"
+
+// MIDI clock runs at 24 ticks per quarter note, in and out
+const uint8_t MIDI_TICKS_PER_QUARTER_NOTE = 24;
+
+// The index returned when there's no such stage
+const size_t NO_STAGE = SIZE_MAX;
 
 class Sequence {
     public:
-        Sequence(u_int8_t stageCount, uint stagePulseTallyById[MAX_STAGES]) {
-            _stagePulseTallyById = stagePulseTallyById;
-            _stages.reserve(MAX_STAGES);
-
+        Sequence(u_int8_t stageCount) {
             // Clip stageCount to a reasonable range
             stageCount = max(1, stageCount);
             stageCount = min(MAX_STAGES, stageCount);
 
             for (int i = 0; i < stageCount; i++) {
                 addStage();
-                _stages.back().pulseCount = (rand() % 2) + 1;
-                _stages.back().setOutput((rand() % 100) / 50.f);
-                _stages.back().gateMode = EACH;
+                Stage &stage = _stages[_stageCount - 1];
+                stage.pulseCount = (rand() % 2) + 1;
+                stage.setOutput((rand() % 100) / 50.f);
+                stage.gateMode = EACH;
             }
 
             _updateMicrosPerPulse();
             updateNextStageIndex();
         }
 
-        Sequence() : Sequence(0, nullptr) {}
+        Sequence() : Sequence(0) {}
 
         void addStage() {
-            _stages.push_back(Stage(getNewStageId()));
+            markEdited();
+            if (_stageCount < MAX_STAGES) {
+                _stages[_stageCount] = Stage(getNewStageId());
+                _stageCount++;
+            }
         }
 
         void swapStages(size_t indexA, size_t indexB) {
-            Stage stageA = _stages[indexA];
-            Stage stageB = _stages[indexB];
-            _stages.erase(_stages.begin() + indexA);
-            _stages.insert(_stages.begin() + indexA, stageB);
-
-            _stages.erase(_stages.begin() + indexB);
-            _stages.insert(_stages.begin() + indexB, stageA);
+            markEdited();
+            std::swap(_stages[indexA], _stages[indexB]);
 
             if (_activeStageIndex == indexA) {
                 _activeStageIndex = indexB;
@@ -52,64 +67,84 @@ class Sequence {
             }
         }
 
-        void moveStages(std::vector<size_t> stagesToMove, int direction) {
+        // Moves each stage in stagesToMove (a bitmask of stage indexes) by one place 
+        // in direction, wrapping around the ends. The stages they displace fill the gaps.
+        void moveStages(uint16_t stagesToMove, int direction) {
+            markEdited();
             if (direction != -1 && direction != 1) return;
 
-            std::vector<int> finalPositions(_stages.size()); // A mapping from the _stages vector to the final result
-            std::fill(finalPositions.begin(), finalPositions.end(), -1);
+            auto isMoving = [stagesToMove](int index) { return (stagesToMove >> index) & 1; };
 
-            // Place all stagesToMove into the finalPositions vector, incremented/decremented by 1
+            // A mapping from each final position to the index the stage is coming from
             // eg.
             // direction = 1
             // stagesToMove =    0     2     4 [0, 2, 4] 
             //                   ^--v  ^--v  ^-> wraps to index 0
-            // finalPositions =  4  0 -1  2 -1
-            for (size_t index : stagesToMove) {
-                size_t newIndex = wrap(index + direction, 0, finalPositions.size());
-                finalPositions[newIndex] = index;
-            }
+            // sourceIndexes =   4  0  3  2  1
+            uint8_t sourceIndexes[MAX_STAGES];
+            size_t newActiveStageIndex = _activeStageIndex;
 
+            for (int i = 0; i < _stageCount; i++) {
+                int previousIndex = (i - direction + _stageCount) % _stageCount;
 
-            // Fill in the gaps with unmoved elements
-            // before: finalPositions =  4  0 -1  2 -1
-            // after:  finalPositions =  4  0  3  2  1
-            for (int i = 0; i < finalPositions.size(); i++) {
-                // -1 indicates a stage hasn't been assigned to this space yet
-                if (finalPositions[i] == -1) {
-                    // Fill the gap with the nearest index that isn't in "stagesToMove"
-                    // Increment/Decrement by "direction"
+                if (isMoving(previousIndex)) {
+                    sourceIndexes[i] = previousIndex;
+                } else {
+                    // Fill the gap with the nearest stage that isn't moving.
+                    // Each run of moving stages is only stepped over once, so this stays O(n)
                     int possibleIndex = i;
 
-                    // Increment/Decrement foo until it doesn't exist in stagesToMove
-                    while (std::find(stagesToMove.begin(), stagesToMove.end(), possibleIndex) != stagesToMove.end()) {
-                        possibleIndex = wrap(possibleIndex + direction, 0, finalPositions.size());
+                    while (isMoving(possibleIndex)) {
+                        possibleIndex = (possibleIndex + direction + _stageCount) % _stageCount;
                     }
 
-                    finalPositions[i] = possibleIndex;
+                    sourceIndexes[i] = possibleIndex;
+                }
+
+                if (sourceIndexes[i] == _activeStageIndex) {
+                    newActiveStageIndex = i;
                 }
             }
 
-            // Update active stage index
-            size_t newActiveStageIndex = std::find(finalPositions.begin(), finalPositions.end(), _activeStageIndex) - finalPositions.begin();
+            // Shuffle the stages into place by following each cycle of the mapping,
+            // so only one stage needs to be held aside at a time
+            uint16_t isPlaced = 0;
+            for (int cycleStart = 0; cycleStart < _stageCount; cycleStart++) {
+                if ((isPlaced >> cycleStart) & 1) continue;
 
-            _activeStageIndex = newActiveStageIndex;
-            updateNextStageIndex();
+                Stage displacedStage = _stages[cycleStart];
+                int i = cycleStart;
+
+                while (true) {
+                    isPlaced |= 1 << i;
 
-            // Construct a new vector with all stages in their new positions
-            std::vector<Stage> result;
-            for (int originalIndex : finalPositions) {
-                result.push_back(_stages[originalIndex]);
+                    if (sourceIndexes[i] == cycleStart) {
+                        _stages[i] = displacedStage;
+                        break;
+                    }
+
+                    _stages[i] = _stages[sourceIndexes[i]];
+                    i = sourceIndexes[i];
+                }
             }
 
-            _stages = result;
+            _activeStageIndex = newActiveStageIndex;
+            updateNextStageIndex();
         }
 
         void insertStage(size_t index, Stage stage) {
-            if (stageCount() <= MAX_STAGES) {
-                _stages.insert(_stages.begin() + index, stage);
+            markEdited();
+            if (_stageCount < MAX_STAGES && index <= _stageCount) {
+                // Shuffle everything from index onwards along by one
+                for (size_t i = _stageCount; i > index; i--) {
+                    _stages[i] = _stages[i - 1];
+                }
+
+                _stages[index] = stage;
+                _stageCount++;
 
-                // Update the active stage index if the new stage is inserted before it
-                if (index < _activeStageIndex) {
+                // Keep the active stage active if the new stage is inserted before it
+                if (index <= _activeStageIndex) {
                     _activeStageIndex++;
                 }
 
@@ -117,12 +152,31 @@ class Sequence {
             }
         }
 
+        // Inserts a deselected copy of a stage directly after it.
+        // Returns the index of the copy, or NO_STAGE if the sequence is full
+        size_t cloneStage(size_t index) {
+            if (_stageCount >= MAX_STAGES || index >= _stageCount) return NO_STAGE;
+
+            Stage clone = _stages[index];
+            clone.isSelected = false;
+            clone.id = getNewStageId();
+            insertStage(index + 1, clone);
+
+            return index + 1;
+        }
+
         void deleteStage(size_t index) {
-            if (_stages.size() > 1 && index >= 0 && index < _stages.size()) {
-                _stages.erase(_stages.begin() + index);
+            markEdited();
+            if (_stageCount > 1 && index < _stageCount) {
+                // Shuffle everything after index back by one
+                for (size_t i = index; i + 1 < _stageCount; i++) {
+                    _stages[i] = _stages[i + 1];
+                }
+
+                _stageCount--;
 
                 // Move the active stage index back if the deletion is before said index
-                if (index < _activeStageIndex) {
+                if (index < _activeStageIndex || _activeStageIndex >= _stageCount) {
                     _activeStageIndex--;
                 }
 
@@ -131,35 +185,29 @@ class Sequence {
         }
 
         size_t indexOfStage(Stage* stage) {
-            for (size_t i = 0; i < _stages.size(); i++) {
-                if (stage == &_stages.at(i)) {
-                    return i;
-                }
+            if (stage >= _stages && stage < _stages + _stageCount) {
+                return stage - _stages;
             }
 
-            return -1;
+            return NO_STAGE;
         }
 
         size_t indexOfStage(uint16_t id) {
-            for (size_t i = 0; i < _stages.size(); i++) {
-                if (id == _stages.at(i).id) {
+            for (size_t i = 0; i < _stageCount; i++) {
+                if (id == _stages[i].id) {
                     return i;
                 }
             }
 
-            return -1;
+            return NO_STAGE;
         }
 
         Stage& getStage(size_t index) {
-            return _stages.at(index);
-        }
-
-        std::vector<Stage>& getStages() {
-            return _stages;
+            return _stages[index];
         }
 
         size_t stageCount() {
-            return _stages.size();
+            return _stageCount;
         }
 
         void updateNextStageIndex() {
@@ -168,7 +216,7 @@ class Sequence {
 
             while (true) {
                 potentialNextIndex++;
-                potentialNextIndex %= _stages.size();
+                potentialNextIndex %= _stageCount;
 
                 if (potentialNextIndex == currentStageIndex || !_stages[potentialNextIndex].isSkipped) {
                     _nextStageIndex = potentialNextIndex;
@@ -177,27 +225,32 @@ class Sequence {
             }
         }
 
-        void update(unsigned long elapsedMicros) {
-            if (elapsedMicros - _lastPulseMicros >= _microsPerPulse) {
-                // Handle the new pulse
-                _lastPulseMicros += _microsPerPulse;
-
-                _stagePulseTallyById[getActiveStage().id]++;
-
-                if (isLastPulseOfStage() || getActiveStage().isSkipped) {
-                    // Move to the next Stage
-                    _outputOfLastStage = _output;
-                    _activeStageIndex = _nextStageIndex;
-                    _currentPulseInStage = 0;
-                    
-                    updateNextStageIndex();
-                } else {
-                    // Move to the next pulse in the current stage
-                    _currentPulseInStage++;
-                }
+        // Advances the sequence by one pulse. Called at each pulse boundary by the ClockEngine
+        void advancePulse() {
+            uint64_t fractionFx = _lastPulseFractionFx + _pulsePeriodFx;
+            _lastPulseMicros += fractionFx >> PULSE_FX_BITS;
+            _lastPulseFractionFx = fractionFx & PULSE_FX_FRACTION_MASK;
+            _pulseIndex++;
+
+            _stagePulseTallyById[getActiveStage().id]++;
+
+            if (isLastPulseOfStage() || getActiveStage().isSkipped) {
+                // Move to the next Stage
+                _outputOfLastStage = _output;
+                _activeStageIndex = _nextStageIndex;
+                _currentPulseInStage = 0;
+                
+                updateNextStageIndex();
+            } else {
+                // Move to the next pulse in the current stage
+                _currentPulseInStage++;
             }
+        }
 
-            _pulseAnticipation = (elapsedMicros - _lastPulseMicros) / (float)_microsPerPulse;
+        // Recalculates the gate and output for the current point within the pulse.
+        // Doesn't move past pulse boundaries, that's left to advancePulse()
+        void updateOutputs(uint64_t nowMicros) {
+            _pulseAnticipation = getPulsePhase(nowMicros) * (1.f / PULSE_PHASE_ONE);
             _slideProgress = min(_pulseAnticipation, _gateLength) / _gateLength;
 
             // TODO: Understand how this assignment works.
@@ -207,7 +260,7 @@ class Sequence {
 
             if (getActiveStage().gateMode == HELD) {
                 // Close the gate 1 16th note before the end of the held note to create some separation from the next stage
-                _gate = !isLastPulseOfStage() || _pulseAnticipation < 0.9375; 
+                _gate = !isLastPulseOfStage() || _pulseAnticipation < HELD_GATE_LENGTH; 
             } else {
                 bool isPulseActive = getActiveStage().isPulseActive(_currentPulseInStage);
                 bool hasGateLengthElapsed = _pulseAnticipation > _gateLength;
@@ -223,6 +276,132 @@ class Sequence {
             }
         }
 
+        // Polled alternative to the ClockEngine, handles at most one pulse boundary per call
+        void update(uint64_t nowMicros) {
+            if (nowMicros >= getNextPulseMicros()) {
+                advancePulse();
+            }
+
+            updateOutputs(nowMicros);
+        }
+
+        // How far through the current pulse nowMicros is, from 0 to PULSE_PHASE_ONE.
+        // Multiplies by a reciprocal of the pulse length so there's no division
+        uint32_t getPulsePhase(uint64_t nowMicros) {
+            // The pulse boundary may have been handled just after nowMicros was sampled
+            uint64_t lastPulseMicros = getLastPulseMicros();
+            uint64_t microsSinceLastPulse = (nowMicros > lastPulseMicros) ? nowMicros - lastPulseMicros : 0;
+            microsSinceLastPulse = min(microsSinceLastPulse, getMicrosPerPulse());
+
+            return min(PULSE_PHASE_ONE, (uint32_t)((microsSinceLastPulse * _pulseReciprocal) >> (PULSE_RECIPROCAL_SHIFT - 16)));
+        }
+
+        // Restarts pulse timing so the next pulse lands one pulse after nowMicros
+        void resetPulseTiming(uint64_t nowMicros) {
+            markEdited();
+            _lastPulseMicros = nowMicros;
+            _lastPulseFractionFx = 0;
+        }
+
+        // Lines up whichever pulse boundary is nearest to pulseMicros with it,
+        // and takes on the tempo, so the sequence can follow an external clock.
+        // If the nearest boundary hasn't been handled yet it becomes due straight away
+        void syncPulseTiming(uint64_t pulseMicros, float microsPerPulse) {
+            markEdited();
+            int64_t microsFromLastPulse = (int64_t)(pulseMicros - getLastPulseMicros());
+            bool isNearestPulseHandled = microsFromLastPulse < (int64_t)getMicrosPerPulse() / 2;
+
+            _bpm = 60000000.f / max(1.f, microsPerPulse) / _subdivision;
+            _setPulsePeriodFx((uint64_t)(max(1.f, microsPerPulse) * (1ull << PULSE_FX_BITS)));
+            _lastPulseMicros = pulseMicros;
+            _lastPulseFractionFx = 0;
+
+            if (!isNearestPulseHandled) {
+                // Back a whole number of microseconds past it, then forward by what's left
+                _lastPulseMicros -= (_pulsePeriodFx + PULSE_FX_FRACTION_MASK) >> PULSE_FX_BITS;
+                _lastPulseFractionFx = (0 - _pulsePeriodFx) & PULSE_FX_FRACTION_MASK;
+            }
+        }
+
+        // Plays the pulses that playing has had since this was copied from it, so an
+        // edited copy can take over from the sequence the clock engine's been playing
+        void catchUpWith(Sequence &playing) {
+            while (_pulseIndex < playing._pulseIndex) {
+                advancePulse();
+            }
+
+            // Those pulses went by at the old tempo, a tempo edit only moves the ones to come
+            _lastPulseMicros = playing._lastPulseMicros;
+            _lastPulseFractionFx = playing._lastPulseFractionFx;
+        }
+
+        // Goes back to the first stage, for when an external clock starts the sequence over
+        void rewind() {
+            markEdited();
+            _outputOfLastStage = _output;
+            _activeStageIndex = 0;
+            _currentPulseInStage = 0;
+            std::fill(std::begin(_stagePulseTallyById), std::end(_stagePulseTallyById), 0);
+
+            updateNextStageIndex();
+        }
+
+        uint64_t getNextPulseMicros() {
+            // Rounded up so the boundary is never handled early
+            return _lastPulseMicros + ((_lastPulseFractionFx + _pulsePeriodFx + PULSE_FX_FRACTION_MASK) >> PULSE_FX_BITS);
+        }
+
+        uint64_t getLastPulseMicros() {
+            return _lastPulseMicros;
+        }
+
+        // Rounded to the nearest microsecond, the pulses themselves keep the fraction
+        unsigned long getMicrosPerPulse() {
+            return (_pulsePeriodFx + (1ull << (PULSE_FX_BITS - 1))) >> PULSE_FX_BITS;
+        }
+
+        // Goes up whenever the sequence changes, so a plan made from it can be
+        // checked cheaply. Its own methods count, changes made to stages through 
+        // getStage() need markEdited() calling
+        uint32_t getEditCount() {
+            return _editCount;
+        }
+
+        void markEdited() {
+            _editCount++;
+        }
+
+        // How many pulses have passed since the sequence started
+        uint32_t getPulseIndex() {
+            return _pulseIndex;
+        }
+
+        float getGateLength() {
+            return _gateLength;
+        }
+
+        uint getStagePulseTally(uint16_t id) {
+            return _stagePulseTallyById[id];
+        }
+
+        // Replaces the stages without touching the playhead.
+        // stagesById is indexed by stage id, order lists the ids in sequence order.
+        void restoreStages(const Stage *stagesById, const uint8_t *order, size_t count) {
+            markEdited();
+            for (size_t i = 0; i < count; i++) {
+                _stages[i] = stagesById[order[i]];
+            }
+
+            _stageCount = count;
+
+            if (_activeStageIndex >= _stageCount) {
+                _activeStageIndex = 0;
+                _currentPulseInStage = 0;
+            }
+
+            updateNextStageIndex();
+        }
+
         size_t indexOfActiveStage() {
             return _activeStageIndex;
         }
@@ -254,7 +433,7 @@ class Sequence {
         uint8_t selectedStagesCount() {
             uint8_t selectedStages = 0;
 
-            for (size_t i = 0; i < _stages.size(); i++) {
+            for (size_t i = 0; i < _stageCount; i++) {
                 if (_stages[i].isSelected) {
                     selectedStages++;
                 }
@@ -263,21 +442,6 @@ class Sequence {
             return selectedStages;
         }
 
-        // Returns a vector of selected stages in index order
-        std::vector<Stage*> getSelectedStages() {
-            std::vector<Stage*> selectedStages;
-
-            // Note: Stage deletion and insertion depend on this
-            // being in index order
-            for (auto& stage : _stages) {
-                if (stage.isSelected) {
-                    selectedStages.push_back(&stage);
-                }
-            }
-
-            return selectedStages;
-        }
-
         uint8_t getCurrentPulseInStage() {
             return _currentPulseInStage;
         }
@@ -291,32 +455,13 @@ class Sequence {
             return _output;
         }
 
-        float getMidiNote() {
-            int baseNote = wrap(round(_output * 12), 0, 12);
-            int distToClosestNoteUp = -1;
-            int distToClosestNoteDown = -1;
-            for (int i = 0; i < 12; i++) {
-                if (distToClosestNoteUp == -1 && quantizer[wrap(baseNote + i, 0, 12)]) {
-                    distToClosestNoteUp = i;
-                }
-
-                if (distToClosestNoteDown == -1 && quantizer[wrap(baseNote - i, 0, 12)]) {
-                    distToClosestNoteDown = i;
-                }
-
-                if (distToClosestNoteUp != -1 && distToClosestNoteDown != -1) break;
-            }
-            
-            int quantizerCorrection = (distToClosestNoteUp < distToClosestNoteDown) ? distToClosestNoteUp : -distToClosestNoteDown;
-
-            if (distToClosestNoteUp != -1 && distToClosestNoteDown != -1) {
-                return 60 + round(_output * 12) + quantizerCorrection;
-            } else {
-                return 60 + round(_output * 12);
-            }
+        // The output quantized to the scale, then moved by the active stage's transpose
+        uint8_t getMidiNote() {
+            return scale.getMidiNote(_output, getActiveStage().transpose);
         }
 
         void setBpm(float bpm) {
+            markEdited();
             _bpm = bpm;
             _bpm = min(_bpm, 500);
             _bpm = max(_bpm, 10);
@@ -328,10 +473,15 @@ class Sequence {
             return _bpm;
         }
 
+        // How many pulses make up a quarter note
+        uint8_t getSubdivision() {
+            return _subdivision;
+        }
+
         uint16_t getNewStageId() {
             // Find the lowest unused ID
             for (uint16_t id = 0; id < MAX_STAGES; id++) {
-                if (indexOfStage(id) == -1) {
+                if (indexOfStage(id) == NO_STAGE) {
                     return id;
                 }
             }
@@ -341,16 +491,20 @@ class Sequence {
             return 0;
         }
 
-        bool quantizer[12] = {1, 0, 1, 0, 1, 1, 0, 1, 0, 1, 0, 1};
+        Scale scale = Scale(12, 0xAB5); // C major
     private:
-        std::vector<Stage> _stages;
-        size_t _activeStageIndex;
+        // Stored inline so a Sequence can be copied without touching the heap
+        Stage _stages[MAX_STAGES];
+        uint8_t _stageCount = 0;
+        size_t _activeStageIndex = 0;
         size_t _nextStageIndex = 0;
         float _outputOfLastStage; // Referenced when sliding between stages
         float _bpm = 120;
         uint8_t _subdivision = 4;
-        unsigned long _microsPerPulse;
-        unsigned long _lastPulseMicros = 0;
+        uint64_t _pulsePeriodFx; // Microseconds per pulse, fixed point
+        uint64_t _lastPulseMicros = 0; // When the current pulse started
+        uint32_t _lastPulseFractionFx = 0; // And the fraction of a microsecond after that, fixed point
+        uint64_t _pulseReciprocal; // 2^PULSE_RECIPROCAL_SHIFT / microseconds per pulse, for getPulsePhase()
         float _gateLength = 0.75f; // 1 = always on, 0 = never on
         float _pulseAnticipation; // How close are we to the next pulse
         float _slideProgress; // How close are we sliding between notes
@@ -358,9 +512,25 @@ class Sequence {
         uint16_t _nextId = 0;
         float _output;
         bool _gate = false;
-        uint *_stagePulseTallyById;
+        uint32_t _pulseIndex = 0;
+        uint32_t _editCount = 0;
+        // Tracks how many times each stage has pulsed. Mostly for consistent arpeggiation purposes.
+        // Kept with the sequence so a copy can be played ahead without disturbing the original.
+        uint _stagePulseTallyById[MAX_STAGES] = {};
+
+        // Phase is microseconds since the last pulse times the reciprocal. Those are
+        // capped at one pulse, so the product never gets past 2^40
+        static const uint8_t PULSE_RECIPROCAL_SHIFT = 16 + 24;
 
+        // Worked out in double precision, it only happens when the tempo changes
         void _updateMicrosPerPulse() {
-            _microsPerPulse = 60000000 / _bpm / _subdivision;
+            _setPulsePeriodFx((uint64_t)llround(60000000.0 * (1ull << PULSE_FX_BITS) / _bpm / _subdivision));
         }
-};
\ No newline at end of file
+
+        void _setPulsePeriodFx(uint64_t pulsePeriodFx) {
+            _pulsePeriodFx = max((uint64_t)1 << PULSE_FX_BITS, pulsePeriodFx);
+            _pulseReciprocal = (1ull << PULSE_RECIPROCAL_SHIFT) / getMicrosPerPulse();
+        }
+};
+
+static_assert(std::is_trivially_copyable<Sequence>::value, "Sequences are copied as plain blocks of memory");
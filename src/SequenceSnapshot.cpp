@@ -0,0 +1,72 @@
+#include "SequenceSnapshot.hpp"
+#include <string.h>
+
+void captureSnapshot(
+    SequenceSnapshot &snapshot,
+    UndoRedoManager &undoRedoManager,
+    InteractionManager &interactionManager,
+    const ActiveButtons &activeButtons
+) {
+    Sequence &sequence = *undoRedoManager.getSequence();
+
+    snapshot.highlightedStageIndex = interactionManager._highlightedStageIndex;
+    snapshot.isEditingPosition = interactionManager._isEditingPosition;
+    snapshot.isEditingGateMode = interactionManager.gateModeButtonHandler.isEditingGateMode();
+    snapshot.isEditingPitch = interactionManager.pitchButtonHandler.isEditingPitch();
+    snapshot.isInQuantizerConfig = undoRedoManager.isInQuantizerConfig;
+    snapshot.isShowingPerfHud = interactionManager._isShowingPerfHud;
+    snapshot.hiddenValue = interactionManager._hiddenValue;
+    snapshot.cursorAngle = interactionManager._cursorAngle;
+    // In 12-TET keys, which is what the piano is drawn with
+    snapshot.quantizerConfigCursorPos = interactionManager._quantizerConfigCursorPos * 12 / sequence.scale.getDivisions();
+
+    snapshot.activeCommandCount = activeButtons.getCount();
+    for (size_t i = 0; i < snapshot.activeCommandCount; i++) {
+        snapshot.activeCommands[i] = activeButtons.getCommand(i);
+    }
+
+    // Whatever's past the end is cleared, so two snapshots of the same thing compare equal byte for byte
+    memset(&snapshot.activeCommands[snapshot.activeCommandCount], 0, (16 - snapshot.activeCommandCount) * sizeof(Command));
+
+    snapshot.stageCount = sequence.stageCount();
+    for (size_t i = 0; i < sequence.stageCount(); i++) {
+        Stage &stage = sequence.getStage(i);
+        StageSnapshot &stageSnapshot = snapshot.stages[i];
+        bool isHighlighted = snapshot.highlightedStageIndex == i || stage.isSelected;
+
+        stageSnapshot.id = stage.id;
+        stageSnapshot.clonedFromId = interactionManager._clonedFromIdById[stage.id];
+        stageSnapshot.pulseCount = stage.pulseCount;
+        stageSnapshot.gateMode = stage.gateMode;
+        stageSnapshot.isSkipped = stage.isSkipped;
+        stageSnapshot.isSelected = stage.isSelected;
+        stageSnapshot.shouldSlideIn = stage.shouldSlideIn;
+        stageSnapshot.output = stage.getOutput(sequence.getStagePulseTally(stage.id));
+        stageSnapshot.baseOutput = stage.getBaseOutput();
+
+        if (snapshot.isEditingGateMode && isHighlighted) {
+            stageSnapshot.pulsePipsAngle = stage.pulsePipsAngle;
+        } else {
+            stageSnapshot.pulsePipsAngle = Angle::fromBam(stage.gateMode * Angle::QUARTER_TURN);
+        }
+    }
+
+    memset((void *)&snapshot.stages[snapshot.stageCount], 0, (MAX_STAGES - snapshot.stageCount) * sizeof(StageSnapshot));
+
+    snapshot.scaleStepMask = sequence.scale.getStepMask();
+    snapshot.scaleDivisions = sequence.scale.getDivisions();
+    int scaleIndex = interactionManager.scaleLibrary.indexOf(sequence.scale);
+    snapshot.scaleName = (scaleIndex != -1) ? interactionManager.scaleLibrary.getName(scaleIndex) : "";
+
+    snapshot.activeStageIndex = sequence.indexOfActiveStage();
+    snapshot.nextStageIndex = sequence.getNextStageIndex();
+    snapshot.currentPulseInStage = sequence.getCurrentPulseInStage();
+    snapshot.pulseAnticipation = sequence.getPulseAnticipation();
+    snapshot.isLastPulseOfStage = sequence.isLastPulseOfStage();
+    snapshot.isSliding = sequence.isSliding();
+    snapshot.gate = sequence.getGate();
+    snapshot.output = sequence.getOutput();
+    snapshot.midiNote = sequence.getMidiNote();
+
+    snapshot.latestTraceId = getLatencyTracer().getLatestId();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Sequence.h"
+#include "Button.h"
+#include "ActiveButtons.hpp"
+#include "UndoRedoManager.hpp"
+#include "InteractionManager.hpp"
+#include "LatencyTracer.hpp"
+
+// Everything the renderer needs to know about a stage
+struct StageSnapshot {
+    uint16_t id;
+    uint16_t clonedFromId; // Its own id if it wasn't cloned
+    uint8_t pulseCount;
+    GateMode gateMode;
+    bool isSkipped;
+    bool isSelected;
+    bool shouldSlideIn;
+    Angle pulsePipsAngle; // Follows the knob while the gate mode is being edited
+    float output; // Includes arpeggiation
+    float baseOutput;
+};
+
+// A fixed size copy of the sequence, playhead and interaction state.
+// Published by the sequencer core so the render core never reads state
+// that's in the middle of being edited.
+struct SequenceSnapshot {
+    StageSnapshot stages[MAX_STAGES];
+    uint8_t stageCount;
+    uint32_t scaleStepMask;
+    uint8_t scaleDivisions;
+    const char *scaleName; // Empty if the scale isn't in the library
+
+    // Playhead
+    uint8_t activeStageIndex;
+    uint8_t nextStageIndex;
+    uint8_t currentPulseInStage;
+    float pulseAnticipation;
+    bool isLastPulseOfStage;
+    bool isSliding;
+    bool gate;
+    float output;
+    uint8_t midiNote;
+
+    // Interaction
+    uint8_t highlightedStageIndex;
+    bool isEditingPosition;
+    bool isEditingGateMode;
+    bool isEditingPitch;
+    bool isInQuantizerConfig;
+    bool isShowingPerfHud;
+    float hiddenValue;
+    Angle cursorAngle;
+    float quantizerConfigCursorPos;
+    Command activeCommands[16];
+    uint8_t activeCommandCount;
+
+    // The latest input traced when it was taken. Kept last, it's not part of how things look
+    uint16_t latestTraceId;
+};
+
+void captureSnapshot(
+    SequenceSnapshot &snapshot,
+    UndoRedoManager &undoRedoManager,
+    InteractionManager &interactionManager,
+    const ActiveButtons &activeButtons
+);
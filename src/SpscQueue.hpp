@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// A fixed size ring that one producer and one consumer can use at the same
+// time without locks, whether they're on different cores or one of them is
+// an interrupt. Pushing to a full queue fails rather than waiting.
+template <typename T, size_t CAPACITY>
+class SpscQueue {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    public:
+        // Producer
+        bool push(const T &item) {
+            uint32_t head = _head.load(std::memory_order_relaxed);
+            if (head - _tail.load(std::memory_order_acquire) >= CAPACITY) return false;
+
+            _items[head & INDEX_MASK] = item;
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer
+        bool pop(T &item) {
+            const T *front = peek();
+            if (front == nullptr) return false;
+
+            item = *front;
+            drop();
+            return true;
+        }
+
+        // Returns the oldest item without removing it, or nullptr if the queue is empty
+        const T *peek() {
+            uint32_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail == _head.load(std::memory_order_acquire)) return nullptr;
+
+            return &_items[tail & INDEX_MASK];
+        }
+
+        // Removes the item returned by peek()
+        void drop() {
+            _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        size_t size() {
+            return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+        }
+
+        size_t spaceLeft() {
+            return CAPACITY - size();
+        }
+
+    private:
+        static const uint32_t INDEX_MASK = CAPACITY - 1;
+
+        T _items[CAPACITY];
+        std::atomic<uint32_t> _head {0}; // Free running, only wrapped when indexing
+        std::atomic<uint32_t> _tail {0};
+};
@@ -1,5 +1,6 @@
 #pragma once
-#include <pico/types.h>
+#include "Compat.h"
+#include "Angle.hpp"
 
 enum GateMode {
     EACH,
@@ -22,15 +23,16 @@ class StageDrawInfo {
     public:
         float output = 0;
         float pulseCount = 0;
-        float pulsePipsAngle = 0;
+        Angle pulsePipsAngle;
         float isSkipped = 0;
         float isSelected = 0;
         float shouldSlideIn = 0;
 
         float radius = 0;
-        float angle = 0;
+        Angle angle;
 };
 
+// Anything added here needs packing into DeltaHistory's undo states too
 class Stage {
 public:
     uint16_t id;
@@ -41,13 +43,14 @@ public:
     bool shouldSlideIn = false;
     bool shouldArpeggiate = false;
     uint8_t arpSteps = 5;
+    int8_t transpose = 0; // In degrees of the sequence's scale, applied after quantizing
     float arpStepWidth = 0.2;
 
     // TODO: Make arpeggiation undo/redo compatible
     // size_t arppegiationOffset = 0; // Saves the global pulse count when arpeggiation is toggled on
 
     // Render stuff
-    float pulsePipsAngle = 0;
+    Angle pulsePipsAngle;
 
     bool isPulseActive(uint8_t index) {
         if (isSkipped) return false;
@@ -78,6 +81,7 @@ public:
     }
 
     Stage(uint16_t id) : id(id) {}
+    Stage() : Stage(0) {}
 
 private:
     float output = 1;
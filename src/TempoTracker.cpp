@@ -0,0 +1,100 @@
+#include "TempoTracker.hpp"
+#include <math.h>
+#include <stdio.h>
+
+// Loop gains, critically damped. Fast while locking on, slow once locked
+const float FAST_PHASE_GAIN = 0.5f;
+const float FAST_PERIOD_GAIN = 0.0625f;
+const float SLOW_PHASE_GAIN = 0.125f;
+const float SLOW_PERIOD_GAIN = 0.00390625f;
+
+// Ticks in a row within LOCK_WINDOW of where they were expected before we
+// call it locked, and outside UNLOCK_WINDOW before we give up on the lock.
+// Both are fractions of a tick
+const uint8_t TICKS_TO_LOCK = 8;
+const uint8_t TICKS_TO_UNLOCK = 4;
+const float LOCK_WINDOW = 0.125f;
+const float UNLOCK_WINDOW = 0.25f;
+
+// Supports 10 to 500bpm at 1 tick per 16th, or 24 ticks per quarter
+const float MIN_MICROS_PER_TICK = 60000000.f / 500 / 24;
+const float MAX_MICROS_PER_TICK = 60000000.f / 10 / 4;
+
+void TempoTracker::reset() {
+    _tickCount = 0;
+    _microsPerTick = 0;
+    _isLocked = false;
+    _goodTickCount = 0;
+    _badTickCount = 0;
+    resetStats();
+}
+
+void TempoTracker::onTick(uint64_t tickMicros) {
+    if (_tickCount < 2) {
+        // The first two ticks give us a starting guess at the tempo
+        if (_tickCount == 1) {
+            _microsPerTick = fminf(fmaxf(tickMicros - _tickMicros, MIN_MICROS_PER_TICK), MAX_MICROS_PER_TICK);
+        }
+
+        _tickMicros = tickMicros;
+        _tickCount++;
+        return;
+    }
+
+    float phaseError = (float)(int64_t)(tickMicros - _tickMicros) - _microsPerTick;
+
+    // Way off, the clock has probably stopped and started again. Start over
+    if (fabsf(phaseError) > _microsPerTick * 2) {
+        reset();
+        onTick(tickMicros);
+        return;
+    }
+
+    uint32_t absPhaseError = fabsf(phaseError);
+    _phaseErrorMicros = phaseError;
+    _maxPhaseErrorMicros = absPhaseError > _maxPhaseErrorMicros ? absPhaseError : _maxPhaseErrorMicros;
+    _totalPhaseErrorMicros += absPhaseError;
+    _statTickCount++;
+
+    bool isGood = fabsf(phaseError) < _microsPerTick * LOCK_WINDOW;
+    bool isBad = fabsf(phaseError) > _microsPerTick * UNLOCK_WINDOW;
+    _goodTickCount = isGood ? _goodTickCount + 1 : 0;
+    _badTickCount = isBad ? _badTickCount + 1 : 0;
+
+    if (!_isLocked && _goodTickCount >= TICKS_TO_LOCK) {
+        _isLocked = true;
+        _lockedMicrosPerTick = _microsPerTick;
+    } else if (_isLocked && _badTickCount >= TICKS_TO_UNLOCK) {
+        _isLocked = false;
+    }
+
+    if (_isLocked) {
+        // One stray tick can only pull us so far
+        float maxError = _microsPerTick * UNLOCK_WINDOW;
+        phaseError = fminf(fmaxf(phaseError, -maxError), maxError);
+    }
+
+    float phaseGain = _isLocked ? SLOW_PHASE_GAIN : FAST_PHASE_GAIN;
+    float periodGain = _isLocked ? SLOW_PERIOD_GAIN : FAST_PERIOD_GAIN;
+
+    _tickMicros += (int64_t)lroundf(_microsPerTick + phaseGain * phaseError);
+    _microsPerTick = fminf(fmaxf(_microsPerTick + periodGain * phaseError, MIN_MICROS_PER_TICK), MAX_MICROS_PER_TICK);
+    _tickCount++;
+}
+
+void TempoTracker::resetStats() {
+    _phaseErrorMicros = 0;
+    _maxPhaseErrorMicros = 0;
+    _totalPhaseErrorMicros = 0;
+    _statTickCount = 0;
+}
+
+const char *TempoTracker::getStatsHeader() {
+    return "clock        ticks locked   us/tick  phase us    max us   mean us  drift ppm";
+}
+
+void TempoTracker::formatStats(const char *name, char *text, size_t size) {
+    snprintf(text, size, "%-9s %8lu %6s %9.1f %9ld %9lu %9.1f %10.1f",
+        name, (unsigned long)_statTickCount, _isLocked ? "yes" : "no", _microsPerTick,
+        (long)_phaseErrorMicros, (unsigned long)_maxPhaseErrorMicros, getMeanPhaseErrorMicros(), getDriftPpm());
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Follows an external clock with a software phase locked loop. Each tick
+// nudges where the next one is expected and the estimated time between
+// ticks, so jitter in when the ticks arrive is smoothed out rather than
+// passed on to the sequence.
+// It starts out with loose gains so it locks on quickly, then tightens
+// them once ticks are landing where they're expected.
+class TempoTracker {
+    public:
+        void reset();
+
+        // Called for every tick, in order, with when it arrived
+        void onTick(uint64_t tickMicros);
+
+        // Whether there have been enough ticks to estimate the tempo
+        bool hasTempo() { return _tickCount >= 2; }
+        bool isLocked() { return _isLocked; }
+
+        // When the last tick should have arrived, with the jitter filtered out
+        uint64_t getTickMicros() { return _tickMicros; }
+        float getMicrosPerTick() { return _microsPerTick; }
+
+        // How far ticks land from where they were expected
+        int32_t getPhaseErrorMicros() { return _phaseErrorMicros; }
+        uint32_t getMaxPhaseErrorMicros() { return _maxPhaseErrorMicros; }
+        float getMeanPhaseErrorMicros() { return _statTickCount > 0 ? _totalPhaseErrorMicros / (float)_statTickCount : 0; }
+
+        // How far the tempo has wandered since it locked, in parts per million
+        float getDriftPpm() { return _isLocked ? (_microsPerTick / _lockedMicrosPerTick - 1) * 1000000 : 0; }
+
+        void resetStats();
+
+        // A line of text for the perf table printed over serial, name says which clock it's following
+        static const char *getStatsHeader();
+        void formatStats(const char *name, char *text, size_t size);
+
+    private:
+        uint32_t _tickCount = 0;
+        uint64_t _tickMicros = 0;
+        float _microsPerTick = 0;
+        bool _isLocked = false;
+        uint8_t _goodTickCount = 0; // In a row, landing close to where they were expected
+        uint8_t _badTickCount = 0; // In a row, landing far from where they were expected
+        float _lockedMicrosPerTick = 0;
+
+        int32_t _phaseErrorMicros = 0;
+        uint32_t _maxPhaseErrorMicros = 0;
+        uint64_t _totalPhaseErrorMicros = 0;
+        uint32_t _statTickCount = 0;
+};
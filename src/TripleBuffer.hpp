@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Passes the latest value of T from one core to another without locks.
+// The writer always has a buffer of its own to fill, and the reader always
+// gets the most recently published complete value. Neither side ever waits.
+template <typename T>
+class TripleBuffer {
+    public:
+        // Writer: fill this buffer, then publish() it
+        T &getWriteBuffer() {
+            return _buffers[_writeIndex];
+        }
+
+        void publish() {
+            // Swap the freshly written buffer with the spare one
+            _writeIndex = _spare.exchange(_writeIndex | FRESH_BIT) & INDEX_MASK;
+        }
+
+        // Reader: the returned value stays untouched until the next call to read()
+        const T &read() {
+            if (_spare.load() & FRESH_BIT) {
+                _readIndex = _spare.exchange(_readIndex) & INDEX_MASK;
+            }
+
+            return _buffers[_readIndex];
+        }
+
+    private:
+        static const uint8_t INDEX_MASK = 0b011;
+        static const uint8_t FRESH_BIT = 0b100; // Set when the spare buffer holds an unread value
+
+        T _buffers[3] = {};
+        uint8_t _writeIndex = 0;
+        std::atomic<uint8_t> _spare {1};
+        uint8_t _readIndex = 2;
+};
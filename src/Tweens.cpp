@@ -0,0 +1,115 @@
+#include "Tweens.hpp"
+
+// A tenth of the way every 16ms, as the per-frame lerps this replaced did at 60fps
+const float SHARE_LEFT_PER_16_MILLIS = 0.9f;
+
+Tweens::Tweens() {
+    for (uint16_t millis = 0; millis <= MAX_STEP_MILLIS; millis++) {
+        _decayAfterMillis[millis] = lroundf(65536 * powf(SHARE_LEFT_PER_16_MILLIS, millis / 16.f));
+    }
+}
+
+Tweens::Tween *Tweens::find(void *value) {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_tweens[i].floatValue == value || _tweens[i].angleValue == value) return &_tweens[i];
+    }
+
+    return nullptr;
+}
+
+Tweens::Tween *Tweens::add() {
+    if (_count >= MAX_TWEENS) return nullptr;
+
+    Tween *tween = &_tweens[_count++];
+    *tween = {};
+    return tween;
+}
+
+// The last one takes its place, order doesn't matter
+void Tweens::remove(Tween *tween) {
+    *tween = _tweens[--_count];
+}
+
+void Tweens::easeTo(float *value, float target) {
+    Tween *tween = find(value);
+    if (tween == nullptr && *value == target) return;
+    if (tween != nullptr && tween->floatTarget == target) return;
+
+    float distance = (target - *value) * FLOAT_ONE;
+
+    // Too far to keep in fixed point, or too near to bother
+    if (fabsf(distance) >= INT32_MAX / 2 || fabsf(distance) < SNAP_DISTANCE) {
+        jumpTo(value, target);
+        return;
+    }
+
+    if (tween == nullptr) tween = add();
+    if (tween == nullptr) {
+        *value = target;
+        return;
+    }
+
+    tween->floatValue = value;
+    tween->floatTarget = target;
+    tween->remaining = distance;
+}
+
+void Tweens::easeTo(Angle *value, Angle target) {
+    Tween *tween = find(value);
+    if (tween == nullptr && *value == target) return;
+    if (tween != nullptr && tween->angleTarget == target) return;
+
+    if (tween == nullptr) tween = add();
+    if (tween == nullptr) {
+        *value = target;
+        return;
+    }
+
+    tween->angleValue = value;
+    tween->angleTarget = target;
+    tween->remaining = value->deltaTo(target) * ANGLE_ONE;
+}
+
+void Tweens::jumpTo(float *value, float target) {
+    Tween *tween = (_count > 0) ? find(value) : nullptr;
+    if (tween != nullptr) remove(tween);
+
+    *value = target;
+}
+
+void Tweens::jumpTo(Angle *value, Angle target) {
+    Tween *tween = (_count > 0) ? find(value) : nullptr;
+    if (tween != nullptr) remove(tween);
+
+    *value = target;
+}
+
+void Tweens::update(uint32_t nowMillis) {
+    uint32_t elapsedMillis = _hasUpdated ? nowMillis - _lastMillis : 0;
+    _lastMillis = nowMillis;
+    _hasUpdated = true;
+
+    uint32_t decay = _decayAfterMillis[min(elapsedMillis, (uint32_t)MAX_STEP_MILLIS)];
+
+    for (uint8_t i = 0; i < _count;) {
+        Tween &tween = _tweens[i];
+        // Rounded, cutting it short every step would make high frame rates arrive sooner
+        tween.remaining = ((int64_t)tween.remaining * decay + 0x8000) >> 16;
+
+        // Anything that arrives is written out and dropped, which moves the last one here
+        if (abs(tween.remaining) < SNAP_DISTANCE) {
+            if (tween.floatValue != nullptr) *tween.floatValue = tween.floatTarget;
+            if (tween.angleValue != nullptr) *tween.angleValue = tween.angleTarget;
+            remove(&tween);
+            continue;
+        }
+
+        if (tween.floatValue != nullptr) {
+            *tween.floatValue = tween.floatTarget - (float)tween.remaining / FLOAT_ONE;
+        } else {
+            *tween.angleValue = tween.angleTarget - Angle::fromBam(tween.remaining / ANGLE_ONE);
+        }
+
+        i++;
+    }
+}
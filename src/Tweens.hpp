@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Compat.h"
+#include "Angle.hpp"
+
+// Eases values towards their targets by the same share of the way for each
+// millisecond that passes, so it looks the same at any frame rate. Only the
+// values still on their way are kept track of. Once they've all arrived there's
+// nothing to step and isAtRest says so.
+//
+// What's left to go is kept in fixed point and shrunk with a table lookup and
+// a multiply. It snaps to the target once it's too small to see.
+class Tweens {
+    public:
+        static const uint8_t MAX_TWEENS = 64; // Enough for everything on a stage, for 16 stages
+        // Longer gaps than this, like after a stall, only ease this far
+        static const uint16_t MAX_STEP_MILLIS = 100;
+
+        Tweens();
+
+        // Starts value easing towards target, or moves the target if it's already on its way
+        void easeTo(float *value, float target);
+        void easeTo(Angle *value, Angle target);
+
+        // Puts value straight at target, stopping it if it was easing
+        void jumpTo(float *value, float target);
+        void jumpTo(Angle *value, Angle target);
+
+        // Moves everything on to nowMillis and writes the values out
+        void update(uint32_t nowMillis);
+
+        bool isAtRest() const { return _count == 0; }
+        uint8_t getCount() const { return _count; }
+
+    private:
+        // Floats are eased in 1/65536ths, angles in 1/256ths of a BAM step
+        static const int32_t FLOAT_ONE = 1 << 16;
+        static const int32_t ANGLE_ONE = 1 << 8;
+        // Anything left under this is close enough to snap
+        static const int32_t SNAP_DISTANCE = 256;
+
+        struct Tween {
+            float *floatValue; // One or the other is set
+            Angle *angleValue;
+            float floatTarget;
+            Angle angleTarget;
+            int32_t remaining; // Fixed point, how far short of the target the value is
+        };
+
+        Tween *find(void *value);
+        Tween *add();
+        void remove(Tween *tween);
+
+        // Share of what's left after n milliseconds, Q16
+        uint32_t _decayAfterMillis[MAX_STEP_MILLIS + 1];
+
+        Tween _tweens[MAX_TWEENS];
+        uint8_t _count = 0;
+        uint32_t _lastMillis = 0;
+        bool _hasUpdated = false;
+};
@@ -1,14 +1,13 @@
 #pragma once
 
 #include "Sequence.h"
+#include "DeltaHistory.hpp"
 #include "utils.h"
 
-const uint8_t UNDO_REDO_SIZE = 24;
-
 class UndoRedoManager {
     public:
         UndoRedoManager() {
-            history[0] = sequence;
+            history.reset(sequence);
         }
 
         Sequence* getSequence() {
@@ -16,39 +15,22 @@ class UndoRedoManager {
         }
 
         void saveUndoRedoSnapshot() {
-            // Write the current sequence to the next slot in the ring buffer
-            curPosInHistory = wrap(curPosInHistory + 1, 0, UNDO_REDO_SIZE);
-            history[curPosInHistory] = sequence;
-        
-            indexOfNewestSnapshot = curPosInHistory;
-        
-            // If the ring buffer has caught up to it's tail, update the location of the tail
-            if (indexOfNewestSnapshot == indexOfOldestSnapshot) {
-                indexOfOldestSnapshot = wrap(indexOfOldestSnapshot + 1, 0, UNDO_REDO_SIZE);
-            }
+            history.commit(sequence);
         }
         
         void undo() {
-            if (curPosInHistory == indexOfOldestSnapshot) return; // Can't go further back
-        
-            curPosInHistory = wrap(curPosInHistory - 1, 0, UNDO_REDO_SIZE);
-            sequence = history[curPosInHistory];
+            history.undo(sequence);
         }
         
         void redo() {
-            if (curPosInHistory == indexOfNewestSnapshot) return; // Can't go further forwards
-        
-            curPosInHistory = wrap(curPosInHistory + 1, 0, UNDO_REDO_SIZE);
-            sequence = history[curPosInHistory];
+            history.redo(sequence);
         }
 
-        StageDrawInfo stageDrawInfoById[MAX_STAGES];
+        uint16_t getUndoStepCount() { return history.getUndoStepCount(); }
+        uint16_t getRedoStepCount() { return history.getRedoStepCount(); }
+
         bool isInQuantizerConfig = false;
-        uint stagePulseTallyById[MAX_STAGES]; // Tracks how many times each stage has pulsed. Mostly for consistent arpeggiation purposes
     private:
-        Sequence sequence = Sequence(4, stagePulseTallyById);
-        Sequence history[UNDO_REDO_SIZE];
-        uint8_t curPosInHistory = 0;
-        uint8_t indexOfOldestSnapshot = 0;
-        uint8_t indexOfNewestSnapshot = 0;
-};
\ No newline at end of file
+        Sequence sequence = Sequence(4);
+        DeltaHistory history;
+};
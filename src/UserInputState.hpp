@@ -1,11 +1,12 @@
 #pragma once
 
 #include "Button.h"
-#include "SineCosinePot.h"
+#include "ActiveButtons.hpp"
+#include "sineCosinePot.h"
 
 class UserInputState {
     public:
-        UserInputState(SineCosinePot *endlessPot, std::vector<Button*> &activeButtons);
+        UserInputState(SineCosinePot *endlessPot, const ActiveButtons &activeButtons);
 
         Button &getBaseButton() { return *_baseButton; }
         Command getBaseCommand() { return _baseCommand; }
@@ -15,7 +16,6 @@ class UserInputState {
         float getAngleDelta() { return _endlessPot->getAngleDelta(); }
     private:
         SineCosinePot *_endlessPot;
-        std::vector<Button*> _activeButtons;
         Button *_baseButton = nullptr;
         Command _baseCommand = NOTHING;
         Button *_modifierButton = nullptr;
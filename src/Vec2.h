@@ -1,8 +1,7 @@
 #pragma once
 
 #include "utils.h"
-
-const float DEG_TO_TAU = 3.14 * 2 / 360.f;
+#include "Angle.hpp"
 
 class Vec2 {
   public:
@@ -43,12 +42,54 @@ class Vec2 {
     }
 
     // 0º is up
+    static Vec2 fromPolar(float radius, Angle angle) {
+      return Vec2(radius * angle.sin(), -radius * angle.cos());
+    }
+
     static Vec2 fromPolar(float radius, float degrees) {
-      float tau = (degrees - 90) * DEG_TO_TAU;
-      float x = radius * cosf(tau);
-      float y = radius * sinf(tau);
+      return fromPolar(radius, Angle::fromDegrees(degrees));
+    }
+};
+
+// Vec2 in Q16.16 fixed point, for positions worked out in bulk
+class Vec2Fx {
+  public:
+    static const int32_t ONE = 1 << 16;
+
+    int32_t x;
+    int32_t y;
+
+    Vec2Fx(int32_t x, int32_t y) {
+      this->x = x;
+      this->y = y;
+    }
+
+    static Vec2Fx fromVec2(Vec2 v) {
+      return Vec2Fx(lroundf(v.x * ONE), lroundf(v.y * ONE));
+    }
+
+    Vec2 toVec2() {
+      return Vec2(x * (1.f / ONE), y * (1.f / ONE));
+    }
+
+    Vec2Fx operator+(const Vec2Fx& rhs) {
+      return Vec2Fx(x + rhs.x, y + rhs.y);
+    }
+
+    Vec2Fx operator-(const Vec2Fx& rhs) {
+      return Vec2Fx(x - rhs.x, y - rhs.y);
+    }
+
+    // Whole pixels, rounded down
+    int32_t pixelX() { return x >> 16; }
+    int32_t pixelY() { return y >> 16; }
 
-      return Vec2(x, y);
+    // 0º is up, radius in whole pixels
+    static Vec2Fx fromPolar(int32_t radius, Angle angle) {
+      return Vec2Fx(
+        radius * angle.sinQ15() * 2,
+        -radius * angle.cosQ15() * 2
+      );
     }
 };
 
@@ -1,6 +1,6 @@
 #include <Arduino.h>
 #include "utils.h"
-#include "SineCosinePot.h"
+#include "sineCosinePot.h"
 #include "Sequence.h"
 #include "Vec2.h"
 #include "Button.h"
@@ -16,7 +16,21 @@
 #include "SelectionState.hpp"
 #include "UserInputState.hpp"
 #include "Render.hpp"
+#include "GlyphCache.hpp"
 #include "InteractionManager.hpp"
+#include "ClockEngine.hpp"
+#include "ClockInput.hpp"
+#include "MidiOutput.hpp"
+#include "PicoHal.hpp"
+#include "LookaheadScheduler.hpp"
+#include "SpscQueue.hpp"
+#include "SequenceSnapshot.hpp"
+#include "TripleBuffer.hpp"
+#include "PerfStats.hpp"
+#include "ButtonScanner.hpp"
+#include "ActiveButtons.hpp"
+#include "CalibrationStore.hpp"
+#include "LatencyTracer.hpp"
 
 // USB MIDI object
 Adafruit_USBD_MIDI usb_midi;
@@ -25,16 +39,47 @@ Adafruit_USBD_MIDI usb_midi;
 // and attach usb_midi as the transport.
 MIDI_CREATE_INSTANCE(Adafruit_USBD_MIDI, usb_midi, MIDI);
 
-Sequence *sequence;
+PicoHal picoHal = PicoHal(&usb_midi);
+IHal &getHal() { return picoHal; }
+
+Sequence *sequence; // The undo manager's copy, edited without holding off the alarm
+Sequence playingSequence; // What the clock engine plays, see publishEdits()
 UndoRedoManager undoRedoManager;
 InteractionManager interactionManager;
+ClockEngine clockEngine;
+LookaheadScheduler scheduler;
+ClockInput clockInput;
+MidiOutput midiOutput; // Filled by core 1, written to USB by core 0
+TripleBuffer<SequenceSnapshot> snapshotBuffer; // Published by core 1, rendered by core 0
+StageDrawInfo stageDrawInfoById[MAX_STAGES]; // Animated by core 0 only
 
 SineCosinePot endlessPot = SineCosinePot(0, 1);
+CalibrationStore calibrationStore;
+
+// Asked for over serial on core 0, done on core 1 where the pot's read,
+// then answered back to core 0 to print
+enum PotRequest : uint8_t {
+  POT_REQUEST_NONE,
+  POT_REQUEST_CALIBRATE,
+  POT_REQUEST_SAVE,
+  POT_REQUEST_SAVED,
+  POT_REQUEST_REJECTED
+};
+volatile PotRequest potRequest = POT_REQUEST_NONE;
+
+// The input traced this tick, if there was one, and the one whose edit was
+// last replanned, for the next gate to be tagged with. Both 0 when there isn't
+uint16_t inputTraceId = 0;
+volatile uint16_t gateTraceId = 0;
+uint32_t lastReplanCount = 0;
+// Less than this is just the pot's noise, not worth tracing
+const float KNOB_TRACE_DEGREES = 0.5f;
 
 uint8_t gate1Pin = D14;
 uint8_t gate2Pin = D15;
 uint8_t pitchPin = D22;
 uint8_t cvPin = D21;
+uint8_t clockInPin = D16;
 uint8_t switchMultPin = D9;
 uint8_t ledMultPin = D4;
 
@@ -49,143 +94,408 @@ Button arpBtn = Button(ARP);
 Button quantBtn = Button(QUANTIZER);
 Button cloneBtn = Button(CLONE);
 Button deleteBtn = Button(DELETE);
-std::vector<Button*> buttons = {
+// By mux channel
+Button *buttons[16] = {
   &deleteBtn, nullptr, &cloneBtn, nullptr, 
   &quantBtn, nullptr, &selectBtn, &pitchBtn,
   nullptr,  &arpBtn, &moveBtn, nullptr,
   &redoBtn, &pulsesBtn, &gatemodeBtn, &undoBtn
 };
 
-std::vector<Button*> activeButtons; // Buttons that are held, or fallingEdge == true.
+ActiveButtons activeButtons; // Buttons that are held, or fallingEdge == true, in the order they were pressed
 
-Multiplexer switchMult = Multiplexer(D13, D12, D11, D10);
+// Drives switchMult's select lines and reads switchMultPin from PIO
+ButtonScanner buttonScanner = ButtonScanner(D13, D12, D11, D10, switchMultPin);
 Multiplexer switchLedMult = Multiplexer(D8, D7, D6, D5);
 
 float lastHighlightedStageIndicatorAngle = 0;
 bool lastSelectToggleState = true;
-bool lastGateValue = false;
+
+// Where the pitch output is sliding between, set by PITCH events
+float pitchFrom = 0;
+float pitchTarget = 0;
+uint64_t pitchSlideStartMicros = 0;
+uint32_t pitchSlideMicros = 0;
+float currentPitch = 0;
 
 void processInput();
+void onSequenceEvent(const SequenceEvent &event);
+void onClockInEdge();
+void onMidiClock();
+void onMidiStart();
+void onMidiStop();
+void onMidiContinue();
+void updatePitchOutput();
+void publishSnapshot();
+void publishEdits();
+void followPlayingSequence();
+void processSerialCommands();
+void processPotRequest();
 
 void setup() {
   sequence = undoRedoManager.getSequence();
   MIDI.begin(MIDI_CHANNEL_OMNI);
+  MIDI.setHandleClock(onMidiClock);
+  MIDI.setHandleStart(onMidiStart);
+  MIDI.setHandleStop(onMidiStop);
+  MIDI.setHandleContinue(onMidiContinue);
   Serial.begin(115200);
+  picoHal.enableCycleCounter();
   initScreen();
 
   // Initialize GPIO
-  pinMode(gate1Pin, OUTPUT);
-  pinMode(gate2Pin, OUTPUT);
-  pinMode(switchMultPin, INPUT_PULLUP);
-  pinMode(ledMultPin, OUTPUT);
+  getHal().setPinMode(gate1Pin, HAL_OUTPUT);
+  getHal().setPinMode(gate2Pin, HAL_OUTPUT);
+  getHal().setPinMode(switchMultPin, HAL_INPUT_PULLUP);
+  getHal().setPinMode(ledMultPin, HAL_OUTPUT);
 }
 
-uint8_t currentNote = 0;
-
 void loop() {
-  updateAnimations(
-    undoRedoManager,
-    interactionManager
-  );
-  
-  // Gate LED
-  digitalWrite(gate1Pin, sequence->getGate());
-  // digitalWrite(gate2Pin, sequence->getGate());
-  // Pitch LED
-  analogWrite(pitchPin, powf((sequence->getOutput() + 1) / 2, 2) * 255);
-  // analogWrite(cvPin, powf((sequence->getOutput() + 1) / 2, 2) * 255);
+  // All USB MIDI traffic happens on this core, so a stalled host can't hold up the sequencer
+  while (MIDI.read()) {}
+  midiOutput.flush(getHal().getMicros());
+  processSerialCommands();
 
-  analogWrite(ledMultPin, 30);
+  // Core 0 only ever looks at the latest published snapshot, never the live sequence
+  const SequenceSnapshot &snapshot = snapshotBuffer.read();
+
+  // The gate and pitch LEDs are driven by scheduled events on core 1
+  getHal().writePwm(ledMultPin, 30);
   
-  renderIfDmaIsReady(
-    undoRedoManager,
-    interactionManager, 
-    activeButtons
-  );
+  updateDisplay(snapshot, stageDrawInfoById);
 }
 
-void loop1() {
-  processInput();
-  sequence->update(micros());
+// Core 1 runs the sequencer. The clock engine's alarm interrupt is claimed
+// here so that pulse boundaries and events are handled on this core.
+void setup1() {
+  picoHal.enableCycleCounter();
+
+  // As is the clock input's, so its edges can't land in the middle of an edit
+  getHal().setPinMode(clockInPin, HAL_INPUT);
+  attachInterrupt(digitalPinToInterrupt(clockInPin), onClockInEdge, RISING);
+
+  clockEngine.setScheduler(&scheduler, onSequenceEvent);
+  playingSequence = *sequence;
+  clockEngine.begin(&playingSequence, getHal().getMicros());
+  picoHal.beginAnalog();
+
+  // Without a saved calibration the pot's assumed to reach right across the ADC
+  PotCalibration potCalibration;
+  calibrationStore.begin();
+  if (calibrationStore.loadPot(potCalibration)) {
+    endlessPot.setCalibration(potCalibration);
+  }
 
-  if (sequence->getGate() != lastGateValue) {
-    if (sequence->getGate()) {
-      currentNote = sequence->getMidiNote();
-      MIDI.sendNoteOn(currentNote, 255, 1);
-    } else {
-      MIDI.sendNoteOff(currentNote, 0, 1);
-    }
+  for (uint8_t channel = 0; channel < 16; channel++) {
+    activeButtons.setButton(channel, buttons[channel]);
+  }
+  buttonScanner.begin();
+  publishSnapshot();
+}
 
-    lastGateValue = sequence->getGate();
+uint8_t currentNote = 0;
+bool isNoteOn = false;
+
+// Called from the clock engine's alarm interrupt when a planned event is due
+void onSequenceEvent(const SequenceEvent &event) {
+  // Echoing clock and transport back to the clock we're following could loop
+  bool isMidiClockOut = clockInput.getSource() != CLOCK_MIDI;
+
+  switch (event.type) {
+    case EVENT_PITCH:
+      pitchFrom = currentPitch;
+      pitchTarget = event.output;
+      pitchSlideStartMicros = event.micros;
+      pitchSlideMicros = event.slideMicros;
+      break;
+    case EVENT_GATE_ON:
+      // Gate LED
+      getHal().writePin(gate1Pin, true);
+      // getHal().writePin(gate2Pin, true);
+      getLatencyTracer().record(LATENCY_GATE, gateTraceId, getHal().getMicros());
+      // A replanned gate on can land while the last note's still on. If the edit changed the note, end the old one first
+      if (isNoteOn && event.midiNote != currentNote) {
+        midiOutput.sendNoteOff(currentNote, 1, event.micros);
+        isNoteOn = false;
+      }
+      if (!isNoteOn) {
+        currentNote = event.midiNote;
+        midiOutput.sendNoteOn(currentNote, 127, 1, event.micros, gateTraceId);
+        isNoteOn = true;
+      }
+      gateTraceId = 0;
+      break;
+    case EVENT_GATE_OFF:
+      getHal().writePin(gate1Pin, false);
+      // getHal().writePin(gate2Pin, false);
+      getLatencyTracer().record(LATENCY_GATE, gateTraceId, getHal().getMicros());
+      if (isNoteOn) {
+        midiOutput.sendNoteOff(currentNote, 1, event.micros, gateTraceId);
+        isNoteOn = false;
+      }
+      gateTraceId = 0;
+      break;
+    case EVENT_CLOCK:
+      if (isMidiClockOut) midiOutput.sendRealTime(MIDI_CLOCK, event.micros);
+      break;
+    case EVENT_START:
+      if (isMidiClockOut) midiOutput.sendRealTime(MIDI_START, event.micros);
+      break;
+    case EVENT_STOP:
+      if (isMidiClockOut) midiOutput.sendRealTime(MIDI_STOP, event.micros);
+      break;
   }
 }
 
-uint nextButtonIndex = 0;
+void onClockInEdge() {
+  clockInput.onAnalogEdge(getHal().getMicros());
+}
+
+// MIDI messages are stamped as they're read, the tempo tracker smooths out the USB jitter
+void onMidiClock() {
+  clockInput.onMidiMessage(CLOCK_TICK, getHal().getMicros());
+}
+
+void onMidiStart() {
+  clockInput.onMidiMessage(CLOCK_START, getHal().getMicros());
+}
 
-// Updates the state of one of the buttons, and progresses
-// the mux to the next button.
-// We update buttons one by one so we don't have to wait for the 
-// mux to settle.
-void updateButtons() {
-  Button *buttonToUpdate = buttons[nextButtonIndex];
+void onMidiStop() {
+  clockInput.onMidiMessage(CLOCK_STOP, getHal().getMicros());
+}
 
-  // TODO: Rethink 
-  for (Button *x: buttons) {
-    if ( x != nullptr ) {
-      x->stabilizeState();
+void onMidiContinue() {
+  clockInput.onMidiMessage(CLOCK_CONTINUE, getHal().getMicros());
+}
+
+void loop1() {
+  {
+    PerfScope scope(PERF_INPUT);
+    processInput();
+  }
+
+  {
+    PerfScope scope(PERF_SEQUENCE);
+    publishEdits();
+
+    uint64_t nowMicros = getHal().getMicros();
+    clockInput.update(clockEngine, playingSequence, nowMicros);
+    followPlayingSequence();
+    sequence->updateOutputs(nowMicros);
+
+    // Planned from the copy with the alarm running. If a pulse has gone by
+    // since the copy was taken it's left until next time round
+    if (clockEngine.isRunning() && sequence->getPulseIndex() == playingSequence.getPulseIndex()) {
+      scheduler.plan(*sequence, nowMicros);
+      clockEngine.rearm();
+    }
+
+    // The edit changed what's about to play, so the next gate's the first to show it
+    if (scheduler.getReplanCount() != lastReplanCount) {
+      lastReplanCount = scheduler.getReplanCount();
+      if (inputTraceId != 0) gateTraceId = inputTraceId;
     }
   }
 
-  if (buttonToUpdate != nullptr) {
-    buttonToUpdate->update(!gpio_get(D9));
+  updatePitchOutput();
+  publishSnapshot();
+}
+
+void updatePitchOutput() {
+  uint64_t nowMicros = getHal().getMicros();
+  uint64_t microsIntoSlide = nowMicros - min(nowMicros, pitchSlideStartMicros);
+
+  if (microsIntoSlide >= pitchSlideMicros) {
+    currentPitch = pitchTarget;
+  } else {
+    currentPitch = lerp(pitchFrom, pitchTarget, microsIntoSlide / (float)pitchSlideMicros);
   }
 
-  nextButtonIndex += 1;
-  nextButtonIndex %= 16;
-  switchMult.select(nextButtonIndex);
+  // Pitch LED
+  getHal().writePwm(pitchPin, powf((currentPitch + 1) / 2, 2) * 255);
+  // getHal().writePwm(cvPin, powf((currentPitch + 1) / 2, 2) * 255);
+}
 
-  activeButtons.clear();
-    
-  // Add all held buttons to the list. 
-  // Or buttons that just stopped being held. 
-  for (Button *x: buttons) {
-    bool isHeldOrFalling = x != nullptr && (x->held() || x->fallingEdge());
+void publishSnapshot() {
+  // Only this core touches the copy, so there's no playhead to tear
+  captureSnapshot(snapshotBuffer.getWriteBuffer(), undoRedoManager, interactionManager, activeButtons);
+  snapshotBuffer.publish();
+}
 
-    if (isHeldOrFalling) { 
-      activeButtons.push_back(x);
-    }
+// Edits are made to a copy of the playing sequence, then swapped in here, so
+// the alarm's only held off for the copy rather than for the whole edit.
+// Pulses played in the meantime are played on the copy too, so the playhead doesn't jump back
+void publishEdits() {
+  clockEngine.lock();
+  sequence->catchUpWith(playingSequence);
+  playingSequence = *sequence;
+  playingSequence.updateOutputs(getHal().getMicros());
+  clockEngine.unlock();
+}
+
+// Picks up the transport and tempo changes the clock input made to the playing sequence
+void followPlayingSequence() {
+  clockEngine.lock();
+  *sequence = playingSequence;
+  clockEngine.unlock();
+}
+
+// Hands the buttons whatever edges the scanner's debounced since last time.
+// A button only takes one edge a tick, so a press and release that land
+// together are still seen as both. Returns when the first edge happened, 0 if there weren't any
+uint64_t updateButtons() {
+  activeButtons.beginTick();
+
+  uint64_t firstEdgeMicros = 0;
+  uint16_t changedChannels = 0;
+  const ButtonEdge *edge;
+  while ((edge = buttonScanner.peekEdge()) != nullptr && !(changedChannels & (1 << edge->channel))) {
+    if (changedChannels == 0) firstEdgeMicros = edge->micros;
+    changedChannels |= 1 << edge->channel;
+    activeButtons.setPressed(edge->channel, edge->isPressed, edge->micros / 1000);
+    buttonScanner.dropEdge();
   }
 
-  // Sort them by timestamp
-  std::sort(activeButtons.begin(), activeButtons.end(), 
-    [](Button *a, Button *b) { 
-      return a->getLastActivation() < b->getLastActivation(); 
-    }
-  );
+  activeButtons.endTick(getHal().getMillis());
+  return firstEdgeMicros;
 }
 
 float lastBpmPotState = 0;
 int32_t lastUpdateBpmMillis = 0;
 
 void processInput() {
+  processPotRequest();
   endlessPot.update();
-  updateButtons();
+  uint64_t buttonEdgeMicros = updateButtons();
+
+  // Buttons win if both changed, their edge came first
+  inputTraceId = 0;
+  if (buttonEdgeMicros != 0) {
+    inputTraceId = getLatencyTracer().begin(LATENCY_BUTTON, buttonEdgeMicros);
+  } else if (fabsf(endlessPot.getAngleDelta()) >= KNOB_TRACE_DEGREES) {
+    inputTraceId = getLatencyTracer().begin(LATENCY_KNOB, getHal().getMicros());
+  }
 
   UserInputState userInputState = UserInputState(&endlessPot, activeButtons);
 
   // Limit jittering by slowing the rate we update the BPM
-  if (millis() - lastUpdateBpmMillis > 0) {
-    lastUpdateBpmMillis = millis();
+  if (getHal().getMillis() - lastUpdateBpmMillis > 0) {
+    lastUpdateBpmMillis = getHal().getMillis();
 
-    int newBpmPotState = lerp(lastBpmPotState, analogRead(A2), 0.1);
+    int newBpmPotState = lerp(lastBpmPotState, getHal().readAnalog(A2), 0.1);
     lastBpmPotState = newBpmPotState;
 
-    auto newBpm = (newBpmPotState / 1024.f) * 100 + 60;
-    if (abs(sequence->getBpm() - newBpm) > 2) {
+    auto newBpm = (newBpmPotState / 65536.f) * 100 + 60;
+    // The pot is ignored while following an external clock
+    if (!clockInput.isFollowing() && abs(sequence->getBpm() - newBpm) > 2) {
       sequence->setBpm(newBpm);
     }
   }
   
   interactionManager.processInput(undoRedoManager, userInputState);
+  getLatencyTracer().record(LATENCY_EDIT, inputTraceId, getHal().getMicros());
 }
 
+// Saving writes flash, which stalls both cores, so it's only ever done when asked
+void processPotRequest() {
+  if (potRequest == POT_REQUEST_CALIBRATE) {
+    endlessPot.beginCalibration();
+    potRequest = POT_REQUEST_NONE;
+  } else if (potRequest == POT_REQUEST_SAVE) {
+    if (endlessPot.endCalibration()) {
+      calibrationStore.savePot(endlessPot.getCalibration());
+      potRequest = POT_REQUEST_SAVED;
+    } else {
+      potRequest = POT_REQUEST_REJECTED;
+    }
+  }
+}
+
+void printPotCalibration() {
+  const PotCalibration &calibration = endlessPot.getCalibration();
+  char line[80];
+  snprintf(line, sizeof(line), "pot A %u-%u B %u-%u, %.1f deg/s",
+    calibration.trackMin[0], calibration.trackMax[0], calibration.trackMin[1], calibration.trackMax[1],
+    endlessPot.getVelocity());
+  Serial.println(line);
+}
+
+char serialLine[32];
+size_t serialLineLength = 0;
+
+// Lines sent over USB serial. "perf" prints the timing counters, glyph cache hits, how well the
+// external clock's being followed and how late MIDI goes out, "perf reset" clears them.
+// "latency" and "latency reset" do the same for input latency.
+// "pot calibrate" starts finding the endless pot's reach, "pot save" keeps it, "pot" shows it
+void processSerialCommands() {
+  if (potRequest == POT_REQUEST_SAVED) {
+    Serial.println("pot calibration saved");
+    printPotCalibration();
+    potRequest = POT_REQUEST_NONE;
+  } else if (potRequest == POT_REQUEST_REJECTED) {
+    Serial.println("pot calibration not saved, turn it all the way round a few times after pot calibrate");
+    potRequest = POT_REQUEST_NONE;
+  }
+
+  while (Serial.available()) {
+    char c = Serial.read();
+
+    if (c != '\n' && c != '\r') {
+      if (serialLineLength < sizeof(serialLine) - 1) serialLine[serialLineLength++] = c;
+      continue;
+    }
+
+    serialLine[serialLineLength] = '\0';
+    serialLineLength = 0;
+
+    if (strcmp(serialLine, "perf") == 0) {
+      char row[80];
+      Serial.println(PerfStats::getTableHeader());
+
+      for (uint8_t counter = 0; counter < PERF_COUNTER_COUNT; counter++) {
+        getPerfStats().formatTableRow((PerfCounter)counter, row, sizeof(row));
+        Serial.println(row);
+      }
+
+      Serial.println(GlyphCache::getStatsHeader());
+      for (uint8_t cache = 0; formatGlyphCacheStats(cache, row, sizeof(row)); cache++) {
+        Serial.println(row);
+      }
+
+      Serial.println(TempoTracker::getStatsHeader());
+      clockInput.getTempoTracker().formatStats(ClockInput::getName(clockInput.getSource()), row, sizeof(row));
+      Serial.println(row);
+
+      Serial.println(MidiOutput::getStatsHeader());
+      midiOutput.formatStats(row, sizeof(row));
+      Serial.println(row);
+    } else if (strcmp(serialLine, "perf reset") == 0) {
+      getPerfStats().reset();
+      resetGlyphCacheStats();
+      clockInput.getTempoTracker().resetStats();
+      midiOutput.resetStats();
+      Serial.println("perf counters reset");
+    } else if (strcmp(serialLine, "latency") == 0) {
+      char row[80];
+      Serial.println(LatencyTracer::getTableHeader());
+
+      for (uint8_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        for (uint8_t source = 0; source < LATENCY_SOURCE_COUNT; source++) {
+          if (getLatencyTracer().formatTableRow((LatencyStage)stage, (LatencySource)source, row, sizeof(row))) {
+            Serial.println(row);
+          }
+        }
+      }
+    } else if (strcmp(serialLine, "latency reset") == 0) {
+      getLatencyTracer().reset();
+      Serial.println("latency samples cleared");
+    } else if (strcmp(serialLine, "pot") == 0) {
+      printPotCalibration();
+    } else if (strcmp(serialLine, "pot calibrate") == 0) {
+      potRequest = POT_REQUEST_CALIBRATE;
+      Serial.println("turn the endless pot round a few times, then pot save");
+    } else if (strcmp(serialLine, "pot save") == 0) {
+      potRequest = POT_REQUEST_SAVE;
+    }
+  }
+}
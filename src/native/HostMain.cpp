@@ -0,0 +1,618 @@
+// Runs the sequencer engine on the host against MockHal, with a scripted
+// user pressing buttons and turning the knob, and reports how long each
+// part of the sequencer loop takes and how much memory it uses.
+//
+// Usage: program [virtual seconds] [random seed]
+//        program render <golden image dir> [update]
+//
+// The render mode draws a scripted session and checks it against the golden
+// images, or records them with update. See RenderCheck.cpp. The golden images
+// are kept in test/test_render_golden/golden, which that test checks against
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <new>
+#include <algorithm>
+#include "MockHal.hpp"
+#include "../Sequence.h"
+#include "../UndoRedoManager.hpp"
+#include "../DeltaHistory.hpp"
+#include "../InteractionManager.hpp"
+#include "../ClockEngine.hpp"
+#include "../LookaheadScheduler.hpp"
+#include "../MidiOutput.hpp"
+#include "../SequenceSnapshot.hpp"
+#include "../TripleBuffer.hpp"
+#include "../DirtyTiles.hpp"
+#include "../RoundScreen.hpp"
+#include "../Vec2.h"
+#include "../FrameScheduler.hpp"
+#include "../PerfStats.hpp"
+#include "RenderCheck.hpp"
+#include "../Render.hpp"
+#include "../ActiveButtons.hpp"
+#include "../AdcSampler.hpp"
+#include "PotTrace.hpp"
+#include "../CalibrationStore.hpp"
+#include "../LatencyTracer.hpp"
+
+MockHal mockHal;
+IHal &getHal() { return mockHal; }
+
+const uint8_t gate1Pin = 14;
+const uint64_t LOOP_MICROS = 1000; // How often the sequencer loop runs in virtual time
+
+UndoRedoManager undoRedoManager;
+InteractionManager interactionManager;
+ClockEngine clockEngine;
+LookaheadScheduler scheduler;
+MidiOutput midiOutput;
+TripleBuffer<SequenceSnapshot> snapshotBuffer;
+StageDrawInfo stageDrawInfoById[MAX_STAGES];
+SineCosinePot endlessPot = SineCosinePot(0, 1);
+
+const Command userCommands[] = {PITCH, PULSES, GATEMODE, SELECT, MOVE, UNDO, REDO, ARP, CLONE, DELETE, QUANTIZER};
+std::vector<Button> buttons;
+ActiveButtons activeButtons;
+
+uint32_t gateEventCount = 0;
+uint16_t gateTraceId = 0; // As in main.cpp
+
+// Every heap allocation, so the loop can be checked for them
+uint32_t allocationCount = 0;
+
+void *operator new(size_t size) {
+  allocationCount++;
+  void *pointer = malloc(size);
+  if (pointer == nullptr) throw std::bad_alloc();
+  return pointer;
+}
+
+void operator delete(void *pointer) noexcept { free(pointer); }
+void operator delete(void *pointer, size_t) noexcept { free(pointer); }
+
+// Wall clock time spent in one part of the loop
+struct Timing {
+  const char *name;
+  double totalMicros = 0;
+  double maxMicros = 0;
+
+  void add(std::chrono::steady_clock::duration duration) {
+    double micros = std::chrono::duration<double, std::micro>(duration).count();
+    totalMicros += micros;
+    maxMicros = std::max(maxMicros, micros);
+  }
+};
+
+void onSequenceEvent(const SequenceEvent &event) {
+  if (event.type == EVENT_GATE_ON || event.type == EVENT_GATE_OFF) {
+    getHal().writePin(gate1Pin, event.type == EVENT_GATE_ON);
+    getLatencyTracer().record(LATENCY_GATE, gateTraceId, mockHal.getMicros());
+    gateEventCount++;
+  }
+
+  if (event.type == EVENT_GATE_ON) midiOutput.sendNoteOn(event.midiNote, 127, 1, event.micros, gateTraceId);
+  if (event.type == EVENT_GATE_OFF) midiOutput.sendNoteOff(0, 1, event.micros, gateTraceId);
+  if (event.type == EVENT_CLOCK) midiOutput.sendRealTime(MIDI_CLOCK, event.micros);
+  if (event.type == EVENT_GATE_ON || event.type == EVENT_GATE_OFF) gateTraceId = 0;
+}
+
+// Stands in for the alarm interrupt, handling everything due up to untilMicros at exactly the right time
+void runClockUntil(uint64_t untilMicros) {
+  Sequence *sequence = undoRedoManager.getSequence();
+
+  while (true) {
+    uint64_t dueMicros = min(sequence->getNextPulseMicros(), scheduler.getNextEventMicros());
+    if (dueMicros > untilMicros) break;
+
+    mockHal.setMicros(dueMicros);
+    clockEngine.poll(mockHal.getMicros());
+  }
+
+  mockHal.setMicros(untilMicros);
+}
+
+// The knob is a pair of pots 90 degrees apart, so turning it moves them along a sine and cosine
+void turnKnob(float angle) {
+  mockHal.setAnalog(26, 32768 + 32000 * sinf(angle));
+  mockHal.setAnalog(27, 32768 + 32000 * cosf(angle));
+}
+
+// Pixels cleared and sent to the display for a frame where everything changed,
+// as a plain square, in whole tiles, and trimmed to the round panel's spans
+void printDisplayPixels() {
+  const int16_t size = DirtyTiles::SCREEN_SIZE;
+  const int16_t pushChunkRows = 8; // As in Render.cpp
+
+  DirtyTiles allTiles;
+  allTiles.markAll();
+
+  uint32_t pushedPixels = 0;
+  uint32_t pushWindows = 0;
+  for (int16_t y = 0; y < size; y += pushChunkRows) {
+    ScreenSpan columns = RoundScreen::getVisibleColumns({0, y, size, pushChunkRows});
+    pushedPixels += columns.length() * pushChunkRows;
+    pushWindows += !columns.isEmpty();
+  }
+
+  printf("\n%-20s %8s %8s\n", "full frame", "cleared", "pushed");
+  printf("%-20s %8u %8u\n", "square", size * size, size * size);
+  printf("%-20s %8u %8u\n", "visible tiles", allTiles.getTileCount() * DirtyTiles::TILE_SIZE * DirtyTiles::TILE_SIZE, allTiles.getTileCount() * DirtyTiles::TILE_SIZE * DirtyTiles::TILE_SIZE);
+  printf("%-20s %8u %8u (%u DMA windows)\n", "visible spans", RoundScreen::countVisiblePixels({0, 0, size, size}), pushedPixels, pushWindows);
+
+  // Two 8 bit strips of a row of tiles and the RGB565 DMA staging buffer, against the two full frames there used to be
+  uint32_t stripBytes = 2 * size * DirtyTiles::TILE_SIZE + size * pushChunkRows * 2;
+  printf("%-20s %8u bytes (was %u)\n", "framebuffers", stripBytes, 2 * size * size * 2);
+  printf("%-20s %8zu bytes\n", "glyph caches", getGlyphCacheBytes());
+  printf("%-20s %8zu bytes\n", "display total", stripBytes + getGlyphCacheBytes());
+}
+
+// The float angle code Angle replaced, kept to compare against
+Vec2 floatFromPolar(float radius, float degrees) {
+  float tau = (degrees - 90) * 3.14159265f * 2 / 360.f;
+  return Vec2(radius * cosf(tau), radius * sinf(tau));
+}
+
+float floatWrap(float x, float min, float max) {
+  if (max == min) return min;
+  if (min > max) return floatWrap(x, max, min);
+  if (min < 0) return floatWrap(x - min, min - min, max - min) + min;
+
+  return (x >= 0 ? min : max) + fmodf(x, max - min);
+}
+
+float floatDegBetweenAngles(float a, float b) {
+  float angA = floatWrap(b - a, -360, 360);
+  float angB = floatWrap(360 + b - a, -360, 360);
+
+  return (fabsf(angA) < fabsf(angB)) ? angA : angB;
+}
+
+// Times fn over count calls, in nanoseconds per call
+template <typename Fn>
+double nanosPerCall(uint32_t count, Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < count; i++) fn(i);
+
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+}
+
+void printAngleBenchmarks() {
+  const uint32_t count = 1000000;
+  volatile float floatSink = 0;
+  volatile int32_t intSink = 0;
+
+  // Angles that don't repeat too often, in degrees and as Angles
+  auto degrees = [](uint32_t i) { return (i * 7919 % 36000) * 0.01f; };
+  auto angle = [](uint32_t i) { return Angle::fromBam(i * 40503); };
+
+  printf("\n%-28s %10s\n", "angle code", "ns/call");
+  printf("%-28s %10.2f\n", "fromPolar float", nanosPerCall(count, [&](uint32_t i) { floatSink = floatFromPolar(100, degrees(i)).x; }));
+  printf("%-28s %10.2f\n", "fromPolar Angle", nanosPerCall(count, [&](uint32_t i) { floatSink = Vec2::fromPolar(100.f, angle(i)).x; }));
+  printf("%-28s %10.2f\n", "fromPolar Vec2Fx", nanosPerCall(count, [&](uint32_t i) { intSink = Vec2Fx::fromPolar(100, angle(i)).x; }));
+  printf("%-28s %10.2f\n", "degBetweenAngles float", nanosPerCall(count, [&](uint32_t i) { floatSink = floatDegBetweenAngles(degrees(i), degrees(i + 1)); }));
+  printf("%-28s %10.2f\n", "Angle::deltaTo", nanosPerCall(count, [&](uint32_t i) { intSink = angle(i).deltaTo(angle(i + 1)); }));
+  printf("%-28s %10.2f\n", "atan2f", nanosPerCall(count, [&](uint32_t i) { floatSink = atan2f((int16_t)(i * 40503), (int16_t)(i * 7919)); }));
+  printf("%-28s %10.2f\n", "Angle::atan2", nanosPerCall(count, [&](uint32_t i) { intSink = Angle::atan2((int16_t)(i * 40503), (int16_t)(i * 7919)).getBam(); }));
+
+  // How far the table is from the real thing, at a radius as big as the screen's
+  float maxError = 0;
+  for (uint32_t bam = 0; bam < 0x10000; bam++) {
+    Vec2 exact = floatFromPolar(120, bam * 360.f / 65536);
+    Vec2 fromTable = Vec2::fromPolar(120.f, Angle::fromBam(bam));
+    maxError = std::max(maxError, (exact - fromTable).length());
+  }
+  printf("Angle fromPolar max error at radius 120: %.4f px\n", maxError);
+
+  // And atan2 from all the way round, at the size the pot gives it
+  int32_t maxAtan2Error = 0;
+  for (uint32_t bam = 0; bam < 0x10000; bam++) {
+    Angle exact = Angle::fromBam(bam);
+    Angle fromCordic = Angle::atan2(exact.sin() * 1e9f, exact.cos() * 1e9f);
+    maxAtan2Error = std::max(maxAtan2Error, abs(exact.deltaTo(fromCordic)));
+  }
+  printf("Angle::atan2 max error: %d BAM\n", maxAtan2Error);
+}
+
+// The endless pot decoder before CORDIC, for comparison. It took each track as
+// linear over half a turn, and blended the two away from their ends
+float floatPotDegrees(uint16_t adcA, uint16_t adcB) {
+  float halfAngleFromAdcA = adcA * (180.f / 65536);
+  float halfAngleFromAdcB = adcB * (180.f / 65536);
+
+  Angle angleFromAdcA = Angle::fromDegrees(360 - ((halfAngleFromAdcB <= 90) ? halfAngleFromAdcA : 360 - halfAngleFromAdcA) + 90);
+  Angle angleFromAdcB = Angle::fromDegrees((halfAngleFromAdcA <= 90) ? halfAngleFromAdcB : 360 - halfAngleFromAdcB);
+
+  float a = 1 - fabsf(halfAngleFromAdcA - 90) / 90.f;
+  float b = 1 - fabsf(halfAngleFromAdcB - 90) / 90.f;
+  int16_t bToA = angleFromAdcB.deltaTo(angleFromAdcA);
+  return (angleFromAdcB + Angle::fromBam(lroundf(bToA * (a / (float)(a + b))))).toDegrees();
+}
+
+// Replays a recorded trace through the endless pot decoders, printing what
+// each costs and how far from the knob it thinks it is
+void printPotBenchmarks(std::mt19937 &rng) {
+  const uint32_t calibrationReadings = 1000; // 4 seconds, more than a turn each way
+  std::vector<PotTraceReading> trace = recordPotTrace(rng, 20);
+
+  // The angles are relative to wherever the decoder calls zero, so its mean offset's taken off.
+  // It's averaged around the first one, so it doesn't matter if they straddle a half turn
+  auto printErrors = [&](const char *name, double nanos, const std::vector<float> &decoded, const std::vector<float> &velocities) {
+    float firstOffset = floatDegBetweenAngles(trace[calibrationReadings].degrees, decoded[calibrationReadings]);
+    double totalOffset = 0;
+    for (uint32_t i = calibrationReadings; i < trace.size(); i++) {
+      totalOffset += floatDegBetweenAngles(trace[i].degrees + firstOffset, decoded[i]);
+    }
+    float offset = firstOffset + totalOffset / (trace.size() - calibrationReadings);
+
+    float maxError = 0;
+    double totalVelocityError = 0;
+    for (uint32_t i = calibrationReadings; i < trace.size(); i++) {
+      maxError = std::max(maxError, fabsf(floatDegBetweenAngles(trace[i].degrees + offset, decoded[i])));
+      if (!velocities.empty()) totalVelocityError += fabsf(velocities[i] - trace[i].degreesPerSecond);
+    }
+
+    printf("%-28s %10.2f %10.3f", name, nanos, maxError);
+    if (!velocities.empty()) printf(" %10.1f", totalVelocityError / (trace.size() - calibrationReadings));
+    printf("\n");
+  };
+
+  auto replay = [&](SineCosinePot &pot, std::vector<float> &decoded, std::vector<float> &velocities) {
+    decoded.clear();
+    velocities.clear();
+    auto start = std::chrono::steady_clock::now();
+
+    for (const PotTraceReading &reading : trace) {
+      mockHal.setAnalog(26, reading.adc[0]);
+      mockHal.setAnalog(27, reading.adc[1]);
+      mockHal.advanceMicros(POT_TRACE_READING_MICROS);
+      pot.update();
+
+      decoded.push_back(pot.getAngle().toDegrees());
+      velocities.push_back(pot.getVelocity());
+    }
+
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / trace.size();
+  };
+
+  printf("\n%-28s %10s %10s %10s\n", "endless pot decoder", "ns/call", "max err", "vel err");
+
+  std::vector<float> decoded;
+  std::vector<float> velocities;
+  auto start = std::chrono::steady_clock::now();
+  for (const PotTraceReading &reading : trace) {
+    decoded.push_back(floatPotDegrees(reading.adc[0], reading.adc[1]));
+  }
+  double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / trace.size();
+  printErrors("float linear tracks", nanos, decoded, {});
+
+  SineCosinePot uncalibrated = SineCosinePot(0, 1);
+  nanos = replay(uncalibrated, decoded, velocities);
+  printErrors("CORDIC uncalibrated", nanos, decoded, velocities);
+
+  // Calibrated on the start of the trace, and kept in the store like on the board
+  CalibrationStore store;
+  SineCosinePot calibrating = SineCosinePot(0, 1);
+  calibrating.beginCalibration();
+  for (uint32_t i = 0; i < calibrationReadings; i++) {
+    mockHal.setAnalog(26, trace[i].adc[0]);
+    mockHal.setAnalog(27, trace[i].adc[1]);
+    calibrating.update();
+  }
+  if (!calibrating.endCalibration()) {
+    printf("calibration rejected\n");
+    return;
+  }
+  store.savePot(calibrating.getCalibration());
+
+  PotCalibration calibration;
+  SineCosinePot calibrated = SineCosinePot(0, 1);
+  if (store.loadPot(calibration)) calibrated.setCalibration(calibration);
+  nanos = replay(calibrated, decoded, velocities);
+  printErrors("CORDIC calibrated", nanos, decoded, velocities);
+
+  printf("calibrated tracks A %u-%u B %u-%u\n", calibration.trackMin[0], calibration.trackMax[0], calibration.trackMin[1], calibration.trackMax[1]);
+}
+
+// Feeds the frame scheduler a burst of heavy frames between light ones, and
+// prints where it gives up and takes back quality
+// The undo history before DeltaHistory, for comparison. A ring of whole sequences
+struct SnapshotHistory {
+  static const uint8_t SIZE = 24;
+  Sequence history[SIZE];
+  uint8_t position = 0;
+  uint8_t oldest = 0;
+  uint8_t newest = 0;
+
+  void save(Sequence &sequence) {
+    position = (position + 1) % SIZE;
+    history[position] = sequence;
+    newest = position;
+    if (newest == oldest) oldest = (oldest + 1) % SIZE;
+  }
+
+  bool undo(Sequence &sequence) {
+    if (position == oldest) return false;
+    position = (position + SIZE - 1) % SIZE;
+    sequence = history[position];
+    return true;
+  }
+
+  bool redo(Sequence &sequence) {
+    if (position == newest) return false;
+    position = (position + 1) % SIZE;
+    sequence = history[position];
+    return true;
+  }
+};
+
+// Makes the same run of random edits with each undo history, then undoes as
+// far back as it can go and redoes it all, printing what each costs
+void printUndoBenchmarks(std::mt19937 &rng) {
+  const uint32_t editCount = 2000;
+  std::mt19937 editRng = rng;
+
+  auto edit = [](std::mt19937 &rng, Sequence &sequence) {
+    Stage &stage = sequence.getStage(rng() % sequence.stageCount());
+    switch (rng() % 6) {
+      case 0: stage.setOutput((rng() % 200) / 100.f - 1); break;
+      case 1: stage.pulseCount = 1 + rng() % 8; break;
+      case 2: stage.gateMode = (GateMode)(rng() % 4); break;
+      case 3: sequence.moveStages(1 << (rng() % sequence.stageCount()), (rng() % 2) ? 1 : -1); break;
+      case 4: sequence.cloneStage(rng() % sequence.stageCount()); break;
+      case 5: sequence.deleteStage(rng() % sequence.stageCount()); break;
+    }
+  };
+
+  auto nanosSince = [](std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  // Run the edits, then go all the way back and forwards again
+  auto run = [&](const char *name, size_t bytes, auto commit, auto undo, auto redo) {
+    std::mt19937 rng = editRng;
+    Sequence sequence = Sequence(8);
+    commit(sequence);
+
+    double commitNanos = 0;
+    for (uint32_t i = 0; i < editCount; i++) {
+      edit(rng, sequence);
+      auto start = std::chrono::steady_clock::now();
+      commit(sequence);
+      commitNanos += nanosSince(start);
+    }
+
+    uint32_t undoSteps = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (undo(sequence)) undoSteps++;
+    double undoNanos = nanosSince(start);
+
+    start = std::chrono::steady_clock::now();
+    while (redo(sequence)) {}
+    double redoNanos = nanosSince(start);
+
+    printf("%-20s %8zu %8u %10.1f %10.1f %10.1f\n", name, bytes, undoSteps,
+      commitNanos / editCount, undoNanos / max(1u, undoSteps), redoNanos / max(1u, undoSteps));
+  };
+
+  printf("\n%-20s %8s %8s %10s %10s %10s\n", "undo history", "bytes", "steps", "commit ns", "undo ns", "redo ns");
+
+  static SnapshotHistory snapshots;
+  run("full snapshots", sizeof(snapshots),
+    [&](Sequence &sequence) { snapshots.save(sequence); },
+    [&](Sequence &sequence) { return snapshots.undo(sequence); },
+    [&](Sequence &sequence) { return snapshots.redo(sequence); });
+
+  static DeltaHistory deltas;
+  bool isReset = false;
+  run("delta ring", sizeof(deltas),
+    [&](Sequence &sequence) {
+      if (!isReset) deltas.reset(sequence);
+      else deltas.commit(sequence);
+      isReset = true;
+    },
+    [&](Sequence &sequence) { return deltas.undo(sequence); },
+    [&](Sequence &sequence) { return deltas.redo(sequence); });
+}
+
+void printFrameSchedulerSim() {
+  FrameScheduler frames = FrameScheduler(16667);
+  const struct { uint32_t frameCount, frameMicros; } loads[] = {{100, 6000}, {20, 24000}, {100, 14000}, {600, 5000}};
+
+  printf("\n%-8s %-10s %s\n", "frame", "cost us", "quality");
+  uint64_t nowMicros = 0;
+  uint32_t frameIndex = 0;
+  RenderQuality lastQuality = frames.getQuality();
+
+  for (auto load : loads) {
+    for (uint32_t i = 0; i < load.frameCount; i++, frameIndex++) {
+      // Frames that run over start late, the rest wait their turn
+      while (!frames.isFrameDue(nowMicros)) nowMicros += 100;
+
+      frames.beginFrame(nowMicros);
+      nowMicros += load.frameMicros;
+      frames.endPhase(PHASE_DRAW, nowMicros);
+      frames.endFrame(nowMicros);
+
+      if (frames.getQuality() != lastQuality) {
+        printf("%-8u %-10u %d\n", frameIndex, load.frameMicros, frames.getQuality());
+        lastQuality = frames.getQuality();
+      }
+    }
+  }
+
+  printf("%u overruns in %u frames\n", frames.getOverrunCount(), frames.getFrameCount());
+}
+
+// A button for each user command and the clock running, ready for the loop.
+// The render golden test starts the same way
+void beginHost() {
+  for (Command command : userCommands) {
+    buttons.push_back(Button(command));
+  }
+  for (uint8_t i = 0; i < buttons.size(); i++) {
+    activeButtons.setButton(i, &buttons[i]);
+  }
+
+  clockEngine.setScheduler(&scheduler, onSequenceEvent);
+  clockEngine.begin(undoRedoManager.getSequence(), mockHal.getMicros());
+}
+
+// The tests bring their own main, and use the globals above
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char **argv) {
+  bool isRenderCheck = argc > 2 && strcmp(argv[1], "render") == 0;
+  uint32_t seconds = argc > 1 ? atoi(argv[1]) : 60;
+  uint32_t seed = argc > 2 ? atoi(argv[2]) : 1;
+  std::mt19937 rng(seed);
+  srand(seed);
+
+  beginHost();
+  Sequence *sequence = undoRedoManager.getSequence();
+
+  if (isRenderCheck) {
+    return runRenderCheck(argv[2], argc > 3 && strcmp(argv[3], "update") == 0);
+  }
+
+  Timing inputTiming = {"input + edits"};
+  Timing planTiming = {"plan"};
+  Timing clockTiming = {"pulses + events"};
+  Timing snapshotTiming = {"snapshot"};
+  Timing midiTiming = {"midi flush"};
+
+  Button *heldButton = nullptr;
+  uint64_t releaseMicros = 0;
+  float knobAngle = 0;
+  float knobSpeed = 0;
+  uint32_t loopCount = 0;
+  uint32_t inputAllocationCount = 0;
+  uint32_t lastReplanCount = 0;
+
+  auto startTime = std::chrono::steady_clock::now();
+
+  for (uint64_t loopMicros = 0; loopMicros < seconds * 1000000ull; loopMicros += LOOP_MICROS) {
+    auto partStart = std::chrono::steady_clock::now();
+    auto endPart = [&partStart](Timing &timing) {
+      auto now = std::chrono::steady_clock::now();
+      timing.add(now - partStart);
+      partStart = now;
+    };
+
+    runClockUntil(loopMicros);
+    endPart(clockTiming);
+
+    // Every so often hold a random button for a moment while turning the knob
+    if (heldButton == nullptr && rng() % 400 == 0) {
+      heldButton = &buttons[rng() % buttons.size()];
+      releaseMicros = loopMicros + 100000 + rng() % 400000;
+      knobSpeed = ((rng() % 200) - 100) / 5000.f;
+    } else if (heldButton != nullptr && loopMicros >= releaseMicros) {
+      heldButton = nullptr;
+      knobSpeed = 0;
+    }
+
+    knobAngle += knobSpeed;
+    turnKnob(knobAngle);
+    endlessPot.update();
+
+    uint32_t allocationsBefore = allocationCount;
+
+    activeButtons.beginTick();
+    for (uint8_t i = 0; i < buttons.size(); i++) {
+      activeButtons.update(i, &buttons[i] == heldButton);
+    }
+    activeButtons.endTick(mockHal.getMillis());
+
+    uint16_t inputTraceId = 0;
+    if (activeButtons.getRising() != 0 || activeButtons.getFalling() != 0) {
+      inputTraceId = getLatencyTracer().begin(LATENCY_BUTTON, mockHal.getMicros());
+    } else if (fabsf(endlessPot.getAngleDelta()) >= 0.5f) {
+      inputTraceId = getLatencyTracer().begin(LATENCY_KNOB, mockHal.getMicros());
+    }
+
+    UserInputState userInputState = UserInputState(&endlessPot, activeButtons);
+
+    {
+      PerfScope scope(PERF_INPUT);
+      interactionManager.processInput(undoRedoManager, userInputState);
+    }
+    getLatencyTracer().record(LATENCY_EDIT, inputTraceId, mockHal.getMicros());
+    inputAllocationCount += allocationCount - allocationsBefore;
+    endPart(inputTiming);
+
+    {
+      PerfScope scope(PERF_SEQUENCE);
+      sequence->updateOutputs(mockHal.getMicros());
+      scheduler.plan(*sequence, mockHal.getMicros());
+    }
+    if (scheduler.getReplanCount() != lastReplanCount) {
+      lastReplanCount = scheduler.getReplanCount();
+      if (inputTraceId != 0) gateTraceId = inputTraceId;
+    }
+    endPart(planTiming);
+
+    captureSnapshot(snapshotBuffer.getWriteBuffer(), undoRedoManager, interactionManager, activeButtons);
+    snapshotBuffer.publish();
+    endPart(snapshotTiming);
+
+    midiOutput.flush(mockHal.getMicros());
+    mockHal.getMidiPackets().clear();
+    endPart(midiTiming);
+
+    loopCount++;
+  }
+
+  double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+  printf("%u virtual seconds in %.3f s of wall time (%.0fx real time), %u loops\n", seconds, wallSeconds, seconds / wallSeconds, loopCount);
+  printf("%u pulses, %u gate events, %u replans (%u events dropped), %u undo steps\n", sequence->getPulseIndex(), gateEventCount,
+    scheduler.getReplanCount(), scheduler.getDroppedCount(), undoRedoManager.getUndoStepCount());
+  printf("%u heap allocations handling input\n", inputAllocationCount);
+  printf("\n%-16s %10s %10s\n", "loop part", "mean us", "max us");
+  for (Timing *timing : {&inputTiming, &planTiming, &clockTiming, &snapshotTiming, &midiTiming}) {
+    printf("%-16s %10.3f %10.3f\n", timing->name, timing->totalMicros / loopCount, timing->maxMicros);
+  }
+
+  // The same table the firmware prints over serial, the render counters stay empty here
+  char perfRow[80];
+  printf("\n%s\n", PerfStats::getTableHeader());
+  for (PerfCounter counter : {PERF_INPUT, PERF_SEQUENCE}) {
+    getPerfStats().formatTableRow(counter, perfRow, sizeof(perfRow));
+    printf("%s\n", perfRow);
+  }
+
+  printf("\n%s\n", MidiOutput::getStatsHeader());
+  midiOutput.formatStats(perfRow, sizeof(perfRow));
+  printf("%s\n", perfRow);
+  printf("Pulse lateness: mean %.1f us max %u us\n", clockEngine.getMeanLatenessMicros(), clockEngine.getMaxLatenessMicros());
+
+  // In virtual time, and there's no screen here, so it's mostly the wait for the next gate
+  char latencyRow[80];
+  printf("\n%s\n", LatencyTracer::getTableHeader());
+  for (uint8_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+    for (uint8_t source = 0; source < LATENCY_SOURCE_COUNT; source++) {
+      if (getLatencyTracer().formatTableRow((LatencyStage)stage, (LatencySource)source, latencyRow, sizeof(latencyRow))) {
+        printf("%s\n", latencyRow);
+      }
+    }
+  }
+
+  printf("\n%-20s %8s\n", "object", "bytes");
+  printf("%-20s %8zu\n", "Sequence", sizeof(Sequence));
+  printf("%-20s %8zu\n", "UndoRedoManager", sizeof(UndoRedoManager));
+  printf("%-20s %8zu\n", "InteractionManager", sizeof(InteractionManager));
+  printf("%-20s %8zu\n", "LookaheadScheduler", sizeof(LookaheadScheduler));
+  printf("%-20s %8zu\n", "MidiOutput", sizeof(MidiOutput));
+  printf("%-20s %8zu\n", "SequenceSnapshot x3", sizeof(snapshotBuffer));
+
+  printDisplayPixels();
+  printAngleBenchmarks();
+  printPotBenchmarks(rng);
+  printUndoBenchmarks(rng);
+  printFrameSchedulerSim();
+
+  return 0;
+}
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <chrono>
+#include "../Hal.hpp"
+
+// Stands in for the board on the host. Time only moves when it's told to,
+// pins and analog inputs can be set from outside, and MIDI packets are
+// recorded instead of sent.
+class MockHal : public IHal {
+    public:
+        uint64_t getMicros() override { return _micros; }
+        void setMicros(uint64_t micros) { _micros = max(_micros, micros); }
+        void advanceMicros(uint64_t micros) { _micros += micros; }
+
+        // Timing code wants real time rather than virtual, so a cycle is a nanosecond of wall time
+        uint32_t getCycleCount() override {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+        uint32_t getCyclesPerMicro() override { return 1000; }
+
+        void setPinMode(uint pin, HalPinMode mode) override { _pinModes[pin % PIN_COUNT] = mode; }
+        HalPinMode getPinMode(uint pin) { return _pinModes[pin % PIN_COUNT]; }
+
+        bool readPin(uint pin) override { return _pins[pin % PIN_COUNT]; }
+        void writePin(uint pin, bool value) override { _pins[pin % PIN_COUNT] = value; }
+        void writePwm(uint pin, uint8_t value) override { _pwm[pin % PIN_COUNT] = value; }
+        uint8_t getPwm(uint pin) { return _pwm[pin % PIN_COUNT]; }
+
+        uint16_t readAnalog(uint pin) override { return _analog[pin % PIN_COUNT]; }
+        void setAnalog(uint pin, uint16_t value) { _analog[pin % PIN_COUNT] = value; }
+
+        bool isMidiConnected() override { return _isMidiConnected; }
+        void setMidiConnected(bool isConnected) { _isMidiConnected = isConnected; }
+
+        bool writeMidiPacket(const uint8_t packet[4]) override {
+            if (_midiPackets.size() >= MIDI_PACKET_LIMIT) return false;
+
+            _midiPackets.push_back({packet[0], packet[1], packet[2], packet[3]});
+            return true;
+        }
+
+        std::vector<std::array<uint8_t, 4>> &getMidiPackets() { return _midiPackets; }
+
+    private:
+        static const uint PIN_COUNT = 48;
+        // Stops the recording growing forever if nobody clears it
+        static const size_t MIDI_PACKET_LIMIT = 1 << 16;
+
+        uint64_t _micros = 0;
+        HalPinMode _pinModes[PIN_COUNT] = {};
+        bool _pins[PIN_COUNT] = {};
+        uint8_t _pwm[PIN_COUNT] = {};
+        uint16_t _analog[PIN_COUNT] = {};
+        bool _isMidiConnected = true;
+        std::vector<std::array<uint8_t, 4>> _midiPackets;
+};
@@ -0,0 +1,34 @@
+// A made up endless pot for the host, to replay through the decoders
+
+#include <math.h>
+#include "PotTrace.hpp"
+
+std::vector<PotTraceReading> recordPotTrace(std::mt19937 &rng, float seconds) {
+  const float sampleHz = AdcSampler::SAMPLE_HZ / AdcSampler::CHANNEL_COUNT;
+  const float centre[2] = {1950, 2150};
+  const float amplitude[2] = {1700, 1850};
+  const float periodSeconds = 5;
+  const float peakDegreesPerSecond = 400;
+  const float swingDegrees = peakDegreesPerSecond * periodSeconds / (2 * (float)M_PI);
+
+  auto degreesAt = [&](float t) { return swingDegrees * (1 - cosf(2 * (float)M_PI * t / periodSeconds)); };
+  auto speedAt = [&](float t) { return peakDegreesPerSecond * sinf(2 * (float)M_PI * t / periodSeconds); };
+
+  AdcSampler sampler;
+  std::vector<PotTraceReading> trace;
+  std::uniform_real_distribution<float> noise(-3, 3);
+
+  for (uint32_t i = 0; i < seconds * sampleHz; i++) {
+    float radians = degreesAt(i / sampleHz) * (float)M_PI / 180;
+    sampler.addSample(0, lroundf(centre[0] + amplitude[0] * sinf(radians) + noise(rng)));
+    sampler.addSample(1, lroundf(centre[1] + amplitude[1] * cosf(radians) + noise(rng)));
+
+    // The filter's output lags its input by a decimation's worth of samples
+    if ((i + 1) % AdcSampler::DECIMATION == 0) {
+      float t = (i + 1 - AdcSampler::DECIMATION) / sampleHz;
+      trace.push_back({{sampler.read(0), sampler.read(1)}, degreesAt(t), speedAt(t)});
+    }
+  }
+
+  return trace;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+#include <random>
+#include <vector>
+#include "../AdcSampler.hpp"
+
+// How far apart the filtered readings are
+const uint32_t POT_TRACE_READING_MICROS = 1000000 * AdcSampler::DECIMATION * AdcSampler::CHANNEL_COUNT / AdcSampler::SAMPLE_HZ;
+
+// A filtered reading of each of the endless pot's tracks, and where the knob was
+struct PotTraceReading {
+  uint16_t adc[2];
+  float degrees;
+  float degreesPerSecond;
+};
+
+// Records a pot that's a bit off, the way a real one is, being turned back and
+// forth. 12 bit samples with noise go through the same filter as on the board
+std::vector<PotTraceReading> recordPotTrace(std::mt19937 &rng, float seconds);
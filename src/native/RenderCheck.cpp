@@ -0,0 +1,242 @@
+// Renders a scripted session on the host, into TFT_eSPI's stand in, and
+// checks each scene's frame against a golden image. Golden images are
+// recorded from a build that's known to look right, then any later build
+// can be checked against them. Also reports what each scene costs to draw.
+
+#include <stdio.h>
+#include <string>
+#include "RenderCheck.hpp"
+#include "MockHal.hpp"
+#include "TFT_eSPI.h"
+#include "../Render.hpp"
+#include "../GlyphCache.hpp"
+#include "../UndoRedoManager.hpp"
+#include "../InteractionManager.hpp"
+#include "../ClockEngine.hpp"
+#include "../LookaheadScheduler.hpp"
+#include "../TripleBuffer.hpp"
+#include "../UserInputState.hpp"
+#include "../LatencyTracer.hpp"
+#include "../RoundScreen.hpp"
+
+// From HostMain.cpp and Render.cpp
+extern MockHal mockHal;
+extern UndoRedoManager undoRedoManager;
+extern InteractionManager interactionManager;
+extern ClockEngine clockEngine;
+extern LookaheadScheduler scheduler;
+extern TripleBuffer<SequenceSnapshot> snapshotBuffer;
+extern StageDrawInfo stageDrawInfoById[MAX_STAGES];
+extern SineCosinePot endlessPot;
+extern std::vector<Button> buttons;
+extern ActiveButtons activeButtons;
+extern TFT_eSPI tft;
+void runClockUntil(uint64_t untilMicros);
+void turnKnob(float angle);
+
+const int16_t FRAME_SIZE = 240;
+
+// A stretch of the session, ending with the frame that gets checked. Each
+// carries on from the one before
+struct RenderScene {
+  const char *name;
+  uint32_t millis;
+  Command heldCommand;
+  float knobSpeed; // Radians a millisecond
+};
+
+const RenderScene scenes[] = {
+  {"start", 1000, NOTHING, 0},
+  {"idle", 2000, NOTHING, 0},
+  {"cursor", 600, NOTHING, 0.004f},
+  {"pitch", 400, PITCH, 0.003f},
+  {"gate-mode", 400, GATEMODE, 0.004f},
+  {"pulses", 300, PULSES, 0.01f},
+  {"select", 100, SELECT, 0},
+  {"selected", 500, NOTHING, 0.003f},
+  {"clone", 100, CLONE, 0},
+  {"cloned", 800, NOTHING, 0},
+  {"move", 400, MOVE, 0.004f},
+  {"quantizer", 100, QUANTIZER, 0},
+  {"quantizer-config", 500, NOTHING, 0.002f},
+};
+
+float knobAngle = 0;
+
+// A millisecond of the sequencer loop, and as much of the display as is due
+void runMillisecond(Command heldCommand, float knobSpeed) {
+  Sequence *sequence = undoRedoManager.getSequence();
+  runClockUntil(mockHal.getMicros() + 1000);
+
+  knobAngle += knobSpeed;
+  turnKnob(knobAngle);
+  endlessPot.update();
+
+  activeButtons.beginTick();
+  for (uint8_t i = 0; i < buttons.size(); i++) {
+    activeButtons.update(i, buttons[i].getCommand() == heldCommand);
+  }
+  activeButtons.endTick(mockHal.getMillis());
+
+  // Traced like on the board, so the screen's latency in virtual time can be seen
+  uint16_t inputTraceId = 0;
+  if (activeButtons.getRising() != 0 || activeButtons.getFalling() != 0) {
+    inputTraceId = getLatencyTracer().begin(LATENCY_BUTTON, mockHal.getMicros());
+  } else if (fabsf(endlessPot.getAngleDelta()) >= 0.5f) {
+    inputTraceId = getLatencyTracer().begin(LATENCY_KNOB, mockHal.getMicros());
+  }
+
+  UserInputState userInputState = UserInputState(&endlessPot, activeButtons);
+  interactionManager.processInput(undoRedoManager, userInputState);
+  getLatencyTracer().record(LATENCY_EDIT, inputTraceId, mockHal.getMicros());
+  sequence->updateOutputs(mockHal.getMicros());
+  scheduler.plan(*sequence, mockHal.getMicros());
+
+  captureSnapshot(snapshotBuffer.getWriteBuffer(), undoRedoManager, interactionManager, activeButtons);
+  snapshotBuffer.publish();
+
+  // DMA is instant here, so a frame is drawn and sent all at once
+  for (int call = 0; call < 1000 && !isDisplayUpToDate(); call++) {
+    updateDisplay(snapshotBuffer.read(), stageDrawInfoById);
+  }
+}
+
+// Only what the round panel shows. The corners are never cleared, so
+// they're left black rather than whatever the strips last held there
+bool writePpm(const std::string &path) {
+  FILE *file = fopen(path.c_str(), "wb");
+  if (file == nullptr) return false;
+
+  fprintf(file, "P6\n%d %d\n255\n", FRAME_SIZE, FRAME_SIZE);
+  for (int16_t y = 0; y < FRAME_SIZE; y++) {
+    ScreenSpan span = RoundScreen::getSpan(y);
+    for (int16_t x = 0; x < FRAME_SIZE; x++) {
+      uint16_t colour = (x >= span.start && x < span.end) ? tft.readPixel(x, y) : 0;
+      uint8_t rgb[3] = {
+        (uint8_t)((colour >> 11) * 255 / 31),
+        (uint8_t)(((colour >> 5) & 0x3F) * 255 / 63),
+        (uint8_t)((colour & 0x1F) * 255 / 31)
+      };
+      fwrite(rgb, 1, 3, file);
+    }
+  }
+
+  fclose(file);
+  return true;
+}
+
+// How many pixels of the panel differ from the image at path, or -1 if it can't be read
+int32_t comparePpm(const std::string &path) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (file == nullptr) return -1;
+
+  int width, height, maxValue;
+  bool isValid = fscanf(file, "P6 %d %d %d", &width, &height, &maxValue) == 3
+    && width == FRAME_SIZE && height == FRAME_SIZE && maxValue == 255;
+  fgetc(file); // The single whitespace before the pixels
+
+  std::vector<uint8_t> golden(FRAME_SIZE * FRAME_SIZE * 3);
+  isValid = isValid && fread(golden.data(), 1, golden.size(), file) == golden.size();
+  fclose(file);
+  if (!isValid) return -1;
+
+  int32_t differentCount = 0;
+  for (int16_t y = 0; y < FRAME_SIZE; y++) {
+    ScreenSpan span = RoundScreen::getSpan(y);
+    for (int16_t x = span.start; x < span.end; x++) {
+      uint16_t colour = tft.readPixel(x, y);
+      const uint8_t *rgb = &golden[(y * FRAME_SIZE + x) * 3];
+
+      bool isSame = rgb[0] == (colour >> 11) * 255 / 31
+        && rgb[1] == ((colour >> 5) & 0x3F) * 255 / 63
+        && rgb[2] == (colour & 0x1F) * 255 / 31;
+      differentCount += !isSame;
+    }
+  }
+
+  return differentCount;
+}
+
+int runRenderCheck(const char *goldenDir, bool isRecording) {
+  initScreen();
+
+  const size_t sceneCount = sizeof(scenes) / sizeof(scenes[0]);
+  CanvasStats sceneStats[sceneCount];
+  uint32_t sceneFrames[sceneCount];
+  FrameScheduler &frameScheduler = getFrameScheduler();
+  int failCount = 0;
+
+  printf("%-18s %6s %8s  %s\n", "scene", "frames", "skipped", "result");
+
+  for (size_t i = 0; i < sceneCount; i++) {
+    const RenderScene &scene = scenes[i];
+    uint32_t startFrameCount = frameScheduler.getFrameCount();
+    uint32_t startSkippedCount = frameScheduler.getSkippedCount();
+    getCanvasStats().reset();
+
+    for (uint32_t millis = 0; millis < scene.millis; millis++) {
+      runMillisecond(scene.heldCommand, scene.knobSpeed);
+    }
+
+    sceneStats[i] = getCanvasStats();
+    sceneFrames[i] = max(1u, frameScheduler.getFrameCount() - startFrameCount);
+
+    std::string goldenPath = std::string(goldenDir) + "/" + scene.name + ".ppm";
+    std::string result;
+
+    if (isRecording) {
+      result = writePpm(goldenPath) ? "recorded" : "couldn't write " + goldenPath;
+      failCount += result != "recorded";
+    } else {
+      int32_t differentCount = comparePpm(goldenPath);
+
+      if (differentCount == 0) {
+        result = "ok";
+      } else {
+        // Kept next to the golden one to look at
+        std::string actualPath = std::string(goldenDir) + "/" + scene.name + ".actual.ppm";
+        writePpm(actualPath);
+        result = (differentCount < 0) ? "no golden image" : std::to_string(differentCount) + " pixels differ, see " + actualPath;
+        failCount++;
+      }
+    }
+
+    printf("%-18s %6u %8u  %s\n", scene.name, sceneFrames[i], frameScheduler.getSkippedCount() - startSkippedCount, result.c_str());
+  }
+
+  // What each scene cost a frame, by the kind of thing drawn
+  for (bool isTime : {false, true}) {
+    printf("\n%-18s", isTime ? "us per frame" : "pixels per frame");
+    for (uint8_t primitive = 0; primitive < PRIMITIVE_COUNT; primitive++) {
+      printf(" %9s", CanvasStats::getName((CanvasPrimitive)primitive));
+    }
+    printf("\n");
+
+    for (size_t i = 0; i < sceneCount; i++) {
+      printf("%-18s", scenes[i].name);
+      for (uint8_t primitive = 0; primitive < PRIMITIVE_COUNT; primitive++) {
+        double value = isTime ? sceneStats[i].micros[primitive] : sceneStats[i].pixels[primitive];
+        printf(" %9.1f", value / sceneFrames[i]);
+      }
+      printf("\n");
+    }
+  }
+
+  char row[80];
+  printf("\n%s\n", GlyphCache::getStatsHeader());
+  for (uint8_t cache = 0; formatGlyphCacheStats(cache, row, sizeof(row)); cache++) {
+    printf("%s\n", row);
+  }
+
+  char latencyRow[80];
+  printf("\n%s\n", LatencyTracer::getTableHeader());
+  for (LatencyStage stage : {LATENCY_RENDER, LATENCY_SCREEN}) {
+    for (uint8_t source = 0; source < LATENCY_SOURCE_COUNT; source++) {
+      if (getLatencyTracer().formatTableRow(stage, (LatencySource)source, latencyRow, sizeof(latencyRow))) {
+        printf("%s\n", latencyRow);
+      }
+    }
+  }
+
+  return failCount > 0 ? 1 : 0;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Renders the scripted scenes and compares them with the images in goldenDir,
+// or records them there instead. Returns the process exit code
+int runRenderCheck(const char *goldenDir, bool isRecording);
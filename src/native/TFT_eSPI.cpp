@@ -0,0 +1,325 @@
+#include "TFT_eSPI.h"
+#include <string.h>
+#include <chrono>
+
+CanvasStats canvasStats;
+
+CanvasStats &getCanvasStats() {
+    return canvasStats;
+}
+
+void CanvasStats::reset() {
+    *this = {};
+}
+
+const char *CanvasStats::getName(CanvasPrimitive primitive) {
+    switch (primitive) {
+        case PRIMITIVE_FILL:     return "fill";
+        case PRIMITIVE_CIRCLE:   return "circle";
+        case PRIMITIVE_SMOOTH:   return "smooth";
+        case PRIMITIVE_ARC:      return "arc";
+        case PRIMITIVE_TRIANGLE: return "triangle";
+        case PRIMITIVE_TEXT:     return "text";
+        case PRIMITIVE_BLIT:     return "blit";
+        case PRIMITIVE_DMA:      return "dma";
+        default:                 return "?";
+    }
+}
+
+// Times the outermost drawing call. Anything it calls, and every pixel it
+// writes, counts towards it
+static uint8_t primitiveDepth = 0;
+static CanvasPrimitive currentPrimitive = PRIMITIVE_FILL;
+
+class PrimitiveScope {
+    public:
+        PrimitiveScope(CanvasPrimitive primitive) {
+            if (primitiveDepth++ > 0) return;
+
+            currentPrimitive = primitive;
+            canvasStats.calls[primitive]++;
+            _start = std::chrono::steady_clock::now();
+        }
+
+        ~PrimitiveScope() {
+            if (--primitiveDepth > 0) return;
+
+            canvasStats.micros[currentPrimitive] += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point _start;
+};
+
+// The same conversions TFT_eSPI makes for 8 bit sprites
+static uint8_t toRgb332(uint16_t colour) {
+    return (colour & 0xE000) >> 8 | (colour & 0x0700) >> 6 | (colour & 0x0018) >> 3;
+}
+
+static uint16_t fromRgb332(uint8_t colour) {
+    const uint8_t blues[] = {0, 11, 21, 31};
+    if (colour == 0) return 0;
+
+    return (colour & 0xE0) << 8 | (colour & 0xC0) << 5 | (colour & 0x1C) << 6 | (colour & 0x1C) << 3 | blues[colour & 0x03];
+}
+
+static uint16_t alphaBlend(float alpha, uint16_t colour, uint16_t bgColour) {
+    auto channel = [alpha](uint16_t a, uint16_t b) { return (uint16_t)lroundf(b + (a - b) * alpha); };
+
+    return channel(colour >> 11, bgColour >> 11) << 11
+        | channel((colour >> 5) & 0x3F, (bgColour >> 5) & 0x3F) << 5
+        | channel(colour & 0x1F, bgColour & 0x1F);
+}
+
+static float clamp01(float value) {
+    return fminf(fmaxf(value, 0), 1);
+}
+
+TFT_eSPI::TFT_eSPI(int16_t width, int16_t height) {
+    allocate(width, height);
+}
+
+void TFT_eSPI::allocate(int16_t width, int16_t height) {
+    _width = width;
+    _height = height;
+    _pixels16.assign(_bpp == 16 ? width * height : 0, 0);
+    _pixels8.assign(_bpp == 8 ? width * height : 0, 0);
+    resetViewport();
+}
+
+void TFT_eSPI::pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data) {
+    PrimitiveScope scope(PRIMITIVE_DMA);
+
+    for (int32_t row = 0; row < h; row++) {
+        for (int32_t column = 0; column < w; column++) {
+            uint16_t swapped = data[row * w + column];
+            writePixel(x + column, y + row, swapped >> 8 | swapped << 8);
+        }
+    }
+}
+
+// Clipped to the screen, and with the datum moved to x, y when vpDatum is set
+void TFT_eSPI::setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum) {
+    resetViewport();
+    _xDatum = vpDatum ? x : 0;
+    _yDatum = vpDatum ? y : 0;
+
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > _width) w = _width - x;
+    if (y + h > _height) h = _height - y;
+
+    if (w < 1 || h < 1) {
+        _vpOoB = true;
+        return;
+    }
+
+    _vpX = x;
+    _vpY = y;
+    _vpW = x + w;
+    _vpH = y + h;
+}
+
+void TFT_eSPI::resetViewport() {
+    _xDatum = 0;
+    _yDatum = 0;
+    _vpX = 0;
+    _vpY = 0;
+    _vpW = _width;
+    _vpH = _height;
+    _vpOoB = false;
+}
+
+bool TFT_eSPI::isInViewport(int32_t &x, int32_t &y) {
+    if (_vpOoB) return false;
+
+    x += _xDatum;
+    y += _yDatum;
+    return x >= _vpX && x < _vpW && y >= _vpY && y < _vpH;
+}
+
+void TFT_eSPI::writePixel(int32_t x, int32_t y, uint16_t colour) {
+    if (!isInViewport(x, y)) return;
+
+    if (_bpp == 8) {
+        _pixels8[y * _width + x] = toRgb332(colour);
+    } else {
+        _pixels16[y * _width + x] = colour;
+    }
+
+    if (primitiveDepth > 0) canvasStats.pixels[currentPrimitive]++;
+}
+
+void TFT_eSPI::blendPixel(int32_t x, int32_t y, float alpha, uint16_t colour, uint32_t bgColour) {
+    if (alpha <= 0) return;
+
+    uint16_t behind = (bgColour == 0x00FFFFFF) ? readPixel(x, y) : bgColour;
+    writePixel(x, y, alphaBlend(alpha, colour, behind));
+}
+
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y) {
+    if (!isInViewport(x, y)) return 0;
+
+    return (_bpp == 8) ? fromRgb332(_pixels8[y * _width + x]) : _pixels16[y * _width + x];
+}
+
+void TFT_eSPI::fillScreen(uint32_t colour) {
+    fillRect(_vpX - _xDatum, _vpY - _yDatum, _vpW - _vpX, _vpH - _vpY, colour);
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t colour) {
+    PrimitiveScope scope(PRIMITIVE_FILL);
+    writePixel(x, y, colour);
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t colour) {
+    fillRect(x, y, w, 1, colour);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t colour) {
+    PrimitiveScope scope(PRIMITIVE_FILL);
+
+    for (int32_t row = y; row < y + h; row++) {
+        for (int32_t column = x; column < x + w; column++) {
+            writePixel(column, row, colour);
+        }
+    }
+}
+
+void TFT_eSPI::drawCircle(int32_t x, int32_t y, int32_t r, uint32_t colour) {
+    PrimitiveScope scope(PRIMITIVE_CIRCLE);
+
+    for (int32_t dy = -r - 1; dy <= r + 1; dy++) {
+        for (int32_t dx = -r - 1; dx <= r + 1; dx++) {
+            if (fabsf(sqrtf(dx * dx + dy * dy) - r) < 0.5f) writePixel(x + dx, y + dy, colour);
+        }
+    }
+}
+
+void TFT_eSPI::fillCircle(int32_t x, int32_t y, int32_t r, uint32_t colour) {
+    PrimitiveScope scope(PRIMITIVE_CIRCLE);
+
+    for (int32_t dy = -r; dy <= r; dy++) {
+        int32_t dx = sqrtf(r * r - dy * dy + 0.5f);
+        fillRect(x - dx, y + dy, 2 * dx + 1, 1, colour);
+    }
+}
+
+void TFT_eSPI::smoothDisc(float x, float y, float r, uint16_t colour, uint32_t bgColour) {
+    for (int32_t py = floorf(y - r - 1); py <= ceilf(y + r + 1); py++) {
+        for (int32_t px = floorf(x - r - 1); px <= ceilf(x + r + 1); px++) {
+            float distance = sqrtf((px - x) * (px - x) + (py - y) * (py - y));
+            blendPixel(px, py, clamp01(r + 0.5f - distance), colour, bgColour);
+        }
+    }
+}
+
+void TFT_eSPI::fillSmoothCircle(int32_t x, int32_t y, int32_t r, uint32_t colour, uint32_t bgColour) {
+    PrimitiveScope scope(PRIMITIVE_SMOOTH);
+    smoothDisc(x, y, r, colour, bgColour);
+}
+
+void TFT_eSPI::drawSpot(float x, float y, float r, uint32_t colour, uint32_t bgColour) {
+    PrimitiveScope scope(PRIMITIVE_SMOOTH);
+    smoothDisc(x, y, r, colour, bgColour);
+}
+
+void TFT_eSPI::drawSmoothCircle(int32_t x, int32_t y, int32_t r, uint32_t colour, uint32_t bgColour) {
+    PrimitiveScope scope(PRIMITIVE_SMOOTH);
+
+    for (int32_t dy = -r - 1; dy <= r + 1; dy++) {
+        for (int32_t dx = -r - 1; dx <= r + 1; dx++) {
+            float distance = sqrtf(dx * dx + dy * dy);
+            blendPixel(x + dx, y + dy, clamp01(1 - fabsf(distance - r)), colour, bgColour);
+        }
+    }
+}
+
+void TFT_eSPI::drawArc(int32_t x, int32_t y, int32_t r, int32_t ir, uint32_t startAngle, uint32_t endAngle,
+    uint32_t colour, uint32_t bgColour, bool smoothArc) {
+    PrimitiveScope scope(PRIMITIVE_ARC);
+
+    if (r < ir) std::swap(r, ir);
+    startAngle = min(startAngle, 360u);
+    endAngle = min(endAngle, 360u);
+    if (startAngle == endAngle) return;
+
+    for (int32_t dy = -r - 1; dy <= r + 1; dy++) {
+        for (int32_t dx = -r - 1; dx <= r + 1; dx++) {
+            // Clockwise from 6 o'clock, and it wraps past 360 when the end is before the start
+            float angle = atan2f(-dx, dy) * 180 / (float)M_PI;
+            if (angle < 0) angle += 360;
+            bool isInArc = (startAngle < endAngle)
+                ? angle >= startAngle && angle <= endAngle
+                : angle >= startAngle || angle <= endAngle;
+            if (!isInArc) continue;
+
+            float distance = sqrtf(dx * dx + dy * dy);
+            float alpha = fminf(clamp01(r + 0.5f - distance), clamp01(distance - ir + 0.5f));
+
+            if (smoothArc) {
+                blendPixel(x + dx, y + dy, alpha, colour, bgColour);
+            } else if (alpha >= 0.5f) {
+                writePixel(x + dx, y + dy, colour);
+            }
+        }
+    }
+}
+
+void TFT_eSPI::fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t colour) {
+    PrimitiveScope scope(PRIMITIVE_TRIANGLE);
+
+    // Which side of the edge from a to b the point is on
+    auto side = [](int32_t ax, int32_t ay, int32_t bx, int32_t by, int32_t x, int32_t y) {
+        return (int64_t)(bx - ax) * (y - ay) - (int64_t)(by - ay) * (x - ax);
+    };
+
+    for (int32_t y = min(y0, min(y1, y2)); y <= max(y0, max(y1, y2)); y++) {
+        for (int32_t x = min(x0, min(x1, x2)); x <= max(x0, max(x1, x2)); x++) {
+            int64_t a = side(x0, y0, x1, y1, x, y);
+            int64_t b = side(x1, y1, x2, y2, x, y);
+            int64_t c = side(x2, y2, x0, y0, x, y);
+
+            if ((a >= 0 && b >= 0 && c >= 0) || (a <= 0 && b <= 0 && c <= 0)) writePixel(x, y, colour);
+        }
+    }
+}
+
+// Font 2 is 16px tall, and about 7px a character
+int16_t TFT_eSPI::textWidth(const char *text, uint8_t) {
+    return strlen(text) * 7;
+}
+
+int16_t TFT_eSPI::drawString(const char *text, int32_t x, int32_t y, uint8_t font) {
+    PrimitiveScope scope(PRIMITIVE_TEXT);
+
+    int16_t width = textWidth(text, font);
+    int32_t left = (_textDatum == MC_DATUM) ? x - width / 2 : x;
+    int32_t top = (_textDatum == MC_DATUM) ? y - 8 : y;
+
+    for (const char *c = text; *c; c++) {
+        if (*c != ' ') fillRect(left + 1, top + 4, 5, 8, _textColour);
+        left += 7;
+    }
+
+    return width;
+}
+
+void *TFT_eSprite::createSprite(int16_t width, int16_t height) {
+    allocate(width, height);
+
+    return (_bpp == 8) ? (void *)_pixels8.data() : (void *)_pixels16.data();
+}
+
+void TFT_eSprite::pushToSprite(TFT_eSprite *target, int32_t x, int32_t y, uint16_t transparent) {
+    PrimitiveScope scope(PRIMITIVE_BLIT);
+
+    for (int32_t row = 0; row < _height; row++) {
+        for (int32_t column = 0; column < _width; column++) {
+            size_t i = row * _width + column;
+            uint16_t colour = (_bpp == 8) ? fromRgb332(_pixels8[i]) : _pixels16[i];
+
+            if (colour != transparent) target->writePixel(x + column, y + row, colour);
+        }
+    }
+}
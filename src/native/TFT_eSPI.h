@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+#include "../Compat.h"
+
+// Stands in for TFT_eSPI on the host, drawing into memory instead of the panel.
+// Only what Render.cpp and GlyphCache use is here. Shapes are drawn the same
+// way as the library, but not pixel for pixel the same, and text is a box per
+// character as the real fonts aren't available off the board. Good enough to
+// see what moved and to count what it costs.
+
+#define MC_DATUM 4
+
+// What each drawing call gets counted as
+enum CanvasPrimitive : uint8_t {
+    PRIMITIVE_FILL,     // Rects, lines and clears
+    PRIMITIVE_CIRCLE,
+    PRIMITIVE_SMOOTH,   // Anti-aliased circles and spots
+    PRIMITIVE_ARC,
+    PRIMITIVE_TRIANGLE,
+    PRIMITIVE_TEXT,
+    PRIMITIVE_BLIT,     // Sprites pushed into other sprites
+    PRIMITIVE_DMA,      // Pixels sent to the panel
+    PRIMITIVE_COUNT
+};
+
+struct CanvasStats {
+    uint32_t calls[PRIMITIVE_COUNT];
+    uint64_t pixels[PRIMITIVE_COUNT]; // Written, after clipping
+    double micros[PRIMITIVE_COUNT]; // Wall time
+
+    void reset();
+    static const char *getName(CanvasPrimitive primitive);
+};
+
+CanvasStats &getCanvasStats();
+
+class TFT_eSPI {
+    public:
+        TFT_eSPI(int16_t width = 240, int16_t height = 240);
+
+        void init() {}
+        void initDMA() {}
+        void setRotation(uint8_t) {}
+        void startWrite() {}
+        bool dmaBusy() { return false; }
+        // data is byte swapped, as it goes out over SPI
+        void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data);
+
+        int16_t width() { return _width; }
+        int16_t height() { return _height; }
+
+        void setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum = true);
+        void resetViewport();
+
+        void fillScreen(uint32_t colour);
+        void drawPixel(int32_t x, int32_t y, uint32_t colour);
+        uint16_t readPixel(int32_t x, int32_t y);
+        void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t colour);
+        void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t colour);
+
+        void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t colour);
+        void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t colour);
+        // Without a bgColour these blend with whatever's already there
+        void fillSmoothCircle(int32_t x, int32_t y, int32_t r, uint32_t colour, uint32_t bgColour = 0x00FFFFFF);
+        void drawSmoothCircle(int32_t x, int32_t y, int32_t r, uint32_t colour, uint32_t bgColour = 0x00FFFFFF);
+        void drawSpot(float x, float y, float r, uint32_t colour, uint32_t bgColour = 0x00FFFFFF);
+        // Angles in degrees, clockwise from 6 o'clock
+        void drawArc(int32_t x, int32_t y, int32_t r, int32_t ir, uint32_t startAngle, uint32_t endAngle,
+            uint32_t colour, uint32_t bgColour, bool smoothArc = true);
+        void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t colour);
+
+        void setTextDatum(uint8_t datum) { _textDatum = datum; }
+        void setTextColor(uint16_t colour) { _textColour = colour; }
+        void setTextColor(uint16_t colour, uint16_t, bool = false) { _textColour = colour; }
+        int16_t textWidth(const char *text, uint8_t font);
+        int16_t drawString(const char *text, int32_t x, int32_t y, uint8_t font);
+
+    protected:
+        void allocate(int16_t width, int16_t height);
+        // In screen coordinates, before the viewport's datum is added
+        bool isInViewport(int32_t &x, int32_t &y);
+        void writePixel(int32_t x, int32_t y, uint16_t colour);
+        void blendPixel(int32_t x, int32_t y, float alpha, uint16_t colour, uint32_t bgColour);
+        void smoothDisc(float x, float y, float r, uint16_t colour, uint32_t bgColour);
+
+        int16_t _width = 0;
+        int16_t _height = 0;
+        uint8_t _bpp = 16;
+        std::vector<uint16_t> _pixels16;
+        std::vector<uint8_t> _pixels8; // RGB332, as TFT_eSPI stores 8 bit sprites
+
+        // Viewport clip and datum, as TFT_eSPI has them
+        int32_t _xDatum = 0, _yDatum = 0;
+        int32_t _vpX = 0, _vpY = 0, _vpW = 0, _vpH = 0;
+        bool _vpOoB = false;
+
+        uint8_t _textDatum = 0;
+        uint16_t _textColour = 0xFFFF;
+};
+
+class TFT_eSprite : public TFT_eSPI {
+    public:
+        TFT_eSprite(TFT_eSPI *) : TFT_eSPI(0, 0) {}
+
+        void setColorDepth(int8_t bpp) { _bpp = bpp; }
+        void *createSprite(int16_t width, int16_t height);
+        void deleteSprite() { allocate(0, 0); }
+        void fillSprite(uint32_t colour) { fillScreen(colour); }
+
+        // Pixels in transparent are left out
+        void pushToSprite(TFT_eSprite *target, int32_t x, int32_t y, uint16_t transparent);
+};
@@ -0,0 +1,55 @@
+#include "sineCosinePot.h"
+
+SineCosinePot::SineCosinePot(uint adcChannelA, uint adcChannelB) {
+  _adcPins[0] = adcChannelToPin[adcChannelA];
+  _adcPins[1] = adcChannelToPin[adcChannelB];
+}
+
+void SineCosinePot::update() {
+  // Already lowpass filtered, at a fixed rate, by the HAL
+  uint16_t adc[2] = {getHal().readAnalog(_adcPins[0]), getHal().readAnalog(_adcPins[1])};
+  uint64_t nowMicros = getHal().getMicros();
+
+  if (_isCalibrating) {
+    for (uint8_t track = 0; track < 2; track++) {
+      _found.trackMin[track] = min(_found.trackMin[track], adc[track]);
+      _found.trackMax[track] = max(_found.trackMax[track], adc[track]);
+    }
+  }
+
+  // Doubled, so the centre doesn't lose its half. Each is scaled by the other's
+  // range, which evens them up without a divide. Fits in 32 bits, just
+  int32_t centred[2];
+  uint16_t quarterRange[2];
+  for (uint8_t track = 0; track < 2; track++) {
+    centred[track] = 2 * adc[track] - (_calibration.trackMin[track] + _calibration.trackMax[track]);
+    quarterRange[track] = (_calibration.trackMax[track] - _calibration.trackMin[track]) >> 2;
+  }
+
+  Angle lastAngle = _angle;
+  _angle = Angle::atan2(centred[0] * quarterRange[1], centred[1] * quarterRange[0]);
+  // There's nothing to have moved from the first time
+  _angleDelta = _hasAngle ? lastAngle.degreesTo(_angle) : 0;
+  _hasAngle = true;
+
+  // Smoothed towards angleDelta / elapsed seconds, so it doesn't matter how often it's called
+  float elapsedSeconds = (nowMicros - _lastMicros) * 1e-6f;
+  _velocity += (_angleDelta - _velocity * elapsedSeconds) / (VELOCITY_SMOOTHING_SECONDS + elapsedSeconds);
+  _lastMicros = nowMicros;
+}
+
+void SineCosinePot::beginCalibration() {
+  _found = {{65535, 65535}, {0, 0}};
+  _isCalibrating = true;
+}
+
+bool SineCosinePot::endCalibration() {
+  _isCalibrating = false;
+
+  for (uint8_t track = 0; track < 2; track++) {
+    if (_found.trackMax[track] < _found.trackMin[track] + MIN_TRACK_RANGE) return false;
+  }
+
+  _calibration = _found;
+  return true;
+}
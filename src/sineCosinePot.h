@@ -1,55 +1,52 @@
 #pragma once
 
-#include <Arduino.h>
+#include "Hal.hpp"
 #include "utils.h"
+#include "Angle.hpp"
+#include "CalibrationStore.hpp"
 
 const uint adcChannelToPin[3] = {26, 27, 28};
 
+// An endless pot with two tracks a quarter turn apart, read as the sine and
+// cosine of its angle. Each track's centred and scaled to the other using
+// the unit's calibration, then the angle's their atan2. The track that's
+// near its end, and flattening out, barely moves the result, so there's
+// no dead zone to work around.
 class SineCosinePot {
   public:
-    SineCosinePot(uint adcChannelA, uint adcChannelB) {
-      _adcChannelA = adcChannelA;
-      _adcPinA = adcChannelToPin[adcChannelA];
+    // How long the velocity's smoothed over. The readings only change every 4ms
+    static constexpr float VELOCITY_SMOOTHING_SECONDS = 0.03f;
+    // Less than this and a track's probably not been turned all the way round
+    static const uint16_t MIN_TRACK_RANGE = 16384;
 
-      _adcChannelB = adcChannelB;
-      _adcPinB =  adcChannelToPin[adcChannelB];
-    }
+    SineCosinePot(uint adcChannelA, uint adcChannelB);
 
-    ~SineCosinePot() {}
+    void update();
 
-    void update() {
-      uint16_t adcA = analogRead(A0);
-      uint16_t adcB = analogRead(A1);
-
-      // Lowpass filter the results with a lerp
-      float halfAngleFromAdcA = lerp(adcA / 5.6888888889, _lastHalfAngleA, 0.98f);
-      float halfAngleFromAdcB = lerp(adcB / 5.6888888889, _lastHalfAngleB, 0.98f);
-      _lastHalfAngleA = halfAngleFromAdcA;
-      _lastHalfAngleB = halfAngleFromAdcB;
-
-      float angleFromAdcA = 360 - ((halfAngleFromAdcB <= 90) ? halfAngleFromAdcA : 360 - halfAngleFromAdcA);
-      angleFromAdcA = fwrap(angleFromAdcA + 90, 0, 360);
-      float angleFromAdcB = (halfAngleFromAdcA <= 90) ? halfAngleFromAdcB : 360 - halfAngleFromAdcB;
-
-      float lastAngle = _angle;
+    Angle getAngle() { return _angle; }
+    float getAngleDelta() { return _angleDelta; }
+    // Degrees a second, clockwise's positive
+    float getVelocity() { return _velocity; }
 
-      // Avoid the deadzones around 0 and 180 in the potentiometer tracks 
-      float a = 1 - abs(halfAngleFromAdcA - 90) / 90.f;
-      float b = 1 - abs(halfAngleFromAdcB - 90) / 90.f;
-      _angle = lerp(angleFromAdcB, angleFromAdcA, a / (float)(a + b));
-      _angleDelta = degBetweenAngles(lastAngle, _angle);
-    }
+    void setCalibration(const PotCalibration &calibration) { _calibration = calibration; }
+    const PotCalibration &getCalibration() { return _calibration; }
 
-    float getAngle() { return _angle; }
-    float getAngleDelta() { return _angleDelta; }
+    // From now on each track's reach is taken from what it reads, so the pot
+    // wants turning round a few times before endCalibration
+    void beginCalibration();
+    // Starts using what was found, as long as every track went far enough. Returns whether it did
+    bool endCalibration();
+    bool isCalibrating() { return _isCalibrating; }
 
   private:
-    uint _adcChannelA;
-    uint _adcPinA;
-    uint _adcChannelB;
-    uint _adcPinB;
-    float _angle;
-    float _angleDelta;
-    float _lastHalfAngleA;
-    float _lastHalfAngleB;
-};
\ No newline at end of file
+    uint _adcPins[2];
+    PotCalibration _calibration = {{0, 0}, {65535, 65535}};
+    PotCalibration _found;
+    bool _isCalibrating = false;
+
+    Angle _angle;
+    bool _hasAngle = false;
+    float _angleDelta = 0;
+    float _velocity = 0;
+    uint64_t _lastMicros = 0;
+};
@@ -0,0 +1,110 @@
+// Feeds the sampler's CIC filter samples by hand, the way the DMA ring does on the board
+#include <unity.h>
+#include <random>
+#include "AdcSampler.hpp"
+
+static AdcSampler sampler;
+
+// A reading's worth of the same sample on channel
+static void feedReading(uint8_t channel, uint16_t sample) {
+    for (uint16_t i = 0; i < AdcSampler::DECIMATION; i++) {
+        sampler.addSample(channel, sample);
+    }
+}
+
+void setUp(void) {
+    sampler = AdcSampler();
+}
+
+void tearDown(void) {}
+
+// 12 bits in and 16 out, so a steady sample reads 16 times over
+void test_gain_takes_12_bits_to_16(void) {
+    const uint16_t samples[] = {0, 1, 2048, 4000, 4095};
+    for (uint16_t sample : samples) {
+        for (uint8_t i = 0; i < 3; i++) feedReading(0, sample);
+        TEST_ASSERT_EQUAL_UINT16(sample * 16, sampler.read(0));
+    }
+}
+
+// Two averages of DECIMATION samples in a row, so a step that lands on a
+// reading's first sample is part way there after one reading and all the way after two
+void test_step_response_takes_two_readings(void) {
+    for (uint8_t i = 0; i < 3; i++) feedReading(1, 0);
+    TEST_ASSERT_EQUAL_UINT16(0, sampler.read(1));
+
+    feedReading(1, 4000);
+    const uint32_t ramp = AdcSampler::DECIMATION * (AdcSampler::DECIMATION + 1) / 2;
+    TEST_ASSERT_EQUAL_UINT16(4000 * ramp >> 8, sampler.read(1));
+
+    feedReading(1, 4000);
+    TEST_ASSERT_EQUAL_UINT16(64000, sampler.read(1));
+
+    // And back down the same way
+    feedReading(1, 0);
+    TEST_ASSERT_EQUAL_UINT16(64000 - (4000 * ramp >> 8), sampler.read(1));
+    feedReading(1, 0);
+    TEST_ASSERT_EQUAL_UINT16(0, sampler.read(1));
+}
+
+void test_readings_only_change_once_per_decimation(void) {
+    feedReading(0, 1000);
+    uint16_t reading = sampler.read(0);
+
+    for (uint16_t i = 0; i + 1 < AdcSampler::DECIMATION; i++) {
+        sampler.addSample(0, 3000);
+        TEST_ASSERT_EQUAL_UINT16(reading, sampler.read(0));
+    }
+    sampler.addSample(0, 3000);
+    TEST_ASSERT_NOT_EQUAL(reading, sampler.read(0));
+}
+
+void test_channels_are_filtered_apart(void) {
+    for (uint16_t i = 0; i < 3 * AdcSampler::DECIMATION; i++) {
+        sampler.addSample(0, 100);
+        sampler.addSample(1, 2000);
+        sampler.addSample(2, 4095);
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(1600, sampler.read(0));
+    TEST_ASSERT_EQUAL_UINT16(32000, sampler.read(1));
+    TEST_ASSERT_EQUAL_UINT16(65520, sampler.read(2));
+}
+
+// The integrators wrap every few thousand samples at full scale, which the combs undo
+void test_integrators_wrapping_doesnt_show(void) {
+    for (uint32_t i = 0; i < 200000; i++) {
+        sampler.addSample(2, 4095);
+    }
+    TEST_ASSERT_EQUAL_UINT16(65520, sampler.read(2));
+
+    feedReading(2, 1234);
+    feedReading(2, 1234);
+    TEST_ASSERT_EQUAL_UINT16(1234 * 16, sampler.read(2));
+}
+
+void test_noise_is_averaged_out(void) {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> noise(-40, 40);
+
+    for (uint8_t i = 0; i < 2; i++) {
+        for (uint16_t j = 0; j < AdcSampler::DECIMATION; j++) sampler.addSample(0, 2000 + noise(rng));
+    }
+
+    // The samples wander 640 either way once they're 16 bits
+    for (uint16_t i = 0; i < 100; i++) {
+        for (uint16_t j = 0; j < AdcSampler::DECIMATION; j++) sampler.addSample(0, 2000 + noise(rng));
+        TEST_ASSERT_UINT16_WITHIN(160, 32000, sampler.read(0));
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_gain_takes_12_bits_to_16);
+    RUN_TEST(test_step_response_takes_two_readings);
+    RUN_TEST(test_readings_only_change_once_per_decimation);
+    RUN_TEST(test_channels_are_filtered_apart);
+    RUN_TEST(test_integrators_wrapping_doesnt_show);
+    RUN_TEST(test_noise_is_averaged_out);
+    return UNITY_END();
+}
@@ -0,0 +1,120 @@
+// Checks Angle's table and CORDIC against the float maths they stand in for,
+// and that everything wraps round the turn the way it should
+#include <unity.h>
+#include <math.h>
+#include "Angle.hpp"
+#include "Vec2.h"
+
+static double radiansOf(uint32_t bam) {
+    return bam * (2 * M_PI / 65536);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_sin_and_cos_follow_the_float_ones(void) {
+    int maxSinError = 0;
+    int maxCosError = 0;
+    for (uint32_t bam = 0; bam < 65536; bam++) {
+        Angle angle = Angle::fromBam(bam);
+        maxSinError = max(maxSinError, abs(angle.sinQ15() - (int)lround(sin(radiansOf(bam)) * 32767)));
+        maxCosError = max(maxCosError, abs(angle.cosQ15() - (int)lround(cos(radiansOf(bam)) * 32767)));
+    }
+
+    // Under a thousandth of a percent, the straight lines between the table's steps sag a little
+    TEST_ASSERT_LESS_OR_EQUAL(3, maxSinError);
+    TEST_ASSERT_LESS_OR_EQUAL(3, maxCosError);
+}
+
+void test_sin_hits_the_quarters_exactly(void) {
+    TEST_ASSERT_EQUAL_INT16(0, Angle::fromBam(0).sinQ15());
+    TEST_ASSERT_EQUAL_INT16(32767, Angle::fromBam(Angle::QUARTER_TURN).sinQ15());
+    TEST_ASSERT_EQUAL_INT16(0, Angle::fromBam(Angle::HALF_TURN).sinQ15());
+    TEST_ASSERT_EQUAL_INT16(-32767, Angle::fromBam(3 * Angle::QUARTER_TURN).sinQ15());
+    TEST_ASSERT_EQUAL_INT16(32767, Angle::fromBam(0).cosQ15());
+    TEST_ASSERT_EQUAL_INT16(-32767, Angle::fromBam(Angle::HALF_TURN).cosQ15());
+}
+
+void test_from_polar_is_within_a_hundredth_of_a_pixel(void) {
+    float maxError = 0;
+    for (uint32_t bam = 0; bam < 65536; bam++) {
+        Vec2 fromTable = Vec2::fromPolar(120.f, Angle::fromBam(bam));
+        maxError = max(maxError, fabsf(fromTable.x - (float)(120 * sin(radiansOf(bam)))));
+        maxError = max(maxError, fabsf(fromTable.y + (float)(120 * cos(radiansOf(bam)))));
+    }
+
+    TEST_ASSERT_LESS_THAN_FLOAT(0.01f, maxError);
+}
+
+void test_atan2_is_within_a_bam(void) {
+    // Short vectors and long ones, so the scaling up and down are both used.
+    // Checked against the float atan2 of the same rounded x and y
+    const double radii[] = {300, 40000, 2e9};
+    for (double radius : radii) {
+        int maxError = 0;
+        for (uint32_t bam = 0; bam < 65536; bam += 7) {
+            int32_t x = lround(cos(radiansOf(bam)) * radius);
+            int32_t y = lround(sin(radiansOf(bam)) * radius);
+            Angle exact = Angle::fromBam((uint16_t)lround(atan2((double)y, (double)x) * (65536 / (2 * M_PI))));
+            maxError = max(maxError, abs(exact.deltaTo(Angle::atan2(y, x))));
+        }
+
+        TEST_ASSERT_LESS_OR_EQUAL(1, maxError);
+    }
+}
+
+void test_atan2_quadrants(void) {
+    TEST_ASSERT_EQUAL_UINT16(0, Angle::atan2(0, 0).getBam());
+    TEST_ASSERT_EQUAL_UINT16(0, Angle::atan2(0, 1000).getBam());
+    TEST_ASSERT_EQUAL_UINT16(Angle::QUARTER_TURN, Angle::atan2(1000, 0).getBam());
+    TEST_ASSERT_EQUAL_UINT16(Angle::HALF_TURN, Angle::atan2(0, -1000).getBam());
+    TEST_ASSERT_EQUAL_UINT16(3 * Angle::QUARTER_TURN, Angle::atan2(-1000, 0).getBam());
+    TEST_ASSERT_UINT16_WITHIN(1, 5 * Angle::QUARTER_TURN / 2, Angle::atan2(-1000, -1000).getBam());
+    TEST_ASSERT_UINT16_WITHIN(1, 3 * Angle::QUARTER_TURN / 2, Angle::atan2(INT32_MAX, INT32_MIN + 1).getBam());
+}
+
+void test_degrees_wrap_round(void) {
+    TEST_ASSERT_TRUE(Angle::fromDegrees(10) == Angle::fromDegrees(370));
+    TEST_ASSERT_TRUE(Angle::fromDegrees(270) == Angle::fromDegrees(-90));
+    TEST_ASSERT_TRUE(Angle::fromDegrees(0) == Angle::fromDegrees(-720));
+    TEST_ASSERT_EQUAL_FLOAT(270, Angle::fromDegrees(-90).toDegrees());
+    TEST_ASSERT_EQUAL_UINT16(1000, (Angle::fromBam(65000) + Angle::fromBam(1536)).getBam());
+    TEST_ASSERT_EQUAL_UINT16(65000, (Angle::fromBam(1000) - Angle::fromBam(1536)).getBam());
+}
+
+void test_delta_goes_the_short_way_round(void) {
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 20, Angle::fromDegrees(350).degreesTo(Angle::fromDegrees(10)));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -20, Angle::fromDegrees(10).degreesTo(Angle::fromDegrees(350)));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -180, Angle::fromDegrees(0).degreesTo(Angle::fromDegrees(180)));
+    TEST_ASSERT_EQUAL_INT16(-Angle::QUARTER_TURN, Angle::fromBam(100).deltaTo(Angle::fromBam(100 - Angle::QUARTER_TURN)));
+}
+
+void test_lerp_goes_the_short_way_round(void) {
+    Angle halfway = lerp(Angle::fromDegrees(350), Angle::fromDegrees(30), 0.5f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10, halfway.toDegrees());
+    TEST_ASSERT_TRUE(lerp(Angle::fromDegrees(30), Angle::fromDegrees(350), 1) == Angle::fromDegrees(350));
+}
+
+void test_nearest_division_wraps_to_the_first(void) {
+    TEST_ASSERT_EQUAL_UINT16(0, Angle::fromDegrees(359).nearestDivision(8));
+    TEST_ASSERT_EQUAL_UINT16(0, Angle::fromDegrees(-22).nearestDivision(8));
+    TEST_ASSERT_EQUAL_UINT16(7, Angle::fromDegrees(-23).nearestDivision(8));
+    TEST_ASSERT_EQUAL_UINT16(1, Angle::fromDegrees(67).nearestDivision(8));
+    TEST_ASSERT_EQUAL_UINT16(2, Angle::fromDegrees(68).nearestDivision(8));
+    TEST_ASSERT_EQUAL_UINT16(4, Angle::fromDegrees(-80).nearestDivision(5));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sin_and_cos_follow_the_float_ones);
+    RUN_TEST(test_sin_hits_the_quarters_exactly);
+    RUN_TEST(test_from_polar_is_within_a_hundredth_of_a_pixel);
+    RUN_TEST(test_atan2_is_within_a_bam);
+    RUN_TEST(test_atan2_quadrants);
+    RUN_TEST(test_degrees_wrap_round);
+    RUN_TEST(test_delta_goes_the_short_way_round);
+    RUN_TEST(test_lerp_goes_the_short_way_round);
+    RUN_TEST(test_nearest_division_wraps_to_the_first);
+    return UNITY_END();
+}
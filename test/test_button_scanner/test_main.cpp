@@ -0,0 +1,140 @@
+// Feeds the scanner's debouncer scans by hand, the way the PIO interrupt does on the board
+#include <unity.h>
+#include <vector>
+#include "ButtonScanner.hpp"
+
+static const uint32_t SCAN_MICROS = 1000000 / ButtonScanner::SCAN_HZ;
+
+static ButtonScanner *scanner = nullptr; // Made fresh for each test, its queue can't be copied
+static uint64_t nowMicros;
+
+static void scan(uint16_t pressedChannels, uint32_t times = 1) {
+    for (uint32_t i = 0; i < times; i++) {
+        nowMicros += SCAN_MICROS;
+        scanner->addScan(pressedChannels, nowMicros);
+    }
+}
+
+static std::vector<ButtonEdge> takeEdges() {
+    std::vector<ButtonEdge> edges;
+    const ButtonEdge *edge;
+    while ((edge = scanner->peekEdge()) != nullptr) {
+        edges.push_back(*edge);
+        scanner->dropEdge();
+    }
+    return edges;
+}
+
+void setUp(void) {
+    delete scanner;
+    scanner = new ButtonScanner(2, 3, 4, 5, 6);
+    nowMicros = 0;
+}
+
+void tearDown(void) {}
+
+void test_a_press_lands_after_the_debounce_scans(void) {
+    scan(0x0010, ButtonScanner::DEBOUNCE_SCANS - 1);
+    TEST_ASSERT_EQUAL_UINT16(0, scanner->getPressedChannels());
+    TEST_ASSERT_EQUAL(0, takeEdges().size());
+
+    scan(0x0010);
+    uint64_t settledMicros = nowMicros;
+    TEST_ASSERT_EQUAL_UINT16(0x0010, scanner->getPressedChannels());
+
+    std::vector<ButtonEdge> edges = takeEdges();
+    TEST_ASSERT_EQUAL(1, edges.size());
+    TEST_ASSERT_EQUAL_UINT8(4, edges[0].channel);
+    TEST_ASSERT_TRUE(edges[0].isPressed);
+    TEST_ASSERT_EQUAL_UINT64(settledMicros, edges[0].micros);
+
+    // And the release the same way
+    scan(0, ButtonScanner::DEBOUNCE_SCANS - 1);
+    TEST_ASSERT_EQUAL_UINT16(0x0010, scanner->getPressedChannels());
+    scan(0);
+    edges = takeEdges();
+    TEST_ASSERT_EQUAL(1, edges.size());
+    TEST_ASSERT_FALSE(edges[0].isPressed);
+}
+
+void test_bounces_are_ignored(void) {
+    // Chatters on both edges, with a single scan either way in the middle of each hold
+    for (uint8_t i = 0; i < 6; i++) scan(i % 2 ? 0x8000 : 0);
+    scan(0x8000, ButtonScanner::DEBOUNCE_SCANS - 2);
+    scan(0);
+    scan(0x8000, ButtonScanner::DEBOUNCE_SCANS - 1);
+    TEST_ASSERT_EQUAL(0, takeEdges().size());
+
+    scan(0x8000);
+    TEST_ASSERT_EQUAL(1, takeEdges().size());
+
+    scan(0x8000, 20);
+    scan(0, 3);
+    scan(0x8000, 20);
+    TEST_ASSERT_EQUAL(0, takeEdges().size());
+    TEST_ASSERT_EQUAL_UINT16(0x8000, scanner->getPressedChannels());
+}
+
+void test_channels_debounce_on_their_own(void) {
+    scan(0x0001, 4);
+    scan(0x0003, 4);
+    std::vector<ButtonEdge> edges = takeEdges();
+    TEST_ASSERT_EQUAL(1, edges.size());
+    TEST_ASSERT_EQUAL_UINT8(0, edges[0].channel);
+
+    // 1's been down four scans already, 0 has only just let go
+    scan(0x0002, 4);
+    edges = takeEdges();
+    TEST_ASSERT_EQUAL(1, edges.size());
+    TEST_ASSERT_EQUAL_UINT8(1, edges[0].channel);
+    TEST_ASSERT_TRUE(edges[0].isPressed);
+    scan(0x0002, 4);
+    edges = takeEdges();
+    TEST_ASSERT_EQUAL(1, edges.size());
+    TEST_ASSERT_EQUAL_UINT8(0, edges[0].channel);
+    TEST_ASSERT_FALSE(edges[0].isPressed);
+
+    // Changes that settle on the same scan come lowest channel first
+    scan(0x0001, ButtonScanner::DEBOUNCE_SCANS);
+    edges = takeEdges();
+    TEST_ASSERT_EQUAL(2, edges.size());
+    TEST_ASSERT_EQUAL_UINT8(0, edges[0].channel);
+    TEST_ASSERT_TRUE(edges[0].isPressed);
+    TEST_ASSERT_EQUAL_UINT8(1, edges[1].channel);
+    TEST_ASSERT_FALSE(edges[1].isPressed);
+}
+
+void test_a_full_queue_holds_edges_back_until_theres_room(void) {
+    // Pressing and releasing everything fills the queue, with nothing taking the edges
+    scan(0xffff, ButtonScanner::DEBOUNCE_SCANS);
+    scan(0, ButtonScanner::DEBOUNCE_SCANS);
+
+    // So the next presses have nowhere to go, and don't count yet
+    scan(0xffff, ButtonScanner::DEBOUNCE_SCANS);
+    TEST_ASSERT_EQUAL_UINT16(0, scanner->getPressedChannels());
+
+    // Room for one, which goes on the next scan
+    scanner->dropEdge();
+    scan(0xffff);
+    TEST_ASSERT_EQUAL_UINT16(0x0001, scanner->getPressedChannels());
+
+    std::vector<ButtonEdge> edges = takeEdges();
+    TEST_ASSERT_EQUAL(32, edges.size());
+    TEST_ASSERT_EQUAL_UINT8(0, edges.back().channel);
+    TEST_ASSERT_TRUE(edges.back().isPressed);
+    TEST_ASSERT_EQUAL_UINT64(nowMicros, edges.back().micros);
+
+    // And the rest once there's room for them
+    scan(0xffff);
+    TEST_ASSERT_EQUAL_UINT16(0xffff, scanner->getPressedChannels());
+    TEST_ASSERT_EQUAL(15, takeEdges().size());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_a_press_lands_after_the_debounce_scans);
+    RUN_TEST(test_bounces_are_ignored);
+    RUN_TEST(test_channels_debounce_on_their_own);
+    RUN_TEST(test_a_full_queue_holds_edges_back_until_theres_room);
+    return UNITY_END();
+}
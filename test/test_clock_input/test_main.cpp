@@ -0,0 +1,159 @@
+// Replays MIDI and analog clock streams through ClockInput in virtual time
+#include <unity.h>
+#include <random>
+#include "Sequence.h"
+#include "ClockEngine.hpp"
+#include "ClockInput.hpp"
+
+static const uint32_t MICROS_PER_TICK = 20833; // 120 BPM at 24 PPQN
+static const uint32_t TICKS_PER_PULSE = MIDI_TICKS_PER_QUARTER_NOTE / 4;
+
+static Sequence sequence;
+static ClockEngine engine;
+static ClockInput *clockInput = nullptr; // Made fresh for each test, its queues can't be copied
+static std::mt19937 rng;
+static uint64_t nowMicros;
+static uint64_t nextTickMicros;
+
+// Runs the sequencer loop a millisecond at a time up to untilMicros. If
+// isTicking, MIDI clock ticks arrive on time give or take jitterMicros
+static void run(uint64_t untilMicros, bool isTicking, uint32_t jitterMicros = 0) {
+    while (nowMicros < untilMicros) {
+        nowMicros += 1000;
+
+        while (isTicking && nextTickMicros <= nowMicros) {
+            uint32_t jitter = rng() % (2 * jitterMicros + 1);
+            clockInput->onMidiMessage(CLOCK_TICK, nextTickMicros + jitter - jitterMicros);
+            nextTickMicros += MICROS_PER_TICK;
+        }
+
+        clockInput->update(engine, sequence, nowMicros);
+        engine.poll(nowMicros);
+    }
+
+    if (!isTicking) nextTickMicros = nowMicros;
+}
+
+static void sendTransport(ClockMessageType type) {
+    clockInput->onMidiMessage(type, nowMicros);
+    nextTickMicros = nowMicros + MICROS_PER_TICK;
+}
+
+void setUp(void) {
+    sequence = Sequence(4);
+    for (size_t i = 0; i < sequence.stageCount(); i++) {
+        sequence.getStage(i).pulseCount = 1;
+    }
+
+    delete clockInput;
+    clockInput = new ClockInput();
+    engine = ClockEngine();
+    rng.seed(1);
+    nowMicros = 0;
+    nextTickMicros = MICROS_PER_TICK;
+    engine.begin(&sequence, nowMicros);
+}
+
+void tearDown(void) {}
+
+void test_follows_a_jittery_clock(void) {
+    run(10000000, true, 1000);
+
+    TEST_ASSERT_EQUAL(CLOCK_MIDI, clockInput->getSource());
+    TEST_ASSERT_TRUE(clockInput->getTempoTracker().isLocked());
+    TEST_ASSERT_UINT32_WITHIN(MICROS_PER_TICK * TICKS_PER_PULSE / 100, MICROS_PER_TICK * TICKS_PER_PULSE, sequence.getMicrosPerPulse());
+
+    // Pulses land on every sixth tick from the first, wherever the jitter put them
+    uint64_t pulseTickMicros = (sequence.getLastPulseMicros() - MICROS_PER_TICK) % (MICROS_PER_TICK * TICKS_PER_PULSE);
+    uint64_t offsetMicros = min(pulseTickMicros, MICROS_PER_TICK * TICKS_PER_PULSE - pulseTickMicros);
+    TEST_ASSERT_LESS_THAN(MICROS_PER_TICK * TICKS_PER_PULSE / 50, offsetMicros);
+}
+
+void test_start_plays_from_the_first_stage_on_the_next_tick(void) {
+    run(2000000, true);
+    sendTransport(CLOCK_START);
+    run(nowMicros + 1000, false);
+
+    TEST_ASSERT_FALSE(engine.isRunning());
+
+    run(nowMicros + MICROS_PER_TICK, true);
+    TEST_ASSERT_TRUE(engine.isRunning());
+    TEST_ASSERT_EQUAL(0, sequence.indexOfActiveStage());
+
+    run(nowMicros + MICROS_PER_TICK * TICKS_PER_PULSE, true);
+    TEST_ASSERT_EQUAL(1, sequence.indexOfActiveStage());
+}
+
+void test_stop_holds_while_the_clock_runs_on_until_continue(void) {
+    run(2000000, true);
+    sendTransport(CLOCK_STOP);
+    size_t stoppedStageIndex = sequence.indexOfActiveStage();
+
+    // Plenty of DAWs keep sending clock while they're stopped
+    run(nowMicros + 3000000, true);
+    TEST_ASSERT_FALSE(engine.isRunning());
+    TEST_ASSERT_EQUAL(stoppedStageIndex, sequence.indexOfActiveStage());
+
+    sendTransport(CLOCK_CONTINUE);
+    run(nowMicros + MICROS_PER_TICK * (TICKS_PER_PULSE + 1), true);
+    TEST_ASSERT_TRUE(engine.isRunning());
+    TEST_ASSERT_EQUAL((stoppedStageIndex + 1) % sequence.stageCount(), sequence.indexOfActiveStage());
+}
+
+void test_stays_stopped_when_the_clock_stops_after_a_stop(void) {
+    run(2000000, true);
+    sendTransport(CLOCK_STOP);
+    uint32_t pulseIndex = sequence.getPulseIndex();
+
+    // Long past both timeouts
+    run(nowMicros + 5000000, false);
+
+    TEST_ASSERT_EQUAL(CLOCK_INTERNAL, clockInput->getSource());
+    TEST_ASSERT_FALSE(engine.isRunning());
+    TEST_ASSERT_EQUAL_UINT32(pulseIndex, sequence.getPulseIndex());
+
+    // It's started again by the next start
+    sendTransport(CLOCK_START);
+    run(nowMicros + MICROS_PER_TICK * 2, true);
+    TEST_ASSERT_TRUE(engine.isRunning());
+}
+
+void test_dropout_carries_on_at_the_last_tempo(void) {
+    run(2000000, true);
+    uint32_t pulseIndex = sequence.getPulseIndex();
+
+    run(nowMicros + 3000000, false);
+
+    TEST_ASSERT_EQUAL(CLOCK_INTERNAL, clockInput->getSource());
+    TEST_ASSERT_TRUE(engine.isRunning());
+    TEST_ASSERT_UINT32_WITHIN(MICROS_PER_TICK * TICKS_PER_PULSE / 100, MICROS_PER_TICK * TICKS_PER_PULSE, sequence.getMicrosPerPulse());
+    // 3 seconds at 8 pulses a second, give or take the ones either side of the dropout
+    TEST_ASSERT_UINT32_WITHIN(2, pulseIndex + 24, sequence.getPulseIndex());
+}
+
+void test_analog_edges_start_a_stopped_sequence(void) {
+    run(2000000, true);
+    sendTransport(CLOCK_STOP);
+    run(nowMicros + 5000000, false);
+    TEST_ASSERT_FALSE(engine.isRunning());
+
+    for (uint32_t i = 0; i < 8; i++) {
+        clockInput->onAnalogEdge(nowMicros);
+        run(nowMicros + 100000, false);
+    }
+
+    TEST_ASSERT_EQUAL(CLOCK_ANALOG, clockInput->getSource());
+    TEST_ASSERT_TRUE(engine.isRunning());
+    TEST_ASSERT_UINT32_WITHIN(1000, 100000, sequence.getMicrosPerPulse());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_follows_a_jittery_clock);
+    RUN_TEST(test_start_plays_from_the_first_stage_on_the_next_tick);
+    RUN_TEST(test_stop_holds_while_the_clock_runs_on_until_continue);
+    RUN_TEST(test_stays_stopped_when_the_clock_stops_after_a_stop);
+    RUN_TEST(test_dropout_carries_on_at_the_last_tempo);
+    RUN_TEST(test_analog_edges_start_a_stopped_sequence);
+    return UNITY_END();
+}
@@ -0,0 +1,145 @@
+// Makes enough random edits to go round the history's ring a few times, keeping
+// a copy of the sequence after each one, then undoes and redoes all the way
+#include <unity.h>
+#include <random>
+#include <vector>
+#include "Sequence.h"
+#include "DeltaHistory.hpp"
+
+static DeltaHistory history;
+static Sequence sequence;
+static std::vector<Sequence> kept; // The sequence after each commit, the first as it was reset
+
+// Everything the history keeps, laid out field by field so it can be compared byte for byte
+static std::vector<uint8_t> undoableBytes(Sequence &sequence) {
+    std::vector<uint8_t> bytes;
+    auto add = [&bytes](const void *data, size_t length) {
+        bytes.insert(bytes.end(), (const uint8_t*)data, (const uint8_t*)data + length);
+    };
+
+    size_t stageCount = sequence.stageCount();
+    add(&stageCount, sizeof(stageCount));
+    for (size_t i = 0; i < stageCount; i++) {
+        Stage &stage = sequence.getStage(i);
+        float output = stage.getBaseOutput();
+        uint16_t pipsBam = stage.pulsePipsAngle.getBam();
+        add(&stage.id, sizeof(stage.id));
+        add(&stage.pulseCount, sizeof(stage.pulseCount));
+        add(&stage.gateMode, sizeof(stage.gateMode));
+        add(&stage.isSkipped, sizeof(stage.isSkipped));
+        add(&stage.isSelected, sizeof(stage.isSelected));
+        add(&stage.shouldSlideIn, sizeof(stage.shouldSlideIn));
+        add(&stage.shouldArpeggiate, sizeof(stage.shouldArpeggiate));
+        add(&stage.arpSteps, sizeof(stage.arpSteps));
+        add(&stage.transpose, sizeof(stage.transpose));
+        add(&stage.arpStepWidth, sizeof(stage.arpStepWidth));
+        add(&pipsBam, sizeof(pipsBam));
+        add(&output, sizeof(output));
+    }
+
+    uint8_t divisions = sequence.scale.getDivisions();
+    uint32_t stepMask = sequence.scale.getStepMask();
+    add(&divisions, sizeof(divisions));
+    add(&stepMask, sizeof(stepMask));
+    return bytes;
+}
+
+static void assertSameAs(Sequence &expected) {
+    std::vector<uint8_t> expectedBytes = undoableBytes(expected);
+    std::vector<uint8_t> actualBytes = undoableBytes(sequence);
+    TEST_ASSERT_EQUAL(expectedBytes.size(), actualBytes.size());
+    TEST_ASSERT_EQUAL_MEMORY(expectedBytes.data(), actualBytes.data(), expectedBytes.size());
+}
+
+// One of the edits the interface makes, picked at random. Mostly small ones,
+// with the odd clone, delete or move to change the order
+static void randomEdit(std::mt19937 &rng) {
+    Stage &stage = sequence.getStage(rng() % sequence.stageCount());
+
+    switch (rng() % 10) {
+        case 0: stage.setOutput((rng() % 2000) / 1000.f); break;
+        case 1: stage.pulseCount = 1 + rng() % 8; break;
+        case 2: stage.gateMode = (GateMode)(rng() % 4); break;
+        case 3: stage.transpose = (int8_t)(rng() % 49) - 24; break;
+        case 4: stage.isSkipped = !stage.isSkipped; stage.isSelected = !stage.isSelected; break;
+        case 5: stage.pulsePipsAngle += Angle::fromBam(rng()); break;
+        case 6: sequence.scale.toggleStep(rng() % sequence.scale.getDivisions()); break;
+        case 7: sequence.cloneStage(rng() % sequence.stageCount()); break;
+        case 8: sequence.deleteStage(rng() % sequence.stageCount()); break;
+        default: sequence.moveStages(rng() & ((1 << sequence.stageCount()) - 1), (rng() % 2) ? 1 : -1); break;
+    }
+}
+
+void setUp(void) {
+    sequence = Sequence(6);
+    history.reset(sequence);
+    kept.clear();
+    kept.push_back(sequence);
+}
+
+void tearDown(void) {}
+
+void test_undo_and_redo_everything_after_the_ring_wraps(void) {
+    std::mt19937 rng(1);
+
+    // Until the steps dropped off the end add up to the ring going round a few times
+    while (history.getUndoStepCount() == 0 || kept.size() - 1 < 4u * history.getUndoStepCount()) {
+        randomEdit(rng);
+        if (rng() % 3 == 0) randomEdit(rng);
+        history.commit(sequence);
+
+        // Nothing's recorded for edits that put things back as they were
+        if (undoableBytes(sequence) != undoableBytes(kept.back())) {
+            kept.push_back(sequence);
+        }
+        TEST_ASSERT_LESS_OR_EQUAL(DELTA_HISTORY_ARENA_SIZE, history.getBytesUsed());
+    }
+
+    uint16_t stepCount = history.getUndoStepCount();
+
+    // Back through everything that's left, then no further
+    for (uint16_t step = 1; step <= stepCount; step++) {
+        TEST_ASSERT_TRUE(history.undo(sequence));
+        assertSameAs(kept[kept.size() - 1 - step]);
+    }
+    TEST_ASSERT_FALSE(history.undo(sequence));
+    assertSameAs(kept[kept.size() - 1 - stepCount]);
+
+    // And forwards again to the end
+    for (uint16_t step = stepCount; step > 0; step--) {
+        TEST_ASSERT_TRUE(history.redo(sequence));
+        assertSameAs(kept[kept.size() - step]);
+    }
+    TEST_ASSERT_FALSE(history.redo(sequence));
+    TEST_ASSERT_EQUAL_UINT(stepCount, history.getUndoStepCount());
+}
+
+void test_committing_after_undo_drops_the_redo_steps(void) {
+    for (uint32_t i = 0; i < 20; i++) {
+        sequence.getStage(0).setOutput(i / 20.f);
+        history.commit(sequence);
+        kept.push_back(sequence);
+    }
+
+    for (uint32_t i = 0; i < 5; i++) history.undo(sequence);
+    assertSameAs(kept[15]);
+    TEST_ASSERT_EQUAL_UINT(5, history.getRedoStepCount());
+
+    sequence.getStage(0).pulseCount = 7;
+    history.commit(sequence);
+    Sequence edited = sequence;
+    TEST_ASSERT_EQUAL_UINT(0, history.getRedoStepCount());
+    TEST_ASSERT_FALSE(history.redo(sequence));
+
+    history.undo(sequence);
+    assertSameAs(kept[15]);
+    history.redo(sequence);
+    assertSameAs(edited);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_undo_and_redo_everything_after_the_ring_wraps);
+    RUN_TEST(test_committing_after_undo_drops_the_redo_steps);
+    return UNITY_END();
+}
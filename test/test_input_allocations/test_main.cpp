@@ -0,0 +1,91 @@
+// Handling input has to stay off the heap. HostMain counts every allocation,
+// this plays random button holds and knob turns through the same globals
+#include <unity.h>
+#include <random>
+#include <vector>
+#include "MockHal.hpp"
+#include "UndoRedoManager.hpp"
+#include "InteractionManager.hpp"
+#include "ActiveButtons.hpp"
+#include "UserInputState.hpp"
+#include "LookaheadScheduler.hpp"
+#include "SequenceSnapshot.hpp"
+
+// From HostMain.cpp
+extern MockHal mockHal;
+extern UndoRedoManager undoRedoManager;
+extern InteractionManager interactionManager;
+extern LookaheadScheduler scheduler;
+extern SineCosinePot endlessPot;
+extern std::vector<Button> buttons;
+extern ActiveButtons activeButtons;
+extern uint32_t allocationCount;
+void turnKnob(float angle);
+
+static const Command commands[] = {PITCH, PULSES, GATEMODE, SELECT, MOVE, UNDO, REDO, ARP, CLONE, DELETE, QUANTIZER, SKIP, SLIDE};
+static SequenceSnapshot snapshot;
+
+void setUp(void) {
+    if (buttons.empty()) {
+        for (Command command : commands) {
+            buttons.push_back(Button(command));
+        }
+        for (uint8_t i = 0; i < buttons.size(); i++) {
+            activeButtons.setButton(i, &buttons[i]);
+        }
+    }
+}
+
+void tearDown(void) {}
+
+void test_handling_input_never_allocates(void) {
+    std::mt19937 rng(1);
+    Button *heldButtons[2] = {nullptr, nullptr};
+    uint64_t releaseMicros = 0;
+    float knobAngle = 0;
+    float knobSpeed = 0;
+    uint32_t editAllocationCount = 0;
+
+    // A minute of the sequencer loop
+    for (uint32_t loop = 0; loop < 60000; loop++) {
+        mockHal.advanceMicros(1000);
+
+        // Hold a button or two for a moment while turning the knob
+        if (heldButtons[0] == nullptr && rng() % 200 == 0) {
+            heldButtons[0] = &buttons[rng() % buttons.size()];
+            heldButtons[1] = (rng() % 4 == 0) ? &buttons[rng() % buttons.size()] : nullptr;
+            releaseMicros = mockHal.getMicros() + 100000 + rng() % 400000;
+            knobSpeed = ((rng() % 200) - 100) / 5000.f;
+        } else if (heldButtons[0] != nullptr && mockHal.getMicros() >= releaseMicros) {
+            heldButtons[0] = heldButtons[1] = nullptr;
+            knobSpeed = 0;
+        }
+
+        knobAngle += knobSpeed;
+        turnKnob(knobAngle);
+
+        uint32_t allocationsBefore = allocationCount;
+        endlessPot.update();
+
+        activeButtons.beginTick();
+        for (uint8_t i = 0; i < buttons.size(); i++) {
+            activeButtons.update(i, &buttons[i] == heldButtons[0] || &buttons[i] == heldButtons[1]);
+        }
+        activeButtons.endTick(mockHal.getMillis());
+
+        UserInputState userInputState = UserInputState(&endlessPot, activeButtons);
+        interactionManager.processInput(undoRedoManager, userInputState);
+        scheduler.plan(*undoRedoManager.getSequence(), mockHal.getMicros());
+        captureSnapshot(snapshot, undoRedoManager, interactionManager, activeButtons);
+        editAllocationCount += allocationCount - allocationsBefore;
+    }
+
+    TEST_ASSERT_GREATER_THAN(0, undoRedoManager.getUndoStepCount());
+    TEST_ASSERT_EQUAL_UINT32(0, editAllocationCount);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_handling_input_never_allocates);
+    return UNITY_END();
+}
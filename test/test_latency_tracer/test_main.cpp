@@ -0,0 +1,137 @@
+// Traces made up inputs through the tracer and reads the percentiles back out of its table
+#include <unity.h>
+#include <stdio.h>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "LatencyTracer.hpp"
+
+static LatencyTracer *tracer = nullptr; // Made fresh for each test, it holds atomics
+
+struct Row {
+    unsigned count;
+    unsigned long p50, p90, p99, max;
+};
+
+static Row readRow(LatencyStage stage, LatencySource source) {
+    char text[100];
+    Row row = {};
+    TEST_ASSERT_TRUE(tracer->formatTableRow(stage, source, text, sizeof(text)));
+
+    char stageName[10], sourceName[10];
+    TEST_ASSERT_EQUAL(7, sscanf(text, "%9s %9s %u %lu %lu %lu %lu", stageName, sourceName, &row.count, &row.p50, &row.p90, &row.p99, &row.max));
+    return row;
+}
+
+// An input at inputMicros that gets to stage latencyMicros later
+static void trace(LatencyStage stage, LatencySource source, uint64_t inputMicros, uint32_t latencyMicros) {
+    uint16_t id = tracer->begin(source, inputMicros);
+    tracer->record(stage, id, inputMicros + latencyMicros);
+}
+
+void setUp(void) {
+    delete tracer;
+    tracer = new LatencyTracer();
+}
+
+void tearDown(void) {}
+
+void test_percentiles_of_a_shuffled_hundred(void) {
+    std::vector<uint32_t> latencies;
+    for (uint32_t i = 1; i <= 100; i++) latencies.push_back(i * 10);
+    std::mt19937 rng(1);
+    std::shuffle(latencies.begin(), latencies.end(), rng);
+
+    for (uint32_t i = 0; i < latencies.size(); i++) {
+        trace(LATENCY_EDIT, LATENCY_KNOB, 1000 * i, latencies[i]);
+    }
+
+    Row row = readRow(LATENCY_EDIT, LATENCY_KNOB);
+    TEST_ASSERT_EQUAL_UINT(100, row.count);
+    TEST_ASSERT_EQUAL_UINT(510, row.p50);
+    TEST_ASSERT_EQUAL_UINT(910, row.p90);
+    TEST_ASSERT_EQUAL_UINT(1000, row.p99);
+    TEST_ASSERT_EQUAL_UINT(1000, row.max);
+}
+
+void test_ring_keeps_the_latest_samples(void) {
+    for (uint32_t i = 0; i < 300; i++) {
+        trace(LATENCY_GATE, LATENCY_BUTTON, 1000 * i, i);
+    }
+
+    // Only 172 to 299 are left
+    Row row = readRow(LATENCY_GATE, LATENCY_BUTTON);
+    TEST_ASSERT_EQUAL_UINT(LatencyTracer::SAMPLES_PER_STAGE, row.count);
+    TEST_ASSERT_EQUAL_UINT(300 - LatencyTracer::SAMPLES_PER_STAGE + 64, row.p50);
+    TEST_ASSERT_EQUAL_UINT(299, row.max);
+}
+
+void test_sources_and_stages_are_kept_apart(void) {
+    for (uint32_t i = 0; i < 10; i++) {
+        trace(LATENCY_SCREEN, LATENCY_BUTTON, 1000 * i, 5000);
+        trace(LATENCY_SCREEN, LATENCY_KNOB, 1000 * i, 20000);
+    }
+
+    TEST_ASSERT_EQUAL_UINT(5000, readRow(LATENCY_SCREEN, LATENCY_BUTTON).max);
+    TEST_ASSERT_EQUAL_UINT(20000, readRow(LATENCY_SCREEN, LATENCY_KNOB).p50);
+    TEST_ASSERT_EQUAL_UINT(10, readRow(LATENCY_SCREEN, LATENCY_KNOB).count);
+
+    char text[100];
+    TEST_ASSERT_FALSE(tracer->formatTableRow(LATENCY_MIDI, LATENCY_KNOB, text, sizeof(text)));
+
+    tracer->reset();
+    TEST_ASSERT_FALSE(tracer->formatTableRow(LATENCY_SCREEN, LATENCY_BUTTON, text, sizeof(text)));
+}
+
+void test_forgotten_ids_arent_recorded(void) {
+    uint16_t oldId = tracer->begin(LATENCY_BUTTON, 0);
+    for (uint16_t i = 0; i < LatencyTracer::RECENT_TRACES; i++) {
+        tracer->begin(LATENCY_KNOB, 0);
+    }
+
+    char text[100];
+    tracer->record(LATENCY_EDIT, oldId, 100);
+    tracer->record(LATENCY_EDIT, 0, 100);
+    TEST_ASSERT_FALSE(tracer->formatTableRow(LATENCY_EDIT, LATENCY_BUTTON, text, sizeof(text)));
+    TEST_ASSERT_FALSE(tracer->formatTableRow(LATENCY_EDIT, LATENCY_KNOB, text, sizeof(text)));
+}
+
+void test_ids_skip_zero_when_they_wrap(void) {
+    for (uint32_t i = 0; i < 70000; i++) {
+        TEST_ASSERT_NOT_EQUAL(0, tracer->begin(LATENCY_KNOB, i));
+    }
+
+    uint16_t id = tracer->getLatestId();
+    tracer->record(LATENCY_EDIT, id, 70000);
+    TEST_ASSERT_EQUAL_UINT(1, readRow(LATENCY_EDIT, LATENCY_KNOB).max);
+}
+
+void test_record_oldest_takes_the_longest_wait(void) {
+    uint16_t beforeId = tracer->getLatestId();
+    tracer->begin(LATENCY_KNOB, 1000);
+    tracer->begin(LATENCY_KNOB, 2000);
+    uint16_t upToId = tracer->begin(LATENCY_KNOB, 3000);
+
+    tracer->recordOldest(LATENCY_RENDER, beforeId, upToId, 10000);
+    Row row = readRow(LATENCY_RENDER, LATENCY_KNOB);
+    TEST_ASSERT_EQUAL_UINT(1, row.count);
+    TEST_ASSERT_EQUAL_UINT(9000, row.max);
+
+    // Further back than it remembers only goes as far as it can
+    for (uint16_t i = 0; i < 200; i++) {
+        upToId = tracer->begin(LATENCY_KNOB, 4000 + i);
+    }
+    tracer->recordOldest(LATENCY_SCREEN, beforeId, upToId, 10000);
+    TEST_ASSERT_EQUAL_UINT(10000 - (4000 + 200 - LatencyTracer::RECENT_TRACES), readRow(LATENCY_SCREEN, LATENCY_KNOB).max);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_percentiles_of_a_shuffled_hundred);
+    RUN_TEST(test_ring_keeps_the_latest_samples);
+    RUN_TEST(test_sources_and_stages_are_kept_apart);
+    RUN_TEST(test_forgotten_ids_arent_recorded);
+    RUN_TEST(test_ids_skip_zero_when_they_wrap);
+    RUN_TEST(test_record_oldest_takes_the_longest_wait);
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+// Plays the scheduler's queue in virtual time, the way the alarm would on the board
+#include <unity.h>
+#include "Sequence.h"
+#include "LookaheadScheduler.hpp"
+#include "ClockEngine.hpp"
+
+static Sequence sequence;
+static LookaheadScheduler *scheduler = nullptr; // Made fresh for each test, its queue can't be copied
+static ClockEngine engine;
+static uint64_t nowMicros;
+static bool isGateOpen;
+static uint32_t gateOnCount;
+
+static void onEvent(const SequenceEvent &event) {
+    if (event.type == EVENT_GATE_ON) {
+        isGateOpen = true;
+        gateOnCount++;
+    } else if (event.type == EVENT_GATE_OFF || event.type == EVENT_STOP) {
+        isGateOpen = false;
+    }
+}
+
+// Handles everything that comes due up to untilMicros
+static void runUntil(uint64_t untilMicros) {
+    while (true) {
+        uint64_t dueMicros = max(nowMicros, min(sequence.getNextPulseMicros(), scheduler->getNextEventMicros()));
+        if (dueMicros > untilMicros) break;
+
+        nowMicros = dueMicros;
+        engine.poll(nowMicros);
+    }
+
+    nowMicros = untilMicros;
+}
+
+// A millisecond of the sequencer loop
+static void runMillisecond() {
+    runUntil(nowMicros + 1000);
+    scheduler->plan(sequence, nowMicros);
+}
+
+static void setAllGateModes(GateMode gateMode) {
+    for (size_t i = 0; i < sequence.stageCount(); i++) {
+        sequence.getStage(i).gateMode = gateMode;
+    }
+    sequence.markEdited();
+}
+
+void setUp(void) {
+    // Every stage gates every pulse, with as many clocks as a pulse can have
+    sequence = Sequence(MAX_STAGES);
+    for (size_t i = 0; i < sequence.stageCount(); i++) {
+        sequence.getStage(i).pulseCount = 2;
+        sequence.getStage(i).setOutput(i / 8.f - 1);
+    }
+    setAllGateModes(EACH);
+    sequence.setBpm(240);
+
+    delete scheduler;
+    scheduler = new LookaheadScheduler(MAX_LOOKAHEAD_PULSES);
+    engine = ClockEngine();
+    nowMicros = 0;
+    isGateOpen = false;
+    gateOnCount = 0;
+    engine.setScheduler(scheduler, onEvent);
+    engine.begin(&sequence, nowMicros);
+}
+
+void tearDown(void) {}
+
+void test_worst_case_replans_fit_in_the_queue(void) {
+    // An edit to the next stage every millisecond throws the whole plan away each time
+    for (uint32_t i = 0; i < 10000; i++) {
+        sequence.getStage(sequence.getNextStageIndex()).setOutput((i % 16) / 8.f - 1);
+        sequence.markEdited();
+        runMillisecond();
+    }
+
+    TEST_ASSERT_GREATER_THAN(5000, scheduler->getReplanCount());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler->getDroppedCount());
+    TEST_ASSERT_GREATER_THAN(0, gateOnCount);
+}
+
+void test_gate_follows_the_sequence(void) {
+    // Checked at a quarter of the way through each pulse, well clear of both gate edges
+    uint32_t checkedPulses = 0;
+    for (uint32_t i = 0; i < 5000; i++) {
+        if (i % 250 == 0) {
+            sequence.getStage(i % sequence.stageCount()).gateMode = (GateMode)(i / 250 % 4);
+            sequence.markEdited();
+        }
+        runMillisecond();
+
+        uint32_t phase = sequence.getPulsePhase(nowMicros);
+        if (phase > PULSE_PHASE_ONE / 8 && phase < PULSE_PHASE_ONE / 2) {
+            sequence.updateOutputs(nowMicros);
+            TEST_ASSERT_EQUAL(sequence.getGate(), isGateOpen);
+            checkedPulses++;
+        }
+    }
+
+    TEST_ASSERT_GREATER_THAN(100, checkedPulses);
+}
+
+void test_nothing_is_replanned_without_an_edit(void) {
+    runMillisecond();
+    uint32_t replanCount = scheduler->getReplanCount();
+
+    for (uint32_t i = 0; i < 2000; i++) {
+        runMillisecond();
+    }
+    TEST_ASSERT_EQUAL_UINT32(replanCount, scheduler->getReplanCount());
+
+    // The stage after next is already planned, so changing it starts over
+    sequence.getStage(sequence.getNextStageIndex()).setOutput(0.5f);
+    sequence.markEdited();
+    runMillisecond();
+    TEST_ASSERT_EQUAL_UINT32(replanCount + 1, scheduler->getReplanCount());
+}
+
+void test_gate_closes_when_a_gate_off_is_dropped(void) {
+    while (!isGateOpen) {
+        runMillisecond();
+    }
+
+    // Replanning over and over with nothing dispatched fills the queue
+    setAllGateModes(NONE);
+    for (uint32_t i = 0; i < 32; i++) {
+        sequence.getActiveStage().setOutput(i / 32.f);
+        sequence.markEdited();
+        scheduler->plan(sequence, nowMicros);
+    }
+    TEST_ASSERT_GREATER_THAN(0, scheduler->getDroppedCount());
+
+    for (uint32_t i = 0; i < 10; i++) {
+        runMillisecond();
+    }
+    TEST_ASSERT_FALSE(isGateOpen);
+}
+
+void test_old_plans_stay_stale_however_many_replans_follow(void) {
+    scheduler->plan(sequence, nowMicros);
+    TEST_ASSERT_NOT_EQUAL(UINT64_MAX, scheduler->getNextEventMicros());
+
+    // More plans than a byte can count, none of them with anything to queue
+    for (uint32_t i = 0; i < 256; i++) {
+        scheduler->clear();
+    }
+    scheduler->dispatch(UINT64_MAX, onEvent);
+
+    TEST_ASSERT_EQUAL_UINT32(0, gateOnCount);
+    TEST_ASSERT_EQUAL(UINT64_MAX, scheduler->getNextEventMicros());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_worst_case_replans_fit_in_the_queue);
+    RUN_TEST(test_gate_follows_the_sequence);
+    RUN_TEST(test_nothing_is_replanned_without_an_edit);
+    RUN_TEST(test_gate_closes_when_a_gate_off_is_dropped);
+    RUN_TEST(test_old_plans_stay_stale_however_many_replans_follow);
+    return UNITY_END();
+}
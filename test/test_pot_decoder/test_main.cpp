@@ -0,0 +1,142 @@
+// Replays a recorded endless pot trace through the decoder, checking the
+// angles it finds and what calibration makes of the tracks
+#include <unity.h>
+#include <random>
+#include "MockHal.hpp"
+#include "PotTrace.hpp"
+#include "sineCosinePot.h"
+#include "CalibrationStore.hpp"
+
+// From HostMain.cpp
+extern MockHal mockHal;
+
+static const uint32_t CALIBRATION_READINGS = 1000; // 4 seconds, more than a turn each way
+static std::vector<PotTraceReading> trace;
+
+static void feed(SineCosinePot &pot, const PotTraceReading &reading) {
+    mockHal.setAnalog(26, reading.adc[0]);
+    mockHal.setAnalog(27, reading.adc[1]);
+    mockHal.advanceMicros(POT_TRACE_READING_MICROS);
+    pot.update();
+}
+
+static PotCalibration calibrate(uint32_t readings) {
+    SineCosinePot pot = SineCosinePot(0, 1);
+    pot.beginCalibration();
+    for (uint32_t i = 0; i < readings; i++) feed(pot, trace[i]);
+    TEST_ASSERT_TRUE(pot.endCalibration());
+    return pot.getCalibration();
+}
+
+// Furthest the pot gets from the knob after the calibration stretch. The
+// decoder's zero is its own, so the mean offset's taken off first, averaged
+// around the first one so it doesn't matter if they straddle a half turn
+static float maxErrorDegrees(SineCosinePot &pot) {
+    std::vector<Angle> decoded;
+    for (const PotTraceReading &reading : trace) {
+        feed(pot, reading);
+        decoded.push_back(pot.getAngle());
+    }
+
+    Angle firstOffset = Angle::fromBam(Angle::fromDegrees(trace[CALIBRATION_READINGS].degrees).deltaTo(decoded[CALIBRATION_READINGS]));
+    double totalOffset = 0;
+    for (uint32_t i = CALIBRATION_READINGS; i < trace.size(); i++) {
+        totalOffset += (Angle::fromDegrees(trace[i].degrees) + firstOffset).degreesTo(decoded[i]);
+    }
+    Angle offset = firstOffset + Angle::fromDegrees(totalOffset / (trace.size() - CALIBRATION_READINGS));
+
+    float maxError = 0;
+    for (uint32_t i = CALIBRATION_READINGS; i < trace.size(); i++) {
+        maxError = std::max(maxError, fabsf((Angle::fromDegrees(trace[i].degrees) + offset).degreesTo(decoded[i])));
+    }
+    return maxError;
+}
+
+void setUp(void) {
+    if (trace.empty()) {
+        std::mt19937 rng(1);
+        trace = recordPotTrace(rng, 20);
+    }
+    mockHal.setMicros(0);
+}
+
+void tearDown(void) {}
+
+// The trace's tracks swing 250-3650 and 300-4000 of 4095, which is 4000-58400
+// and 4800-64000 once the filter's brought them to 16 bits
+void test_calibration_finds_each_tracks_reach(void) {
+    PotCalibration calibration = calibrate(CALIBRATION_READINGS);
+
+    TEST_ASSERT_UINT16_WITHIN(200, 4000, calibration.trackMin[0]);
+    TEST_ASSERT_UINT16_WITHIN(200, 58400, calibration.trackMax[0]);
+    TEST_ASSERT_UINT16_WITHIN(200, 4800, calibration.trackMin[1]);
+    TEST_ASSERT_UINT16_WITHIN(200, 64000, calibration.trackMax[1]);
+}
+
+void test_calibration_wants_the_pot_turned_round(void) {
+    SineCosinePot pot = SineCosinePot(0, 1);
+    PotCalibration before = pot.getCalibration();
+
+    // A tenth of a second where the knob turns back, past the filter's start
+    // up, doesn't get either track from end to end
+    pot.beginCalibration();
+    for (uint32_t i = 1250; i < 1275; i++) feed(pot, trace[i]);
+
+    TEST_ASSERT_FALSE(pot.endCalibration());
+    TEST_ASSERT_FALSE(pot.isCalibrating());
+    TEST_ASSERT_EQUAL_MEMORY(&before, &pot.getCalibration(), sizeof(PotCalibration));
+}
+
+void test_calibration_survives_the_store(void) {
+    PotCalibration calibration = calibrate(CALIBRATION_READINGS);
+    CalibrationStore store;
+    store.begin();
+    store.savePot(calibration);
+
+    PotCalibration loaded;
+    TEST_ASSERT_TRUE(store.loadPot(loaded));
+    TEST_ASSERT_EQUAL_MEMORY(&calibration, &loaded, sizeof(PotCalibration));
+}
+
+void test_calibrated_angle_follows_the_knob(void) {
+    SineCosinePot pot = SineCosinePot(0, 1);
+    pot.setCalibration(calibrate(CALIBRATION_READINGS));
+
+    TEST_ASSERT_LESS_THAN_FLOAT(0.1f, maxErrorDegrees(pot));
+}
+
+// Without calibration the tracks' offsets and gains wobble the angle, but it still goes the right way
+void test_uncalibrated_angle_is_rougher(void) {
+    SineCosinePot calibrated = SineCosinePot(0, 1);
+    calibrated.setCalibration(calibrate(CALIBRATION_READINGS));
+    SineCosinePot uncalibrated = SineCosinePot(0, 1);
+
+    float uncalibratedError = maxErrorDegrees(uncalibrated);
+    TEST_ASSERT_LESS_THAN_FLOAT(8.f, uncalibratedError);
+    TEST_ASSERT_GREATER_THAN_FLOAT(10 * maxErrorDegrees(calibrated), uncalibratedError);
+}
+
+void test_velocity_follows_the_knob(void) {
+    SineCosinePot pot = SineCosinePot(0, 1);
+    pot.setCalibration(calibrate(CALIBRATION_READINGS));
+
+    double totalError = 0;
+    for (uint32_t i = 0; i < trace.size(); i++) {
+        feed(pot, trace[i]);
+        if (i >= CALIBRATION_READINGS) totalError += fabsf(pot.getVelocity() - trace[i].degreesPerSecond);
+    }
+
+    // It's smoothed, so it lags a little behind a knob that peaks at 400 degrees a second
+    TEST_ASSERT_LESS_THAN_FLOAT(20.f, totalError / (trace.size() - CALIBRATION_READINGS));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_calibration_finds_each_tracks_reach);
+    RUN_TEST(test_calibration_wants_the_pot_turned_round);
+    RUN_TEST(test_calibration_survives_the_store);
+    RUN_TEST(test_calibrated_angle_follows_the_knob);
+    RUN_TEST(test_uncalibrated_angle_is_rougher);
+    RUN_TEST(test_velocity_follows_the_knob);
+    return UNITY_END();
+}
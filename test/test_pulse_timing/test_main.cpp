@@ -0,0 +1,80 @@
+// Runs the clock engine for long stretches of virtual time and checks the
+// pulses are still where exact arithmetic puts them
+#include <unity.h>
+#include "Sequence.h"
+#include "ClockEngine.hpp"
+
+static const uint64_t MICROS_PER_DAY = 24ull * 60 * 60 * 1000000;
+
+static Sequence sequence;
+static ClockEngine engine;
+
+// Handles every pulse boundary up to untilMicros, each right when it's due
+static void runUntil(uint64_t untilMicros) {
+    while (sequence.getNextPulseMicros() <= untilMicros) {
+        engine.poll(sequence.getNextPulseMicros());
+    }
+}
+
+// How far the last pulse is from where it should be, for a tempo that doesn't
+// divide into whole microseconds. 60000000 / bpm / subdivision, multiplied out
+static double driftMicros(uint64_t startMicros, uint32_t bpm, uint32_t pulseCount) {
+    double exactMicros = startMicros + (double)pulseCount * 60000000 / (bpm * sequence.getSubdivision());
+    return (double)sequence.getLastPulseMicros() - exactMicros;
+}
+
+void setUp(void) {
+    sequence = Sequence(4);
+    engine = ClockEngine();
+}
+
+void tearDown(void) {}
+
+void test_a_day_of_pulses_drifts_less_than_a_microsecond(void) {
+    sequence.setBpm(133); // 112781.95... microseconds a pulse
+    engine.begin(&sequence, 0);
+
+    runUntil(MICROS_PER_DAY);
+
+    TEST_ASSERT_GREATER_THAN(700000, sequence.getPulseIndex());
+    TEST_ASSERT_FLOAT_WITHIN(1.0, 0, driftMicros(0, 133, sequence.getPulseIndex()));
+    TEST_ASSERT_GREATER_THAN(MICROS_PER_DAY, sequence.getNextPulseMicros());
+}
+
+void test_pulses_keep_going_after_weeks_of_uptime(void) {
+    // Past 2^40 microseconds, where shifting the time into fixed point would overflow
+    uint64_t startMicros = 30 * MICROS_PER_DAY;
+    sequence.setBpm(97);
+    engine.begin(&sequence, startMicros);
+
+    runUntil(startMicros + MICROS_PER_DAY);
+
+    TEST_ASSERT_FLOAT_WITHIN(1.0, 0, driftMicros(startMicros, 97, sequence.getPulseIndex()));
+    TEST_ASSERT_GREATER_THAN(startMicros + MICROS_PER_DAY, sequence.getNextPulseMicros());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(startMicros + MICROS_PER_DAY, sequence.getLastPulseMicros());
+}
+
+void test_syncing_to_an_unhandled_pulse_makes_it_due(void) {
+    sequence.setBpm(133);
+    engine.begin(&sequence, 0);
+    runUntil(MICROS_PER_DAY);
+
+    // An external clock says the next pulse is now, a little before it was due
+    uint64_t pulseMicros = sequence.getNextPulseMicros() - 10;
+    uint32_t pulseIndex = sequence.getPulseIndex();
+    sequence.syncPulseTiming(pulseMicros, 100000.5f);
+
+    TEST_ASSERT_EQUAL_UINT64(pulseMicros, sequence.getNextPulseMicros());
+    runUntil(pulseMicros);
+    TEST_ASSERT_EQUAL_UINT32(pulseIndex + 1, sequence.getPulseIndex());
+    TEST_ASSERT_EQUAL_UINT64(pulseMicros, sequence.getLastPulseMicros());
+    TEST_ASSERT_EQUAL_UINT64(pulseMicros + 100001, sequence.getNextPulseMicros());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_a_day_of_pulses_drifts_less_than_a_microsecond);
+    RUN_TEST(test_pulses_keep_going_after_weeks_of_uptime);
+    RUN_TEST(test_syncing_to_an_unhandled_pulse_makes_it_due);
+    return UNITY_END();
+}
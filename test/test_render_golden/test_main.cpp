@@ -0,0 +1,33 @@
+// Plays the render check's scripted session and compares each scene's frame
+// with the golden images next to this file. After a change that's meant to
+// look different, record them again with
+//     program render test/test_render_golden/golden update
+// and look over what changed before committing them
+#include <unity.h>
+#include <string>
+#include "RenderCheck.hpp"
+
+// From HostMain.cpp
+void beginHost();
+
+// Found from this file rather than the working directory, so it doesn't matter where the test's run from
+static std::string goldenDir() {
+    std::string path = __FILE__;
+    return path.substr(0, path.find_last_of("/\\") + 1) + "golden";
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Any scene that differs leaves a .actual.ppm next to its golden image
+void test_scenes_match_the_golden_images(void) {
+    beginHost();
+    TEST_ASSERT_EQUAL_MESSAGE(0, runRenderCheck(goldenDir().c_str(), false), "Frames differ from the golden images");
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_scenes_match_the_golden_images);
+    return UNITY_END();
+}
@@ -0,0 +1,140 @@
+// Checks the scale's lookup tables against working it out the slow way,
+// for every scale in the library and notes either side of zero
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Scale.hpp"
+
+static ScaleLibrary library;
+
+static bool isInScale(Scale &scale, int step) {
+    int divisions = scale.getDivisions();
+    return scale.hasStep(((step % divisions) + divisions) % divisions);
+}
+
+// Looks outwards from step, down first so ties go down
+static int slowNearest(Scale &scale, int step) {
+    for (int distance = 0; ; distance++) {
+        if (isInScale(scale, step - distance)) return step - distance;
+        if (isInScale(scale, step + distance)) return step + distance;
+    }
+}
+
+static int slowQuantize(Scale &scale, int step, int transposeDegrees) {
+    if (scale.getDegreeCount() == 0) return step;
+
+    int quantized = slowNearest(scale, step);
+    int direction = (transposeDegrees > 0) ? 1 : -1;
+    for (int i = 0; i < abs(transposeDegrees); i++) {
+        do { quantized += direction; } while (!isInScale(scale, quantized));
+    }
+    return quantized;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_every_library_scale_matches_the_slow_way(void) {
+    for (size_t i = 0; i < library.size(); i++) {
+        Scale scale = library.getScale(i);
+
+        for (int step = -100; step <= 100; step++) {
+            for (int transpose = -20; transpose <= 20; transpose++) {
+                if (scale.quantize(step, transpose) != slowQuantize(scale, step, transpose)) {
+                    char message[80];
+                    snprintf(message, sizeof(message), "%s, step %d, transpose %d", library.getName(i), step, transpose);
+                    TEST_FAIL_MESSAGE(message);
+                }
+            }
+        }
+    }
+}
+
+void test_major_ties_go_down(void) {
+    Scale major = Scale(12, 0xAB5);
+
+    TEST_ASSERT_EQUAL_INT(0, major.quantize(1)); // C# to C rather than D
+    TEST_ASSERT_EQUAL_INT(5, major.quantize(6)); // F# to F rather than G
+    TEST_ASSERT_EQUAL_INT(-1, major.quantize(-1)); // The B below
+    TEST_ASSERT_EQUAL_INT(-12, major.quantize(-11)); // The C an octave down
+}
+
+void test_major_transposes_by_degrees(void) {
+    Scale major = Scale(12, 0xAB5);
+
+    TEST_ASSERT_EQUAL_INT(2, major.quantize(0, 1));
+    TEST_ASSERT_EQUAL_INT(12, major.quantize(0, 7));
+    TEST_ASSERT_EQUAL_INT(-1, major.quantize(0, -1));
+    TEST_ASSERT_EQUAL_INT(-12, major.quantize(0, -7));
+    TEST_ASSERT_EQUAL_INT(-13, major.quantize(0, -8));
+    TEST_ASSERT_EQUAL_INT(26, major.quantize(1, 15)); // From the C it snaps to
+}
+
+// Steps 0, 3, 6, 8, 11, 14 and 17 of 19
+void test_19_tet_major(void) {
+    Scale scale = Scale(19, 0x24949);
+
+    TEST_ASSERT_EQUAL_INT(7, scale.getDegreeCount());
+    TEST_ASSERT_EQUAL_INT(6, scale.quantize(7)); // Between 6 and 8, ties go down
+    TEST_ASSERT_EQUAL_INT(19, scale.quantize(0, 7));
+    TEST_ASSERT_EQUAL_INT(-2, scale.quantize(0, -1));
+    TEST_ASSERT_EQUAL_INT(-21, scale.quantize(-20)); // 18 of the octave below, 17 and 19 tie
+    TEST_ASSERT_EQUAL_INT(-38 + 8, scale.quantize(-1, -10));
+}
+
+// Steps 0, 4, 7, 10, 14, 18 and 21 of 24, so quarter tones
+void test_24_tet_rast(void) {
+    Scale scale = Scale(24, 0x244491);
+
+    TEST_ASSERT_EQUAL_INT(7, scale.getDegreeCount());
+    TEST_ASSERT_EQUAL_INT(-3, scale.quantize(-2));
+    TEST_ASSERT_EQUAL_INT(-6, scale.quantize(-5)); // From 19 of the octave below, 18 is nearer than 21
+    TEST_ASSERT_EQUAL_INT(4, scale.quantize(-3, 2)); // Up past the octave
+    TEST_ASSERT_EQUAL_INT(-24 - 10, scale.quantize(0, -10));
+}
+
+void test_midi_notes_go_to_the_nearest_semitone(void) {
+    Scale chromatic = Scale(12, 0xFFF);
+    TEST_ASSERT_EQUAL_UINT8(60, chromatic.getMidiNote(0));
+    TEST_ASSERT_EQUAL_UINT8(72, chromatic.getMidiNote(1));
+    TEST_ASSERT_EQUAL_UINT8(48, chromatic.getMidiNote(-1));
+    TEST_ASSERT_EQUAL_UINT8(0, chromatic.getMidiNote(-10));
+    TEST_ASSERT_EQUAL_UINT8(127, chromatic.getMidiNote(10));
+
+    // 7 of 24 is a quarter tone over a D, which rounds up to D#
+    Scale rast = Scale(24, 0x244491);
+    TEST_ASSERT_EQUAL_UINT8(64, rast.getMidiNote(7 / 24.f));
+    TEST_ASSERT_EQUAL_UINT8(72, Scale(19, 0x24949).getMidiNote(1));
+}
+
+void test_empty_scales_leave_notes_alone(void) {
+    Scale empty = Scale(19, 0);
+
+    TEST_ASSERT_EQUAL_INT(0, empty.getDegreeCount());
+    TEST_ASSERT_EQUAL_INT(-7, empty.quantize(-7, 3));
+    TEST_ASSERT_EQUAL_INT(25, empty.quantize(25));
+}
+
+void test_toggling_a_step_rebuilds_the_tables(void) {
+    Scale scale = Scale(12, 0x001);
+    TEST_ASSERT_EQUAL_INT(12, scale.quantize(7));
+
+    scale.toggleStep(7);
+    TEST_ASSERT_EQUAL_INT(7, scale.quantize(7));
+    TEST_ASSERT_EQUAL_INT(-5, scale.quantize(0, -1));
+    TEST_ASSERT_EQUAL_INT(slowQuantize(scale, -30, -3), scale.quantize(-30, -3));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_library_scale_matches_the_slow_way);
+    RUN_TEST(test_major_ties_go_down);
+    RUN_TEST(test_major_transposes_by_degrees);
+    RUN_TEST(test_19_tet_major);
+    RUN_TEST(test_24_tet_rast);
+    RUN_TEST(test_midi_notes_go_to_the_nearest_semitone);
+    RUN_TEST(test_empty_scales_leave_notes_alone);
+    RUN_TEST(test_toggling_a_step_rebuilds_the_tables);
+    return UNITY_END();
+}
@@ -0,0 +1,237 @@
+// Rearranges the sequence's stages and checks the active stage stays the one that's playing
+#include <unity.h>
+#include <random>
+#include <vector>
+#include "Sequence.h"
+
+static Sequence sequence;
+
+// Ids in stage order, which start out the same as the indexes
+static std::vector<uint16_t> ids() {
+    std::vector<uint16_t> result;
+    for (size_t i = 0; i < sequence.stageCount(); i++) {
+        result.push_back(sequence.getStage(i).id);
+    }
+    return result;
+}
+
+// Plays on until index is the active stage, every stage is a single pulse
+static void makeActive(size_t index) {
+    while (sequence.indexOfActiveStage() != index) {
+        sequence.advancePulse();
+    }
+}
+
+static void assertNextStageFollowsActive() {
+    TEST_ASSERT_EQUAL((sequence.indexOfActiveStage() + 1) % sequence.stageCount(), sequence.getNextStageIndex());
+}
+
+void setUp(void) {
+    sequence = Sequence(8);
+    for (size_t i = 0; i < sequence.stageCount(); i++) {
+        sequence.getStage(i).pulseCount = 1;
+    }
+}
+
+void tearDown(void) {}
+
+void test_insert_before_the_active_stage_moves_it_along(void) {
+    makeActive(3);
+    sequence.insertStage(1, Stage(8));
+
+    TEST_ASSERT_EQUAL(9, sequence.stageCount());
+    TEST_ASSERT_EQUAL(4, sequence.indexOfActiveStage());
+    TEST_ASSERT_EQUAL_UINT16(3, sequence.getActiveStage().id);
+    TEST_ASSERT_EQUAL_UINT16(8, sequence.getStage(1).id);
+    assertNextStageFollowsActive();
+}
+
+// The new stage goes in front of the active one, which carries on playing
+void test_insert_at_the_active_stage_keeps_it_active(void) {
+    makeActive(3);
+    sequence.insertStage(3, Stage(8));
+
+    TEST_ASSERT_EQUAL(4, sequence.indexOfActiveStage());
+    TEST_ASSERT_EQUAL_UINT16(3, sequence.getActiveStage().id);
+    TEST_ASSERT_EQUAL_UINT16(8, sequence.getStage(3).id);
+    assertNextStageFollowsActive();
+}
+
+void test_insert_after_the_active_stage_leaves_it(void) {
+    makeActive(3);
+    sequence.insertStage(4, Stage(8));
+    sequence.insertStage(sequence.stageCount(), Stage(9));
+
+    TEST_ASSERT_EQUAL(3, sequence.indexOfActiveStage());
+    TEST_ASSERT_EQUAL_UINT16(8, sequence.getStage(sequence.getNextStageIndex()).id);
+    TEST_ASSERT_EQUAL_UINT16(9, sequence.getStage(9).id);
+}
+
+void test_insert_into_a_full_sequence_does_nothing(void) {
+    while (sequence.stageCount() < MAX_STAGES) {
+        sequence.cloneStage(0);
+    }
+    makeActive(5);
+    std::vector<uint16_t> before = ids();
+
+    sequence.insertStage(0, Stage(3));
+    TEST_ASSERT_TRUE(before == ids());
+    TEST_ASSERT_EQUAL(5, sequence.indexOfActiveStage());
+    TEST_ASSERT_EQUAL(NO_STAGE, sequence.cloneStage(0));
+}
+
+void test_delete_before_the_active_stage_moves_it_back(void) {
+    makeActive(5);
+    sequence.deleteStage(2);
+
+    TEST_ASSERT_EQUAL(7, sequence.stageCount());
+    TEST_ASSERT_EQUAL(4, sequence.indexOfActiveStage());
+    TEST_ASSERT_EQUAL_UINT16(5, sequence.getActiveStage().id);
+    assertNextStageFollowsActive();
+}
+
+// The stage after it takes over, or the one before if it was last
+void test_delete_the_active_stage(void) {
+    makeActive(5);
+    sequence.deleteStage(5);
+    TEST_ASSERT_EQUAL(5, sequence.indexOfActiveStage());
+    TEST_ASSERT_EQUAL_UINT16(6, sequence.getActiveStage().id);
+    assertNextStageFollowsActive();
+
+    makeActive(6);
+    sequence.deleteStage(6);
+    TEST_ASSERT_EQUAL(5, sequence.indexOfActiveStage());
+    TEST_ASSERT_EQUAL_UINT16(6, sequence.getActiveStage().id);
+    assertNextStageFollowsActive();
+}
+
+void test_delete_after_the_active_stage_leaves_it(void) {
+    makeActive(2);
+    sequence.deleteStage(3);
+
+    TEST_ASSERT_EQUAL(2, sequence.indexOfActiveStage());
+    TEST_ASSERT_EQUAL_UINT16(4, sequence.getStage(sequence.getNextStageIndex()).id);
+}
+
+void test_the_last_stage_cant_be_deleted(void) {
+    while (sequence.stageCount() > 1) {
+        sequence.deleteStage(sequence.stageCount() - 1);
+    }
+    sequence.deleteStage(0);
+
+    TEST_ASSERT_EQUAL(1, sequence.stageCount());
+    TEST_ASSERT_EQUAL(0, sequence.indexOfActiveStage());
+    TEST_ASSERT_EQUAL(0, sequence.getNextStageIndex());
+}
+
+void test_move_one_stage_along(void) {
+    makeActive(2);
+    sequence.moveStages(1 << 2, 1);
+
+    std::vector<uint16_t> expected = {0, 1, 3, 2, 4, 5, 6, 7};
+    TEST_ASSERT_TRUE(expected == ids());
+    TEST_ASSERT_EQUAL(3, sequence.indexOfActiveStage());
+    assertNextStageFollowsActive();
+
+    // And back, with the active stage the one pushed out of the way
+    makeActive(2);
+    sequence.moveStages(1 << 3, -1);
+    expected = {0, 1, 2, 3, 4, 5, 6, 7};
+    TEST_ASSERT_TRUE(expected == ids());
+    TEST_ASSERT_EQUAL(3, sequence.indexOfActiveStage());
+    TEST_ASSERT_EQUAL_UINT16(3, sequence.getActiveStage().id);
+}
+
+// Off one end and on at the other. Round the ring it's the same order as
+// moving it along one, the stage it passed just fills the gap at the end
+void test_moves_wrap_round(void) {
+    makeActive(7);
+    sequence.moveStages(1 << 7, 1);
+    std::vector<uint16_t> expected = {7, 1, 2, 3, 4, 5, 6, 0};
+    TEST_ASSERT_TRUE(expected == ids());
+    TEST_ASSERT_EQUAL(0, sequence.indexOfActiveStage());
+    assertNextStageFollowsActive();
+
+    sequence.moveStages(1 << 0, -1);
+    expected = {0, 1, 2, 3, 4, 5, 6, 7};
+    TEST_ASSERT_TRUE(expected == ids());
+    TEST_ASSERT_EQUAL(7, sequence.indexOfActiveStage());
+    TEST_ASSERT_EQUAL_UINT16(7, sequence.getActiveStage().id);
+}
+
+// The example in moveStages, where the stages that aren't moving
+// fill the gaps from the other side and it all goes round as one cycle
+void test_move_every_other_stage_round_a_cycle(void) {
+    sequence = Sequence(5);
+    for (size_t i = 0; i < sequence.stageCount(); i++) sequence.getStage(i).pulseCount = 1;
+    makeActive(3);
+
+    sequence.moveStages(0b10101, 1);
+    std::vector<uint16_t> expected = {4, 0, 3, 2, 1};
+    TEST_ASSERT_TRUE(expected == ids());
+    TEST_ASSERT_EQUAL(2, sequence.indexOfActiveStage());
+    TEST_ASSERT_EQUAL_UINT16(3, sequence.getActiveStage().id);
+    assertNextStageFollowsActive();
+}
+
+// Every moving stage goes one place, the rest keep their order round the
+// ring, and whichever stage was playing still is
+void test_random_moves_keep_the_active_stage(void) {
+    std::mt19937 rng(1);
+
+    for (uint32_t i = 0; i < 2000; i++) {
+        size_t stageCount = sequence.stageCount();
+        makeActive(rng() % stageCount);
+        uint16_t activeId = sequence.getActiveStage().id;
+        std::vector<uint16_t> before = ids();
+        uint16_t stagesToMove = rng() & ((1 << stageCount) - 1);
+        int direction = (rng() % 2) ? 1 : -1;
+
+        sequence.moveStages(stagesToMove, direction);
+        std::vector<uint16_t> after = ids();
+
+        std::vector<uint16_t> stayingBefore, stayingAfter;
+        for (size_t j = 0; j < stageCount; j++) {
+            if ((stagesToMove >> j) & 1) {
+                TEST_ASSERT_EQUAL_UINT16(before[j], after[(j + direction + stageCount) % stageCount]);
+            } else {
+                stayingBefore.push_back(before[j]);
+            }
+        }
+        for (size_t j = 0; j < stageCount; j++) {
+            bool isMoved = (stagesToMove >> ((j - direction + stageCount) % stageCount)) & 1;
+            if (!isMoved) stayingAfter.push_back(after[j]);
+        }
+
+        TEST_ASSERT_EQUAL(stayingBefore.size(), stayingAfter.size());
+        if (!stayingBefore.empty()) {
+            std::rotate(stayingAfter.begin(), std::find(stayingAfter.begin(), stayingAfter.end(), stayingBefore[0]), stayingAfter.end());
+            TEST_ASSERT_TRUE(stayingBefore == stayingAfter);
+        }
+        TEST_ASSERT_EQUAL_UINT16(activeId, sequence.getActiveStage().id);
+        assertNextStageFollowsActive();
+
+        // Now and then a different number of stages
+        if (i % 100 == 99) {
+            sequence = Sequence(1 + rng() % MAX_STAGES);
+            for (size_t j = 0; j < sequence.stageCount(); j++) sequence.getStage(j).pulseCount = 1;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_insert_before_the_active_stage_moves_it_along);
+    RUN_TEST(test_insert_at_the_active_stage_keeps_it_active);
+    RUN_TEST(test_insert_after_the_active_stage_leaves_it);
+    RUN_TEST(test_insert_into_a_full_sequence_does_nothing);
+    RUN_TEST(test_delete_before_the_active_stage_moves_it_back);
+    RUN_TEST(test_delete_the_active_stage);
+    RUN_TEST(test_delete_after_the_active_stage_leaves_it);
+    RUN_TEST(test_the_last_stage_cant_be_deleted);
+    RUN_TEST(test_move_one_stage_along);
+    RUN_TEST(test_moves_wrap_round);
+    RUN_TEST(test_move_every_other_stage_round_a_cycle);
+    RUN_TEST(test_random_moves_keep_the_active_stage);
+    return UNITY_END();
+}
@@ -0,0 +1,142 @@
+// Eases values at different frame rates and checks they all end up in the same place
+#include <unity.h>
+#include <math.h>
+#include "Tweens.hpp"
+
+static Tweens *tweens = nullptr; // Made fresh for each test, it's big
+
+// Steps tweens from fromMillis to toMillis every frameMillis
+static void run(Tweens &tweens, uint32_t fromMillis, uint32_t toMillis, uint32_t frameMillis) {
+    for (uint32_t millis = fromMillis + frameMillis; millis <= toMillis; millis += frameMillis) {
+        tweens.update(millis);
+    }
+}
+
+void setUp(void) {
+    delete tweens;
+    tweens = new Tweens();
+    tweens->update(0);
+}
+
+void tearDown(void) {}
+
+void test_a_tenth_of_the_way_every_16ms(void) {
+    float value = 0;
+    tweens->easeTo(&value, 100);
+
+    tweens->update(16);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10, value);
+    tweens->update(32);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 19, value);
+}
+
+void test_frame_rate_doesnt_change_the_path(void) {
+    // From 1000fps down to 10fps, all of them stepping on every 400ms. Checked
+    // while there's still far enough to go that none of them have snapped
+    const uint32_t frameMillis[] = {1, 8, 16, 40, 100};
+    Tweens *atRate[5];
+    float values[5];
+    Angle angles[5];
+
+    for (uint8_t i = 0; i < 5; i++) {
+        atRate[i] = new Tweens();
+        atRate[i]->update(0);
+        values[i] = -3;
+        angles[i] = Angle::fromDegrees(300);
+        atRate[i]->easeTo(&values[i], 5);
+        atRate[i]->easeTo(&angles[i], Angle::fromDegrees(60));
+    }
+
+    for (uint32_t millis = 0; millis < 800; millis += 400) {
+        for (uint8_t i = 0; i < 5; i++) {
+            run(*atRate[i], millis, millis + 400, frameMillis[i]);
+        }
+
+        float expected = 5 - 8 * powf(0.9f, (millis + 400) / 16.f);
+        for (uint8_t i = 0; i < 5; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(0.001f, expected, values[i]);
+            TEST_ASSERT_INT_WITHIN(2, 0, angles[0].deltaTo(angles[i]));
+        }
+        TEST_ASSERT_FALSE(atRate[4]->isAtRest());
+    }
+
+    for (uint8_t i = 0; i < 5; i++) {
+        delete atRate[i];
+    }
+}
+
+void test_arrives_exactly_and_rests(void) {
+    float value = 0;
+    tweens->easeTo(&value, 1.5f);
+    TEST_ASSERT_FALSE(tweens->isAtRest());
+
+    run(*tweens, 0, 2000, 16);
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, value);
+    TEST_ASSERT_TRUE(tweens->isAtRest());
+}
+
+void test_angles_go_the_short_way_round(void) {
+    Angle angle = Angle::fromDegrees(350);
+    tweens->easeTo(&angle, Angle::fromDegrees(30));
+
+    for (uint32_t millis = 16; millis <= 2000; millis += 16) {
+        tweens->update(millis);
+        float degrees = angle.toDegrees();
+        TEST_ASSERT_TRUE(degrees >= 349.9f || degrees <= 30.1f);
+    }
+    TEST_ASSERT_TRUE(angle == Angle::fromDegrees(30));
+}
+
+void test_long_gaps_only_ease_so_far(void) {
+    float value = 0;
+    tweens->easeTo(&value, 1);
+
+    tweens->update(5000);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1 - powf(0.9f, Tweens::MAX_STEP_MILLIS / 16.f), value);
+}
+
+void test_moving_the_target_carries_on_from_where_it_is(void) {
+    float value = 0;
+    tweens->easeTo(&value, 100);
+    tweens->update(16);
+
+    tweens->easeTo(&value, 0);
+    TEST_ASSERT_EQUAL_UINT8(1, tweens->getCount());
+    tweens->update(32);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 9, value);
+}
+
+void test_jumping_stops_the_easing(void) {
+    float value = 0;
+    tweens->easeTo(&value, 100);
+    tweens->update(16);
+
+    tweens->jumpTo(&value, -4);
+    TEST_ASSERT_TRUE(tweens->isAtRest());
+    tweens->update(32);
+    TEST_ASSERT_EQUAL_FLOAT(-4, value);
+}
+
+void test_values_past_the_last_slot_jump(void) {
+    float values[Tweens::MAX_TWEENS + 1] = {};
+    for (uint8_t i = 0; i <= Tweens::MAX_TWEENS; i++) {
+        tweens->easeTo(&values[i], 1);
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(Tweens::MAX_TWEENS, tweens->getCount());
+    TEST_ASSERT_EQUAL_FLOAT(0, values[0]);
+    TEST_ASSERT_EQUAL_FLOAT(1, values[Tweens::MAX_TWEENS]);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_a_tenth_of_the_way_every_16ms);
+    RUN_TEST(test_frame_rate_doesnt_change_the_path);
+    RUN_TEST(test_arrives_exactly_and_rests);
+    RUN_TEST(test_angles_go_the_short_way_round);
+    RUN_TEST(test_long_gaps_only_ease_so_far);
+    RUN_TEST(test_moving_the_target_carries_on_from_where_it_is);
+    RUN_TEST(test_jumping_stops_the_easing);
+    RUN_TEST(test_values_past_the_last_slot_jump);
+    return UNITY_END();
+}